@@ -0,0 +1,415 @@
+------------------------------------------------------------------------------
+--  This file is a part of the GRLIB VHDL IP LIBRARY
+--  Copyright (C) 2003 - 2008, Gaisler Research
+--  Copyright (C) 2008 - 2014, Aeroflex Gaisler
+--  Copyright (C) 2015 - 2023, Cobham Gaisler
+--  Copyright (C) 2023 - 2025, Frontgrade Gaisler
+--
+--  This program is free software; you can redistribute it and/or modify
+--  it under the terms of the GNU General Public License as published by
+--  the Free Software Foundation; version 2.
+--
+--  This program is distributed in the hope that it will be useful,
+--  but WITHOUT ANY WARRANTY; without even the implied warranty of
+--  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+--  GNU General Public License for more details.
+--
+--  You should have received a copy of the GNU General Public License
+--  along with this program; if not, write to the Free Software
+--  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+------------------------------------------------------------------------------
+-- Entity:      testbench
+-- File:        testbench.vhd
+-- Description: Test bench for the compressed trace records of ahbtrace_mmb.
+--              Drives single transfers, bursts, wait states and an error
+--              response on the traced bus, stops the trace while a record
+--              is open, and dumps the buffer as ahbtrace_dump() does. The
+--              transfers the decoder should find are written to expfile.
+------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+library grlib;
+use grlib.amba.all;
+use grlib.stdlib.all;
+library gaisler;
+use gaisler.misc.all;
+use std.textio.all;
+
+entity testbench is
+  generic (
+    clkperiod : integer := 20;
+    logfile   : string := "ahbtrace.log";   -- buffer dump
+    expfile   : string := "ahbtrace.exp"    -- expected decoder records
+  );
+end;
+
+architecture behav of testbench is
+
+constant KBYTES  : integer := 1;
+constant NLINES  : integer := KBYTES * 64;
+
+-- Registers, see software/systest/include/ahbtrace.h
+constant AHBTRACE_CTRL  : integer := 16#00#;
+constant AHBTRACE_INDEX : integer := 16#04#;
+constant AHBTRACE_TIMER : integer := 16#08#;
+constant AHBTRACE_BUF   : integer := 16#10000#;
+constant AHBTRACE_EN    : integer := 16#001#;
+constant AHBTRACE_CM    : integer := 16#400#;
+
+type int_vector is array (natural range <>) of integer;
+
+signal clk   : std_ulogic := '0';
+signal rst   : std_ulogic := '0';
+signal done  : boolean := false;
+
+signal rsi   : ahb_slv_in_type := ahbs_in_none;  -- register bus
+signal rdata : std_ulogic := '0';                -- register data phase
+signal ahbsi : ahb_slv_in_type;
+signal ahbso : ahb_slv_out_type;
+
+signal tahbsiv : ahb_slv_in_vector_type(0 to 0) := (others => ahbs_in_none);
+signal tahbmiv : ahb_mst_in_vector_type(0 to 0) := (others => ahbm_in_none);
+
+function hex(v : std_logic_vector) return string is
+  constant digit : string(1 to 16) := "0123456789abcdef";
+  constant x : std_logic_vector(v'length-1 downto 0) := v;
+  variable s : string(1 to v'length/4);
+begin
+  for i in s'range loop
+    s(i) := digit(conv_integer(x(x'left-4*i+4 downto x'left-4*i+1)) + 1);
+  end loop;
+  return s;
+end;
+
+begin
+
+  clk <= not clk after (clkperiod / 2) * 1 ns when not done else '0';
+
+  -- The register bus waits for the trace unit during its data phases
+  ahbsi_p : process(rsi, rdata, ahbso)
+  begin
+    ahbsi <= rsi;
+    if rdata = '1' then ahbsi.hready <= ahbso.hready; end if;
+  end process;
+
+  trace0 : ahbtrace_mmb
+    generic map (hindex => 0, kbytes => KBYTES, compress => 1)
+    port map (rst => rst, clk => clk, ahbsi => ahbsi, ahbso => ahbso,
+              tahbmiv => tahbmiv, tahbsiv => tahbsiv, astat => open);
+
+  stim : process
+
+  type beat_type is record
+    trans : std_logic_vector(1 downto 0);
+    mst   : integer;
+    write : std_ulogic;
+    addr  : integer;
+    size  : integer;
+    waits : integer;                    -- HREADY low cycles of the data phase
+    resp  : std_logic_vector(1 downto 0);
+  end record;
+
+  -- Expected record, SEQ beats are counted in the record of their burst
+  type rec_type is record
+    valid : boolean;
+    mst   : integer;
+    write : std_ulogic;
+    addr  : integer;
+    size  : integer;
+    beats : integer;
+    waits : integer;
+    resp  : std_logic_vector(1 downto 0);
+    tcyc  : integer;                    -- cycle the first beat completed
+  end record;
+
+  file logf : text open write_mode is logfile;
+  file expf : text open write_mode is expfile;
+
+  variable ncyc    : integer := 0;
+  variable t0      : integer := -1;
+  variable tracing : boolean := false;
+  variable dbeat   : beat_type := (HTRANS_IDLE, 0, '0', 0, 2, 0, HRESP_OKAY);
+  variable rec     : rec_type;
+  variable rd, rd0 : std_logic_vector(31 downto 0);
+  variable ctrl, index : std_logic_vector(31 downto 0);
+  variable w       : std_logic_vector(127 downto 0);
+  variable l, n, first, li : integer;
+  variable l0, k0  : integer;
+  variable ln      : line;
+
+  procedure cycle is
+  begin
+    wait until rising_edge(clk);
+    ncyc := ncyc + 1;
+  end;
+
+  procedure flush is
+    variable el : line;
+  begin
+    if rec.valid and tracing then
+      if t0 < 0 then t0 := rec.tcyc; end if;
+      write(el, integer'image(rec.tcyc - t0) & " mst " & integer'image(rec.mst) & " ");
+      if rec.write = '1' then write(el, string'("write")); else write(el, string'("read")); end if;
+      write(el, " " & hex(conv_std_logic_vector(rec.addr, 32)) &
+                " size " & integer'image(2 ** rec.size) &
+                " beats " & integer'image(rec.beats) & " waits ");
+      if rec.waits > 31 then write(el, string'("31"));
+      else write(el, integer'image(rec.waits)); end if;
+      if rec.resp = HRESP_ERROR then write(el, string'(" error"));
+      else write(el, string'(" okay")); end if;
+      writeline(expf, el);
+    end if;
+    rec.valid := false;
+  end;
+
+  -- Data phase of b completed at cycle t
+  procedure complete(b : beat_type; t : integer) is
+  begin
+    if not tracing then
+      null;
+    elsif b.trans = HTRANS_IDLE then
+      flush;
+    elsif b.trans = HTRANS_BUSY then
+      null;
+    elsif rec.valid and (b.trans = HTRANS_SEQ) and (b.mst = rec.mst) and (b.write = rec.write) and
+          (rec.beats < 16) and (b.resp = HRESP_OKAY) and (rec.resp = HRESP_OKAY)
+    then
+      rec.beats := rec.beats + 1;
+      rec.waits := rec.waits + b.waits;
+    else
+      flush;
+      rec := (true, b.mst, b.write, b.addr, b.size, 1, b.waits, b.resp, t);
+    end if;
+  end;
+
+  -- Completes the data phase of the previous transfer, the error response
+  -- takes the last wait state and the completing cycle
+  procedure finish is
+    variable t : integer;
+  begin
+    for i in 1 to dbeat.waits loop
+      tahbsiv(0).hready <= '0';
+      if (dbeat.resp /= HRESP_OKAY) and (i = dbeat.waits) then
+        tahbmiv(0).hresp <= dbeat.resp;
+      else
+        tahbmiv(0).hresp <= HRESP_OKAY;
+      end if;
+      cycle;
+    end loop;
+    tahbsiv(0).hready <= '1';
+    tahbmiv(0).hresp <= dbeat.resp;
+    t := ncyc;
+    cycle;
+    complete(dbeat, t);
+  end;
+
+  -- Puts a transfer in the address phase while the previous one completes
+  procedure phase(trans : std_logic_vector(1 downto 0); mst : integer; write : std_ulogic;
+                  addr, size : integer; burst : std_logic_vector(2 downto 0);
+                  lock : std_ulogic; waits : integer;
+                  resp : std_logic_vector(1 downto 0) := HRESP_OKAY) is
+  begin
+    tahbsiv(0).htrans <= trans;
+    tahbsiv(0).hmaster <= conv_std_logic_vector(mst, 4);
+    tahbsiv(0).hwrite <= write;
+    tahbsiv(0).haddr <= conv_std_logic_vector(addr, 32);
+    tahbsiv(0).hsize <= conv_std_logic_vector(size, 3);
+    tahbsiv(0).hburst <= burst;
+    tahbsiv(0).hmastlock <= lock;
+    finish;
+    dbeat := (trans, mst, write, addr, size, waits, resp);
+  end;
+
+  procedure idle(cycles : integer) is
+  begin
+    phase(HTRANS_IDLE, 0, '0', 0, 2, HBURST_SINGLE, '0', 0);
+    for i in 2 to cycles loop cycle; end loop;
+  end;
+
+  procedure single(mst : integer; write : std_ulogic; addr, size, waits : integer;
+                   lock : std_ulogic := '0';
+                   resp : std_logic_vector(1 downto 0) := HRESP_OKAY) is
+  begin
+    phase(HTRANS_NONSEQ, mst, write, addr, size, HBURST_SINGLE, lock, waits, resp);
+  end;
+
+  -- Word burst, waits are used in turn for the beats, busy > 0 puts a BUSY
+  -- cycle before beat busy
+  procedure burst(mst : integer; write : std_ulogic; addr, beats : integer;
+                  hburst : std_logic_vector(2 downto 0); waits : int_vector;
+                  busy : integer := 0) is
+  begin
+    for i in 0 to beats - 1 loop
+      if i = 0 then
+        phase(HTRANS_NONSEQ, mst, write, addr, 2, hburst, '0', waits(waits'left));
+      else
+        if i = busy then
+          phase(HTRANS_BUSY, mst, write, addr + 4*i, 2, hburst, '0', 0);
+        end if;
+        phase(HTRANS_SEQ, mst, write, addr + 4*i, 2, hburst, '0',
+              waits(waits'left + i mod waits'length));
+      end if;
+    end loop;
+  end;
+
+  procedure regacc(off : integer; write : std_ulogic; wdata : integer;
+                   rdv : out std_logic_vector(31 downto 0)) is
+  begin
+    rsi.hsel(0) <= '1';
+    rsi.haddr <= conv_std_logic_vector(off, 32);
+    rsi.hwrite <= write;
+    rsi.htrans <= HTRANS_NONSEQ;
+    rsi.hsize <= HSIZE_WORD;
+    cycle;
+    rsi.hsel(0) <= '0';
+    rsi.htrans <= HTRANS_IDLE;
+    rsi.hwdata <= ahbdrivedata(conv_std_logic_vector(wdata, 32));
+    rdata <= '1';
+    loop
+      cycle;
+      exit when ahbsi.hready = '1';
+    end loop;
+    rdv := ahbso.hrdata(31 downto 0);
+    rdata <= '0';
+  end;
+
+  -- Register write with a trace buffer read in the address phase of its
+  -- data phase
+  procedure regwrbuf(off, wdata, boff : integer; rdv : out std_logic_vector(31 downto 0)) is
+  begin
+    rsi.hsel(0) <= '1';
+    rsi.haddr <= conv_std_logic_vector(off, 32);
+    rsi.hwrite <= '1';
+    rsi.htrans <= HTRANS_NONSEQ;
+    rsi.hsize <= HSIZE_WORD;
+    cycle;
+    rsi.haddr <= conv_std_logic_vector(boff, 32);
+    rsi.hwrite <= '0';
+    rsi.hwdata <= ahbdrivedata(conv_std_logic_vector(wdata, 32));
+    rdata <= '1';
+    loop
+      cycle;
+      exit when ahbsi.hready = '1';
+    end loop;
+    rsi.hsel(0) <= '0';
+    rsi.htrans <= HTRANS_IDLE;
+    loop
+      cycle;
+      exit when ahbsi.hready = '1';
+    end loop;
+    rdv := ahbso.hrdata(31 downto 0);
+    rdata <= '0';
+  end;
+
+  procedure regwr(off, wdata : integer) is
+    variable tmp : std_logic_vector(31 downto 0);
+  begin
+    regacc(off, '1', wdata, tmp);
+  end;
+
+  procedure regrd(off : integer; rdv : out std_logic_vector(31 downto 0)) is
+  begin
+    regacc(off, '0', 0, rdv);
+  end;
+
+  begin
+    rec.valid := false;
+    rst <= '0';
+    for i in 1 to 4 loop cycle; end loop;
+    rst <= '1';
+    cycle;
+
+    -- ahbtrace_start() with compressed records
+    regwr(AHBTRACE_CTRL, AHBTRACE_CM);
+    regwr(AHBTRACE_INDEX, 0);
+    regwr(AHBTRACE_TIMER, 0);
+    regwr(AHBTRACE_CTRL, AHBTRACE_CM + AHBTRACE_EN);
+    tracing := true;
+    idle(4);
+
+    -- Back-to-back single transfers, one master and two alternating
+    for i in 0 to 3 loop
+      single(1, '0', 16#40000000# + 4*i, 2, 0);
+    end loop;
+    for i in 0 to 5 loop
+      single(2 + i mod 2, '1', 16#40001000# + 16#1000# * (i mod 2) + 8*i, 2, 1);
+    end loop;
+    idle(3);
+
+    -- Bursts with wait states, back-to-back bursts of one master, and a
+    -- BUSY cycle inside a burst
+    burst(1, '0', 16#40000100#, 4, HBURST_INCR4, (2, 0, 1, 0));
+    burst(2, '1', 16#40003000#, 4, HBURST_INCR4, (0 => 0));
+    burst(2, '1', 16#40003010#, 4, HBURST_INCR4, (0 => 1));
+    burst(3, '0', 16#40003800#, 8, HBURST_INCR8, (0, 0, 3, 0), 3);
+    -- 20 beats take two records of at most 16 beats
+    burst(1, '0', 16#40004000#, 20, HBURST_INCR, (0 => 1));
+    -- Time deltas above the short and the long record fields
+    idle(100);
+    single(0, '0', 16#40000003#, 0, 0);
+    idle(2000);
+    single(0, '1', 16#40000002#, 1, 2);
+    -- Address delta above the short record field
+    single(1, '0', 16#48000000#, 2, 0);
+    -- Wait states above the record fields
+    burst(2, '0', 16#40005100#, 4, HBURST_INCR4, (0 => 10));
+    -- Error response
+    single(3, '1', 16#40005000#, 2, 2, resp => HRESP_ERROR);
+    idle(2);
+    single(1, '0', 16#40005200#, 2, 0, '1');
+    single(1, '0', 16#40005204#, 2, 0);
+    -- Enough short records to pass line 16
+    for i in 0 to 79 loop
+      single(0, '0', 16#40006000# + 4*i, 2, 0);
+    end loop;
+
+    -- Stop tracing with the record of the burst open, the next transfer
+    -- completes after the trace unit was disabled. The buffer is read right
+    -- behind the control register write, while the open record is stored
+    burst(1, '0', 16#40007000#, 4, HBURST_INCR4, (0 => 0));
+    single(2, '0', 16#40007100#, 2, 0);
+    tahbsiv(0).htrans <= HTRANS_IDLE;
+    tahbsiv(0).hready <= '0';
+    regrd(AHBTRACE_INDEX, index);
+    l0 := conv_integer(index(31 downto 4)) mod NLINES;
+    k0 := conv_integer(index(3 downto 2));
+    regwrbuf(AHBTRACE_CTRL, AHBTRACE_CM, AHBTRACE_BUF + l0 * 16 + k0 * 4, rd0);
+    flush;
+    tracing := false;
+    dbeat.waits := 2;
+    idle(2);
+    burst(3, '1', 16#40007200#, 4, HBURST_INCR4, (0 => 0));
+    idle(4);
+
+    -- ahbtrace_dump()
+    regrd(AHBTRACE_CTRL, ctrl);
+    regrd(AHBTRACE_INDEX, index);
+    l := (conv_integer(index(31 downto 4))) mod NLINES;
+    if index(3 downto 2) /= "00" then l := l + 1; end if;
+    if ctrl(11) = '1' then n := NLINES; else n := l; end if;
+    first := (l - n) mod NLINES;
+    write(ln, "ahbtrace ctrl " & hex(ctrl) & " index " & hex(index) & " lines " & integer'image(n));
+    writeline(logf, ln);
+    for i in 0 to n - 1 loop
+      li := (first + i) mod NLINES;
+      for k in 0 to 3 loop
+        regrd(AHBTRACE_BUF + li * 16 + k * 4, rd);
+        w(127 - 32*k downto 96 - 32*k) := rd;
+        assert (li /= l0) or (k /= k0) or (rd = rd0)
+          report "buffer read behind the control register write returned " & hex(rd0)
+          severity failure;
+      end loop;
+      write(ln, "l " & integer'image(li) & " " & hex(w(127 downto 96)) & " " & hex(w(95 downto 64)) &
+                " " & hex(w(63 downto 32)) & " " & hex(w(31 downto 0)));
+      writeline(logf, ln);
+    end loop;
+    write(ln, string'("ahbtrace end"));
+    writeline(logf, ln);
+
+    assert false report "ahbtrace dump done, " & integer'image(n) & " lines" severity note;
+    done <= true;
+    wait;
+  end process;
+
+end;
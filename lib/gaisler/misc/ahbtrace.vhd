@@ -47,7 +47,8 @@ entity ahbtrace is
     ahbfilt  : integer := 0;
     scantest : integer range 0 to 1 := 0;
     exttimer : integer range 0 to 1 := 0;
-    exten    : integer range 0 to 1 := 0);
+    exten    : integer range 0 to 1 := 0;
+    compress : integer range 0 to 1 := 0);
   port (
     rst      : in  std_ulogic;
     clk      : in  std_ulogic;
@@ -77,7 +78,8 @@ begin
       ahbfilt  => ahbfilt,
       scantest => scantest,
       exttimer => exttimer,
-      exten    => exten)
+      exten    => exten,
+      compress => compress)
     port map(
       rst      => rst,
       clk      => clk,
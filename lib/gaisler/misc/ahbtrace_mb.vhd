@@ -48,7 +48,8 @@ entity ahbtrace_mb is
     ahbfilt  : integer := 0;
     scantest : integer range 0 to 1 := 0;
     exttimer : integer range 0 to 1 := 0;
-    exten    : integer range 0 to 1 := 0);
+    exten    : integer range 0 to 1 := 0;
+    compress : integer range 0 to 1 := 0);
   port (
     rst      : in  std_ulogic;
     clk      : in  std_ulogic;
@@ -87,7 +88,8 @@ begin
       ntrace   => 1,
       scantest => scantest,
       exttimer => exttimer,
-      exten    => exten)
+      exten    => exten,
+      compress => compress)
     port map(
       rst      => rst,
       clk      => clk,
@@ -48,7 +48,8 @@ entity ahbtrace_mmb is
     ntrace   : integer range 1 to 8 := 1;
     scantest : integer range 0 to 1 := 0; 
     exttimer : integer range 0 to 1 := 0;
-    exten    : integer range 0 to 1 := 0);
+    exten    : integer range 0 to 1 := 0;
+    compress : integer range 0 to 1 := 0);
   port (
     rst     : in  std_ulogic;
     clk     : in  std_ulogic;
@@ -69,6 +70,7 @@ constant TBUFABITS : integer := log2(kbytes mod 16#10000#) + 6 - 10*(kbytes/16#1
 constant TIMEBITS  : integer := 32 - exttimer;
 constant FILTEN    : boolean := ahbfilt /= 0;
 constant PERFEN    : boolean := (ahbfilt > 1);
+constant COMPEN    : boolean := compress /= 0;
 
 constant hconfig : ahb_config_type := (
   0 => ahb_device_reg ( VENDOR_GAISLER, GAISLER_AHBTRACE, 0, 0, irq),
@@ -148,6 +150,52 @@ type bregtype is record
   bsel          : std_logic_vector(log2x(ntrace)-1 downto 0);
 end record;
 
+-- Compressed trace records (compress generic, control register bit 10)
+--
+-- Records are one to three 32-bit words packed into the 128-bit buffer
+-- lines, word 0 at the lowest address. A record never crosses a line, unused
+-- words at the end of a line are zero. SEQ beats continuing the burst of the
+-- previous transfer are counted in its record instead of being stored, and
+-- no data is stored. Time is the cycle the first beat completed, as a delta
+-- to the previous record. Addresses of short records are a delta to the
+-- previous record of the same master. The first record in a line with index
+-- a multiple of 16, and the first after the control or index register is
+-- written, is a time record and restarts the address deltas, so decoding can
+-- start at any such line when the buffer has wrapped. The open record is
+-- stored when tracing stops.
+--
+--  31:30  29:26  25  short       long / time
+--  01     mst    w   24:23 size  -
+--                    22:20 beats-1, 19:16 waits, 15:10 dt, 9:0 addr delta
+--  10/11  mst    w   24:22 size, 21:20 hresp, 19 lock, 18:15 beats-1,
+--                    14:10 waits, 9:0 dt (0 in time records)
+--                    word 1: address, word 2 (time record): time
+--
+-- waits are the cycles with HREADY low during the data phases of the record.
+
+type caddr_type is array (0 to 15) of std_logic_vector(31 downto 0);
+
+type cregtype is record
+  cm            : std_ulogic;         -- compressed records
+  wrap          : std_ulogic;         -- buffer index wrapped
+  sync          : std_ulogic;         -- next new line starts with a time record
+  cnt           : std_logic_vector(1 downto 0);   -- words used in line aindex
+  waits         : std_logic_vector(4 downto 0);   -- waits of the data phase
+  lastt         : std_logic_vector(31 downto 0);  -- time of the last record
+  pend          : std_ulogic;         -- open record
+  pmaster       : std_logic_vector(3 downto 0);
+  pwrite        : std_ulogic;
+  psize         : std_logic_vector(2 downto 0);
+  presp         : std_logic_vector(1 downto 0);
+  plock         : std_ulogic;
+  pbeats        : std_logic_vector(3 downto 0);   -- beats - 1
+  pwaits        : std_logic_vector(4 downto 0);
+  paddr         : std_logic_vector(31 downto 0);
+  ptime         : std_logic_vector(31 downto 0);
+  laddr         : caddr_type;         -- last address per master
+  lvalid        : std_logic_vector(0 to 15);
+end record;
+
 function ahb_filt_hit (
   r     : regtype;
   rf    : fregtype;
@@ -212,10 +260,11 @@ signal r, rin : regtype;
 signal rf, rfin : fregtype;
 signal rb, rbin : bregtype;
 signal pr, prin : pregtype;
+signal cr, crin : cregtype;
 
 begin
 
-  ctrl : process(rst, ahbsi, tahbmiv, tahbsiv, r, rf, rb, tbo, pr, timer, resen, trace_en)
+  ctrl : process(rst, ahbsi, tahbmiv, tahbsiv, r, rf, rb, tbo, pr, cr, timer, resen, trace_en)
   variable v : regtype;
   variable vabufi : tracebuf_in_type;
   variable regsd : std_logic_vector(31 downto 0);   -- data from registers
@@ -232,6 +281,17 @@ begin
   variable tbaddr  : std_logic_vector(3 downto 2);
   variable timeval : std_logic_vector(31 downto 0);
   variable pv : pregtype;
+  variable vc : cregtype;
+  variable cemit : boolean;
+  variable cnew : boolean;
+  variable cword : std_logic_vector(95 downto 0);
+  variable cline : std_logic_vector(127 downto 0);
+  variable clen : integer range 1 to 3;
+  variable cpos : integer range 0 to 3;
+  variable cdt, cda : std_logic_vector(31 downto 0);
+  variable cidx : std_logic_vector(TBUFABITS - 1 downto 0);
+  variable csum : std_logic_vector(5 downto 0);
+  variable cmst : integer range 0 to 15;
   begin
 
     v := r; regsd := (others => '0'); vabufi.enable := '0'; 
@@ -240,7 +300,7 @@ begin
     v.hready := r.hready2; v.hready2 := r.hready3; v.hready3 := '0'; 
     hwdata := ahbreadword(ahbsi.hwdata, r.haddr(4 downto 2));
     hirq := (others => '0'); hirq(irq) := r.bhit;
-    vf := rf; vb := rb; pv := pr;
+    vf := rf; vb := rb; pv := pr; vc := cr;
     if ntrace = 1 then
       tahbmi := tahbmiv(0); tahbsi := tahbsiv(0);
     else
@@ -310,7 +370,7 @@ begin
 
 -- write trace buffer
 
-      if r.enable = '1' and trace_en = '1' then
+      if r.enable = '1' and trace_en = '1' and cr.cm = '0' then
         if (r.ahbactive and tahbsi.hready) = '1' then
           if not (FILTEN and ahb_filt_hit(r, rf, tahbmi.hresp)) then
             v.aindex := aindex;
@@ -319,6 +379,105 @@ begin
         end if;
       end if;
 
+-- compressed trace records
+
+    if COMPEN and cr.cm = '1' then
+      cemit := false;
+      if (r.ahbactive and not tahbsi.hready) = '1' then
+        if cr.waits /= "11111" then vc.waits := cr.waits + 1; end if;
+      end if;
+      if r.enable = '0' then
+        -- store the open record when tracing stops, after any trace buffer
+        -- access on the register bus as that drives the buffer as well
+        if (r.hsel and r.regacc and not r.hready) = '0' then
+          cemit := cr.pend = '1'; vc.pend := '0';
+        end if;
+      elsif trace_en = '0' then
+        null;
+      elsif (r.ahbactive and tahbsi.hready) = '1' then
+        vc.waits := (others => '0');
+        if not (FILTEN and ahb_filt_hit(r, rf, tahbmi.hresp)) then
+          if (cr.pend = '1') and (r.thtrans = HTRANS_SEQ) and (r.thmaster = cr.pmaster) and
+             (r.thwrite = cr.pwrite) and (cr.pbeats /= "1111") and
+             (tahbmi.hresp = HRESP_OKAY) and (cr.presp = HRESP_OKAY)
+          then
+            vc.pbeats := cr.pbeats + 1;
+            csum := ('0' & cr.pwaits) + ('0' & cr.waits);
+            if csum(5) = '1' then vc.pwaits := (others => '1');
+            else vc.pwaits := csum(4 downto 0); end if;
+          else
+            cemit := cr.pend = '1';
+            vc.pend := '1'; vc.pmaster := r.thmaster; vc.pwrite := r.thwrite;
+            vc.psize := r.thsize; vc.presp := tahbmi.hresp; vc.plock := r.thmastlock;
+            vc.pbeats := (others => '0'); vc.pwaits := cr.waits;
+            vc.paddr := r.thaddr; vc.ptime := timeval;
+          end if;
+        end if;
+      elsif (tahbsi.hready = '1') and (r.thtrans = HTRANS_IDLE) then
+        cemit := cr.pend = '1'; vc.pend := '0';
+      end if;
+
+      if cemit then
+        cmst := conv_integer(cr.pmaster);
+        cdt := cr.ptime - cr.lastt;
+        cda := cr.paddr - cr.laddr(cmst);
+        cword := (others => '0');
+        if (cr.lvalid(cmst) = '1') and
+           ((cda(31 downto 9) = zero32(31 downto 9)) or (cda(31 downto 9) = one32(31 downto 9))) and
+           (cr.psize(2) = '0') and (cr.presp = HRESP_OKAY) and (cr.plock = '0') and
+           (cr.pbeats(3) = '0') and (cr.pwaits(4) = '0') and (cdt(31 downto 6) = zero32(31 downto 6))
+        then
+          clen := 1;
+          cword(95 downto 64) := "01" & cr.pmaster & cr.pwrite & cr.psize(1 downto 0) &
+                                 cr.pbeats(2 downto 0) & cr.pwaits(3 downto 0) &
+                                 cdt(5 downto 0) & cda(9 downto 0);
+        elsif cdt(31 downto 10) = zero32(31 downto 10) then
+          clen := 2;
+        else
+          clen := 3;
+        end if;
+        cidx := r.aindex; cpos := conv_integer(cr.cnt); cnew := cr.cnt = "00";
+        if cpos + clen > 4 then
+          cidx := r.aindex + 1; cpos := 0; cnew := true;
+        end if;
+        if cnew and ((cidx(3 downto 0) = "0000") or (cr.sync = '1')) then
+          clen := 3; vc.sync := '0'; vc.lvalid := (others => '0');
+        end if;
+        if clen /= 1 then
+          cword(95 downto 64) := '1' & conv_std_logic(clen = 3) & cr.pmaster & cr.pwrite & cr.psize &
+                                 cr.presp & cr.plock & cr.pbeats & cr.pwaits & cdt(9 downto 0);
+          if clen = 3 then cword(73 downto 64) := (others => '0'); end if;
+          cword(63 downto 32) := cr.paddr;
+          cword(31 downto 0) := cr.ptime;
+        end if;
+        cline := (others => '0');
+        if cnew then vabufi.write(3 downto 0) := "1111"; end if;
+        for k in 0 to 3 loop
+          for j in 0 to 2 loop
+            if (k - j = cpos) and (j < clen) then
+              cline(127-32*k downto 96-32*k) := cword(95-32*j downto 64-32*j);
+              vabufi.write(3-k) := '1';
+            end if;
+          end loop;
+        end loop;
+        vabufi.addr(TBUFABITS-1 downto 0) := cidx;
+        vabufi.data(127 downto 0) := cline;
+        vabufi.enable := '1';
+        if cpos + clen = 4 then
+          v.aindex := cidx + 1; vc.cnt := "00";
+          if cidx = one32(TBUFABITS-1 downto 0) then vc.wrap := '1'; end if;
+        else
+          v.aindex := cidx; vc.cnt := conv_std_logic_vector(cpos + clen, 2);
+          if cidx = zero32(TBUFABITS-1 downto 0) and r.aindex /= zero32(TBUFABITS-1 downto 0) then
+            vc.wrap := '1';
+          end if;
+        end if;
+        vc.lastt := cr.ptime;
+        vc.laddr(cmst) := cr.paddr;
+        vc.lvalid(cmst) := '1';
+      end if;
+    end if;
+
 -- trace buffer delay counter handling
 
     if (r.dcnten = '1') and (r.ahbactive and tahbsi.hready) = '1' then
@@ -425,6 +584,10 @@ begin
             regsd(log2x(ntrace)+11 downto 12) := rb.bsel;
           end if;
           regsd(7 downto 6) := conv_std_logic_vector(log2(bwidth/32), 2);
+          if COMPEN then
+            regsd(11) := cr.wrap;
+            regsd(10) := cr.cm;
+          end if;
           if FILTEN then
             regsd(9) := rf.lerr;
             regsd(8) := rf.pf;
@@ -447,13 +610,22 @@ begin
               vf.fr   := ahbsi.hwdata(3);
               vf.fw   := ahbsi.hwdata(2);
             end if;
+            if COMPEN then
+              vc.cm := ahbsi.hwdata(10);
+              vc.sync := '1';
+            end if;
             v.dcnten := ahbsi.hwdata(1);
             v.enable := ahbsi.hwdata(0);
           end if;
         when "001" =>
             regsd((TBUFABITS - 1 + 4) downto 4) := r.aindex;
+            if COMPEN then regsd(3 downto 2) := cr.cnt; end if;
             if r.hwrite = '1' then
               v.aindex := ahbsi.hwdata((TBUFABITS- 1) downto 0); 
+              if COMPEN then
+                vc.cnt := "00"; vc.wrap := '0';
+                vc.sync := '1'; vc.pend := '0';
+              end if;
             end if;
         when "010" =>
           regsd := timeval;
@@ -591,12 +763,16 @@ begin
         pv.split := '0'; pv.splmst := (others => '0');
       end if;
       if ntrace /= 1 then vb.bsel := (others => '0'); end if;
+      if COMPEN then
+        vc.cm := '0'; vc.wrap := '0'; vc.sync := '1'; vc.pend := '0';
+        vc.cnt := "00"; vc.waits := (others => '0'); vc.lvalid := (others => '0');
+      end if;
     end if;
 
     if PERFEN then astat <= pr.stat; else astat <= amba_stat_none; end if;
 
     tbi <= vabufi;
-    rin <= v; rfin <= vf; rbin <= vb; prin <= pv;
+    rin <= v; rfin <= vf; rbin <= vb; prin <= pv; crin <= vc;
 
     ahbso.hconfig <= hconfig;
     ahbso.hirq    <= hirq;
@@ -649,6 +825,30 @@ begin
   nobregs : if ntrace = 1 generate
     rb.bsel <= (others => '0');
   end generate;
+  cregs : if COMPEN generate
+    regs : process(clk)
+    begin if rising_edge(clk) then cr <= crin; end if; end process;
+  end generate;
+  nocregs : if not COMPEN generate
+    cr.cm      <= '0';
+    cr.wrap    <= '0';
+    cr.sync    <= '0';
+    cr.cnt     <= (others => '0');
+    cr.waits   <= (others => '0');
+    cr.lastt   <= (others => '0');
+    cr.pend    <= '0';
+    cr.pmaster <= (others => '0');
+    cr.pwrite  <= '0';
+    cr.psize   <= (others => '0');
+    cr.presp   <= (others => '0');
+    cr.plock   <= '0';
+    cr.pbeats  <= (others => '0');
+    cr.pwaits  <= (others => '0');
+    cr.paddr   <= (others => '0');
+    cr.ptime   <= (others => '0');
+    cr.laddr   <= (others => (others => '0'));
+    cr.lvalid  <= (others => '0');
+  end generate;
   
   enable <= tbi.enable & tbi.enable;
   mem32 : for i in 0 to 1 generate
@@ -248,7 +248,8 @@ package misc is
     ahbfilt  : integer := 0;
     scantest : integer range 0 to 1 := 0;
     exttimer : integer range 0 to 1 := 0;
-    exten    : integer range 0 to 1 := 0);
+    exten    : integer range 0 to 1 := 0;
+    compress : integer range 0 to 1 := 0);
   port (
     rst      : in  std_ulogic;
     clk      : in  std_ulogic;
@@ -274,7 +275,8 @@ package misc is
     ahbfilt  : integer := 0;
     scantest : integer range 0 to 1 := 0;
     exttimer : integer range 0 to 1 := 0;
-    exten    : integer range 0 to 1 := 0);
+    exten    : integer range 0 to 1 := 0;
+    compress : integer range 0 to 1 := 0);
   port (
     rst      : in  std_ulogic;
     clk      : in  std_ulogic;
@@ -302,7 +304,8 @@ package misc is
     ntrace   : integer range 1 to 8 := 1;
     scantest : integer range 0 to 1 := 0;
     exttimer : integer range 0 to 1 := 0;
-    exten    : integer range 0 to 1 := 0);
+    exten    : integer range 0 to 1 := 0;
+    compress : integer range 0 to 1 := 0);
   port (
     rst      : in  std_ulogic;
     clk      : in  std_ulogic;
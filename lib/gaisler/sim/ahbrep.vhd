@@ -88,6 +88,7 @@ begin
 
   log : process(clk, ahbsi )
   variable errno, errcnt, subtest, vendorid, deviceid : integer;
+  variable benchid, benchmin : integer;
   variable addr : std_logic_vector(21 downto 2);
   variable hwdata : std_logic_vector(31 downto 0);
   variable v : reg_type;
@@ -148,6 +149,13 @@ begin
       when "000111" =>
         vendorid := 0; deviceid := 0;
         print ("Basic memory test");
+      when "001000" =>
+        benchid := conv_integer(hwdata(15 downto 0));
+      when "001001" =>
+        benchmin := conv_integer(hwdata(30 downto 0));
+      when "001010" =>
+        grlib.testlib.print("Benchmark " & tost(benchid) & ": min " & tost(benchmin) &
+                            " median " & tost(conv_integer(hwdata(30 downto 0))) & " cycles");
       when others =>
       end case;
     end if;
@@ -92,6 +92,7 @@ begin
     variable bl: integer;
 
     variable vendorid,deviceid,errno,subtest,errcnt: integer := 0;
+    variable benchid,benchmin: integer := 0;
   begin
     wait until rising_edge(clk);
     po := axiso;
@@ -174,6 +175,13 @@ begin
             when "000111" =>
               vendorid := 0; deviceid := 0;
               print ("Basic memory test");
+            when "001000" =>
+              benchid := conv_integer(hwdata(15 downto 0));
+            when "001001" =>
+              benchmin := conv_integer(hwdata(30 downto 0));
+            when "001010" =>
+              grlib.testlib.print("Benchmark " & tost(benchid) & ": min " & tost(benchmin) &
+                                  " median " & tost(conv_integer(hwdata(30 downto 0))) & " cycles");
             when others =>
           end case;
         end if;
@@ -0,0 +1,120 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* Changelog */
+/* 2026-10-18: GRDMAC memcpy service test */
+
+/* Calibrates the CPU/DMA threshold of the service, checks copies and fills
+ * of all sizes around it, and compares CPU memcpy with DMA copies while the
+ * CPU keeps doing other work. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "grdmac_dma.h"
+
+#define GRDMAC_ADDR 0x80000f00
+
+/* Largest copy of the calibration and size of the bulk copies */
+#define CAL_MAX (64*1024)
+#define BULK_SIZE (1024*1024)
+#define BULK_RUNS 8
+
+static struct dma_service dma;
+
+/* Stand-in for application work done while the GRDMAC copies */
+static volatile unsigned int work;
+
+static double elapsed(clock_t t)
+{
+    return (double)(clock() - t) / CLOCKS_PER_SEC;
+}
+
+static int check(unsigned char *dst, unsigned char *src, unsigned int len)
+{
+    unsigned int i;
+
+    for (i = 0; i < len; i++) {
+        if (dst[i] != src[i]) {
+            printf("Data error at %u of %u bytes\n", i, len);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    unsigned char *src, *dst;
+    unsigned int len, i, iter;
+    dma_req_t r;
+    double tcpu, tdma;
+    clock_t t;
+    int fail = 0;
+
+    src = malloc(BULK_SIZE);
+    dst = malloc(BULK_SIZE);
+    if (src == NULL || dst == NULL || dma_init(&dma, (struct grdmac_regs *)GRDMAC_ADDR) != 0) {
+        printf("Allocation failed\n");
+        return 1;
+    }
+    printf("GRDMAC with %d channels\n", dma.nch);
+    printf("Threshold: %u bytes\n", dma_calibrate(&dma, src, CAL_MAX));
+
+    for (i = 0; i < BULK_SIZE; i++) {
+        src[i] = i * 13 + (i >> 10);
+    }
+
+    /* Copies spanning several descriptors, channels and vectors */
+    for (len = 4; len <= BULK_SIZE; len *= 4) {
+        memset(dst, 0, len);
+        dma_wait(&dma, dma_memcpy_async(&dma, dst, src, len));
+        fail += check(dst, src, len);
+    }
+    r = 0;
+    for (i = 0; i < 2 * GRDMAC_MAX_CH; i++) {
+        r = dma_memcpy_async(&dma, dst + i * 4096, src + i * 4096, 4096);
+    }
+    dma_wait(&dma, r);
+    fail += check(dst, src, 2 * GRDMAC_MAX_CH * 4096);
+    dma_wait(&dma, dma_memset_async(&dma, dst, 0xA5, BULK_SIZE));
+    for (i = 0; i < BULK_SIZE && !fail; i++) {
+        if (dst[i] != 0xA5) {
+            printf("Fill error at %u\n", i);
+            fail++;
+        }
+    }
+
+    t = clock();
+    for (i = 0; i < BULK_RUNS; i++) {
+        memcpy(dst, src, BULK_SIZE);
+    }
+    tcpu = elapsed(t);
+
+    iter = 0;
+    t = clock();
+    for (i = 0; i < BULK_RUNS; i++) {
+        r = dma_memcpy_async(&dma, dst, src, BULK_SIZE);
+        while (dma_done(&dma, r) == 0) {
+            work++;
+            iter++;
+        }
+    }
+    tdma = elapsed(t);
+
+    printf("CPU memcpy: %8.2f MB/s\n", BULK_SIZE * (double)BULK_RUNS / (tcpu * 1024 * 1024));
+    printf("DMA memcpy: %8.2f MB/s, %u work iterations done meanwhile\n",
+           BULK_SIZE * (double)BULK_RUNS / (tdma * 1024 * 1024), iter);
+    printf("%u DMA errors, %d data errors\n", dma.errors, fail);
+    return fail != 0 || dma.errors != 0;
+}
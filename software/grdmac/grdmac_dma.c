@@ -0,0 +1,278 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "grdmac_dma.h"
+
+/* Repetitions of each calibration measurement */
+#define DMA_CAL_RUNS 16
+
+static inline uint32_t dma_addr(const volatile void *p)
+{
+    return (uint32_t)(uintptr_t)p;
+}
+
+/* Without bus snooping the data cache may hold stale copies of what the
+ * GRDMAC wrote */
+static inline void dma_dcache_flush(void)
+{
+#if defined(DMA_NOSNOOP) && !defined(__riscv)
+    asm volatile ("sta %%g0, [%%g0] 0x11" : : : "memory");
+#endif
+}
+
+static void dma_vector_clear(struct dma_vector *v)
+{
+    v->nch = 0;
+    v->ndesc = 0;
+    v->split = 0;
+}
+
+int dma_init(struct dma_service *s, struct grdmac_regs *regs)
+{
+    uintptr_t mem;
+    int i;
+
+    /* The channel vector pointer has 128 byte granularity */
+    s->mem = malloc(DMA_VECTORS * sizeof(struct dma_vector) + 127);
+    if (s->mem == NULL) {
+        return -1;
+    }
+    mem = ((uintptr_t)s->mem + 127) & ~(uintptr_t)127;
+    s->vec = (struct dma_vector *)mem;
+    for (i = 0; i < DMA_VECTORS; i++) {
+        dma_vector_clear(&s->vec[i]);
+    }
+    s->regs = regs;
+    s->nch = ((regs->capability & GRDMAC_CAP_NCH) >> GRDMAC_CAP_NCH_BIT) + 1;
+    s->running = -1;
+    s->filling = 0;
+    s->issued = 0;
+    s->done = 0;
+    s->threshold = 0;
+    s->errors = 0;
+    s->dma_bytes = 0;
+    s->cpu_bytes = 0;
+    regs->control = GRDMAC_CTRL_RST;
+    regs->irq_mask = 0;
+    return 0;
+}
+
+static void dma_launch(struct dma_service *s, int i)
+{
+    struct grdmac_regs *regs = s->regs;
+
+    asm volatile ("" : : : "memory");
+    regs->control = GRDMAC_CTRL_RST;
+    regs->error = 0xFFFFFFFF;
+    regs->cvp = dma_addr(s->vec[i].cvp);
+    regs->control = GRDMAC_CTRL_EN | (((1 << s->vec[i].nch) - 1) << GRDMAC_CTRL_CHEN);
+    s->running = i;
+    s->filling = (i + 1) % DMA_VECTORS;
+}
+
+int dma_poll(struct dma_service *s)
+{
+    struct dma_vector *v;
+    uint32_t mask;
+
+    if (s->running >= 0) {
+        v = &s->vec[s->running];
+        mask = (1 << v->nch) - 1;
+        if (s->regs->error & GRDMAC_ERR_ERR) {
+            /* The vector is abandoned, its requests fail */
+            s->fail_first[s->errors % DMA_FAILS] = v->first;
+            s->fail_last[s->errors % DMA_FAILS] = v->last;
+            s->errors++;
+        } else if ((s->regs->status & mask) != mask) {
+            return 0;
+        }
+        /* A request continuing in the next vector completes with it */
+        s->done = v->split ? v->last - 1 : v->last;
+        dma_vector_clear(v);
+        s->running = -1;
+        dma_dcache_flush();
+    }
+    if (s->vec[s->filling].nch > 0) {
+        dma_launch(s, s->filling);
+        return 0;
+    }
+    return 1;
+}
+
+/* Adds one channel of at most what fits in the filling vector for request
+ * t, returns the number of bytes queued */
+static unsigned int dma_queue(struct dma_service *s, uint32_t dst, uint32_t src,
+                              unsigned int len, int fill, dma_req_t t)
+{
+    struct dma_vector *v;
+    struct grdmac_desc *m, *b;
+    unsigned int n, queued;
+    int ch, first;
+
+    /* Wait for a vector with a free channel and descriptor */
+    while (1) {
+        v = &s->vec[s->filling];
+        if (v->nch < s->nch && v->ndesc < DMA_VEC_DESC) {
+            break;
+        }
+        dma_poll(s);
+    }
+
+    ch = v->nch++;
+    if (ch == 0) {
+        v->first = t;
+    }
+    first = v->ndesc;
+    if (fill) {
+        v->pattern[ch] = src;
+        src = dma_addr(&v->pattern[ch]);
+    }
+    queued = 0;
+    while (len > 0 && v->ndesc < DMA_VEC_DESC) {
+        n = len > DMA_CHUNK ? DMA_CHUNK : len;
+        m = &v->m2b[v->ndesc];
+        b = &v->b2m[v->ndesc];
+        m->addr = src;
+        m->status = 0;
+        m->ctrl = (n << GRDMAC_DESC_SIZE) | (fill ? GRDMAC_DESC_FIXED : 0) | GRDMAC_DESC_EN;
+        b->addr = dst;
+        b->status = 0;
+        b->ctrl = (n << GRDMAC_DESC_SIZE) | GRDMAC_DESC_EN;
+        if (v->ndesc > first) {
+            v->m2b[v->ndesc - 1].next = dma_addr(m);
+            v->b2m[v->ndesc - 1].next = dma_addr(b);
+        }
+        m->next = 0;
+        b->next = 0;
+        v->ndesc++;
+        if (!fill) {
+            src += n;
+        }
+        dst += n;
+        len -= n;
+        queued += n;
+    }
+    v->cvp[2*ch] = dma_addr(&v->m2b[first]);
+    v->cvp[2*ch + 1] = dma_addr(&v->b2m[first]);
+    v->last = t;
+    v->split = len > 0;
+    s->dma_bytes += queued;
+    return queued;
+}
+
+static dma_req_t dma_request(struct dma_service *s, uint32_t dst, uint32_t src,
+                             unsigned int len, int fill)
+{
+    unsigned int n;
+    dma_req_t t;
+
+    t = ++s->issued;
+    if (t == DMA_REQ_CPU) {
+        t = ++s->issued;
+    }
+    while (len > 0) {
+        n = dma_queue(s, dst, src, len, fill, t);
+        dst += n;
+        if (!fill) {
+            src += n;
+        }
+        len -= n;
+    }
+    /* Start at once if the GRDMAC is idle */
+    if (s->running < 0) {
+        dma_poll(s);
+    }
+    return t;
+}
+
+dma_req_t dma_memcpy_async(struct dma_service *s, void *dst, const void *src, unsigned int len)
+{
+    if (len < s->threshold || ((uintptr_t)dst & 3) || ((uintptr_t)src & 3)) {
+        memcpy(dst, src, len);
+        s->cpu_bytes += len;
+        return DMA_REQ_CPU;
+    }
+    return dma_request(s, dma_addr(dst), dma_addr(src), len, 0);
+}
+
+dma_req_t dma_memset_async(struct dma_service *s, void *dst, int c, unsigned int len)
+{
+    if (len < s->threshold || ((uintptr_t)dst & 3) || (len & 3)) {
+        memset(dst, c, len);
+        s->cpu_bytes += len;
+        return DMA_REQ_CPU;
+    }
+    return dma_request(s, dma_addr(dst), (c & 0xFF) * 0x01010101, len, 1);
+}
+
+int dma_done(struct dma_service *s, dma_req_t r)
+{
+    unsigned int i;
+
+    if (r == DMA_REQ_CPU) {
+        return 1;
+    }
+    if ((int)(s->done - r) < 0) {
+        dma_poll(s);
+        if ((int)(s->done - r) < 0) {
+            return 0;
+        }
+    }
+    for (i = 0; i < s->errors && i < DMA_FAILS; i++) {
+        if ((int)(r - s->fail_first[i]) >= 0 && (int)(s->fail_last[i] - r) >= 0) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+int dma_wait(struct dma_service *s, dma_req_t r)
+{
+    int done;
+
+    while ((done = dma_done(s, r)) == 0);
+    return done < 0 ? -1 : 0;
+}
+
+unsigned int dma_calibrate(struct dma_service *s, void *buf, unsigned int max)
+{
+    unsigned char *src = buf;
+    unsigned char *dst = src + max;
+    unsigned int size;
+    clock_t t, tcpu, tdma;
+    int i;
+
+    s->threshold = 0;
+    for (size = 64; size <= max; size *= 2) {
+        t = clock();
+        for (i = 0; i < DMA_CAL_RUNS; i++) {
+            memcpy(dst, src, size);
+        }
+        tcpu = clock() - t;
+        t = clock();
+        for (i = 0; i < DMA_CAL_RUNS; i++) {
+            dma_wait(s, dma_memcpy_async(s, dst, src, size));
+        }
+        tdma = clock() - t;
+        if (tdma <= tcpu) {
+            break;
+        }
+    }
+    /* Above max DMA never caught up, keep requests up to 2*max on the CPU */
+    s->threshold = size;
+    s->dma_bytes = 0;
+    s->cpu_bytes = 0;
+    return s->threshold;
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* memcpy/memset service on the GRDMAC.
+ *
+ * Each request takes one GRDMAC channel of a channel vector, with its M2B
+ * and B2M descriptor chains split in DMA_CHUNK pieces. Requests made while
+ * the GRDMAC is busy are collected in the next vector and started
+ * together, channel by channel, when the running vector completes. The
+ * GRDMAC only restarts after a reset, so vectors are never extended while
+ * they run.
+ *
+ * Requests below the calibrated threshold are copied by the CPU. Copies
+ * complete in request order, DMA and CPU copies may overlap each other.
+ *
+ * A GRDMAC error abandons the running vector. Its requests, including one
+ * that continues in the next vector, complete with an error, and the
+ * ticket ranges of the last DMA_FAILS failed vectors are kept for
+ * dma_done() and dma_wait(). */
+
+#ifndef __GRDMAC_DMA_H__
+#define __GRDMAC_DMA_H__
+
+#include <stdint.h>
+
+/* Control register */
+#define GRDMAC_CTRL_EN      0x01
+#define GRDMAC_CTRL_RST     0x02
+#define GRDMAC_CTRL_IE      0x04
+#define GRDMAC_CTRL_IEE     0x08
+#define GRDMAC_CTRL_CHEN    16
+
+/* Error register */
+#define GRDMAC_ERR_ERR      0x01
+
+/* Capability register */
+#define GRDMAC_CAP_NCH      0xF0
+#define GRDMAC_CAP_NCH_BIT  4
+
+/* Descriptor control */
+#define GRDMAC_DESC_EN      0x01
+#define GRDMAC_DESC_WB      0x02
+#define GRDMAC_DESC_IE      0x04
+#define GRDMAC_DESC_AHBM1   0x08
+#define GRDMAC_DESC_FIXED   0x10
+#define GRDMAC_DESC_SIZE    16
+
+#define GRDMAC_MAX_CH       16
+
+/* Bytes per descriptor, the size field has 16 bits */
+#define DMA_CHUNK           0x8000
+/* Channel vectors, one runs while the next collects requests */
+#define DMA_VECTORS         2
+/* Descriptors per direction in each vector */
+#define DMA_VEC_DESC        64
+/* Failed vectors remembered */
+#define DMA_FAILS           4
+
+struct grdmac_regs {
+    volatile uint32_t control;          /* 0x00 */
+    volatile uint32_t status;           /* 0x04 */
+    volatile uint32_t irq_mask;         /* 0x08 */
+    volatile uint32_t error;            /* 0x0C */
+    volatile uint32_t cvp;              /* 0x10 */
+    volatile uint32_t timer;            /* 0x14 */
+    volatile uint32_t capability;       /* 0x18 */
+    volatile uint32_t irq_flag;         /* 0x1C */
+};
+
+struct grdmac_desc {
+    volatile uint32_t next;
+    volatile uint32_t addr;
+    volatile uint32_t ctrl;
+    volatile uint32_t status;
+};
+
+struct dma_vector {
+    /* M2B and B2M chain per channel, 128 byte aligned */
+    volatile uint32_t cvp[2*GRDMAC_MAX_CH] __attribute__ ((aligned (128)));
+    struct grdmac_desc m2b[DMA_VEC_DESC];
+    struct grdmac_desc b2m[DMA_VEC_DESC];
+    uint32_t pattern[GRDMAC_MAX_CH];    /* memset source per channel */
+    int nch;                            /* Channels used */
+    int ndesc;                          /* Descriptors used per direction */
+    unsigned int first;                 /* Ticket of the first request */
+    unsigned int last;                  /* Ticket of the last request */
+    int split;                          /* The last request continues in the next vector */
+};
+
+typedef unsigned int dma_req_t;
+
+/* Ticket of requests copied by the CPU, never used for DMA requests */
+#define DMA_REQ_CPU         0
+
+struct dma_service {
+    struct grdmac_regs *regs;
+    int nch;                            /* Channels of the GRDMAC */
+    struct dma_vector *vec;
+    void *mem;
+    int running;                        /* Vector running, -1 when idle */
+    int filling;                        /* Vector collecting requests */
+    dma_req_t issued;
+    dma_req_t done;
+    unsigned int threshold;             /* Smallest request done by DMA */
+    unsigned int errors;                /* Failed vectors */
+    dma_req_t fail_first[DMA_FAILS];    /* Ticket ranges of failed vectors, */
+    dma_req_t fail_last[DMA_FAILS];     /* indexed by errors % DMA_FAILS */
+    unsigned long long dma_bytes;
+    unsigned long long cpu_bytes;
+};
+
+/* Returns 0 on success, -1 if the vectors cannot be allocated */
+int dma_init(struct dma_service *s, struct grdmac_regs *regs);
+/* Requests return a ticket for dma_wait(), one per request however many
+ * channels and vectors it takes. The buffers must not be touched until the
+ * request has completed. */
+dma_req_t dma_memcpy_async(struct dma_service *s, void *dst, const void *src, unsigned int len);
+dma_req_t dma_memset_async(struct dma_service *s, void *dst, int c, unsigned int len);
+/* Returns 1 when request r has completed, 0 while it is pending and -1 if
+ * it was in a vector abandoned on a GRDMAC error. Requests older than the
+ * last DMA_FAILS failed vectors are reported as completed. */
+int dma_done(struct dma_service *s, dma_req_t r);
+/* Waits for request r, returns 0 or -1 as dma_done() */
+int dma_wait(struct dma_service *s, dma_req_t r);
+/* Advances the service: completes the running vector and starts the next.
+ * Returns 1 when the GRDMAC is idle. */
+int dma_poll(struct dma_service *s);
+/* Measures CPU and DMA copies of increasing size and sets the threshold to
+ * the smallest size where DMA completes as fast as the CPU. buf must hold
+ * 2*max bytes. Returns the threshold. */
+unsigned int dma_calibrate(struct dma_service *s, void *buf, unsigned int max);
+
+#endif
@@ -0,0 +1,320 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "grdmac2_api.h"
+
+/* Descriptors are complete in memory before the GRDMAC2 is started */
+static inline void grdmac2_wmb(void)
+{
+#if defined(__riscv)
+    asm volatile ("fence ow, ow" : : : "memory");
+#else
+    asm volatile ("" : : : "memory");
+#endif
+}
+
+static inline uint32_t grdmac2_addr(const volatile void *p)
+{
+    return (uint32_t)(uintptr_t)p;
+}
+
+int grdmac2_chain_init(struct grdmac2_chain *c, int size)
+{
+    uintptr_t mem;
+
+    /* One slot more for the end of failed polls */
+    size++;
+    c->mem = malloc(size * sizeof(struct grdmac2_desc) + sizeof(struct grdmac2_desc) - 1);
+    if (c->mem == NULL) {
+        return -1;
+    }
+    mem = ((uintptr_t)c->mem + sizeof(struct grdmac2_desc) - 1) & ~(uintptr_t)(sizeof(struct grdmac2_desc) - 1);
+    c->desc = (struct grdmac2_desc *)mem;
+    c->size = size;
+    grdmac2_chain_reset(c);
+    return 0;
+}
+
+void grdmac2_chain_free(struct grdmac2_chain *c)
+{
+    free(c->mem);
+    c->mem = NULL;
+}
+
+void grdmac2_chain_reset(struct grdmac2_chain *c)
+{
+    /* A disabled descriptor ending the chain */
+    c->desc[0].ctrl = 0;
+    c->desc[0].next = GRDMAC2_DESC_LAST;
+    c->used = 1;
+    c->head = NULL;
+    c->tail = NULL;
+}
+
+/* Takes a slot for descriptor contents or data read by the GRDMAC2 */
+static struct grdmac2_desc *grdmac2_slot(struct grdmac2_chain *c)
+{
+    if (c->used == c->size) {
+        return NULL;
+    }
+    return &c->desc[c->used++];
+}
+
+/* Appends d, the control word is written last */
+static void grdmac2_link(struct grdmac2_chain *c, struct grdmac2_desc *d, uint32_t ctrl)
+{
+    d->next = GRDMAC2_DESC_LAST;
+    d->ctrl = ctrl;
+    if (c->tail != NULL) {
+        c->tail->next = grdmac2_addr(d);
+    } else {
+        c->head = d;
+    }
+    c->tail = d;
+}
+
+/* Data, AES and SHA descriptor of at most GRDMAC2_DATA_MAX bytes */
+static int grdmac2_chain_xfer(struct grdmac2_chain *c, int type, uint32_t dst,
+                              uint32_t src, unsigned int len, uint32_t flags)
+{
+    struct grdmac2_desc *d;
+
+    if ((d = grdmac2_slot(c)) == NULL) {
+        return -1;
+    }
+    d->w[0] = dst;
+    d->w[1] = src;
+    d->w[2] = 0;
+    grdmac2_link(c, d, (len << GRDMAC2_DATA_SIZE) | flags | (type << GRDMAC2_DESC_TYPE) | GRDMAC2_DESC_EN);
+    return 0;
+}
+
+int grdmac2_chain_data(struct grdmac2_chain *c, void *dst, const void *src,
+                       unsigned int len, uint32_t flags)
+{
+    uint32_t d = grdmac2_addr(dst);
+    uint32_t s = grdmac2_addr(src);
+    unsigned int n;
+
+    if (len == 0) {
+        return -1;
+    }
+    while (len > 0) {
+        n = len > GRDMAC2_CHUNK ? GRDMAC2_CHUNK : len;
+        if (grdmac2_chain_xfer(c, GRDMAC2_TYPE_DATA, d, s, n, flags) != 0) {
+            return -1;
+        }
+        if (!(flags & GRDMAC2_DATA_DSTFIX)) {
+            d += n;
+        }
+        if (!(flags & GRDMAC2_DATA_SRCFIX)) {
+            s += n;
+        }
+        len -= n;
+    }
+    return 0;
+}
+
+/* Polls addr until (*addr & mask) == expected, up to count times every
+ * interval timer ticks. The chain ends with an error if it never does. */
+int grdmac2_chain_poll(struct grdmac2_chain *c, const volatile void *addr,
+                       uint32_t expected, uint32_t mask, int count, int interval)
+{
+    struct grdmac2_desc *d;
+
+    if (count < 1 || count > 0xFF || interval < 0 || interval > 0xFF ||
+        ((uintptr_t)addr & 3) || (d = grdmac2_slot(c)) == NULL) {
+        return -1;
+    }
+    d->w[0] = grdmac2_addr(&c->desc[0]);
+    d->w[1] = grdmac2_addr(addr);
+    d->w[2] = 0;
+    d->w[3] = expected;
+    d->w[4] = mask;
+    grdmac2_link(c, d, (count << GRDMAC2_POLL_COUNT) | (interval << GRDMAC2_POLL_INTV) |
+                 GRDMAC2_POLL_ERRTO | (GRDMAC2_TYPE_POLL << GRDMAC2_DESC_TYPE) | GRDMAC2_DESC_EN);
+    return 0;
+}
+
+int grdmac2_chain_acc(struct grdmac2_chain *c, const void *src, unsigned int len)
+{
+    struct grdmac2_desc *d;
+
+    if ((len != GRDMAC2_AES_IV_SIZE && len != GRDMAC2_AES_KEY_SIZE) ||
+        (d = grdmac2_slot(c)) == NULL) {
+        return -1;
+    }
+    d->w[0] = grdmac2_addr(src);
+    d->w[1] = 0;
+    grdmac2_link(c, d, (len << GRDMAC2_ACC_SIZE) | (GRDMAC2_TYPE_ACC << GRDMAC2_DESC_TYPE) |
+                 GRDMAC2_DESC_EN);
+    return 0;
+}
+
+/* Adds blocks to the big endian counter block */
+static void grdmac2_ctr_add(unsigned char *ctr, unsigned int blocks)
+{
+    unsigned int carry = blocks;
+    int i;
+
+    for (i = GRDMAC2_AES_IV_SIZE - 1; i >= 0 && carry; i--) {
+        carry += ctr[i];
+        ctr[i] = carry & 0xFF;
+        carry >>= 8;
+    }
+}
+
+/* The AES accelerator starts every descriptor at the loaded IV, so each
+ * piece gets its own counter block, kept in a slot of the chain */
+int grdmac2_chain_aes(struct grdmac2_chain *c, void *dst, const void *src,
+                      unsigned int len, unsigned char *ctr)
+{
+    uint32_t d = grdmac2_addr(dst);
+    uint32_t s = grdmac2_addr(src);
+    struct grdmac2_desc *iv;
+    unsigned int n;
+
+    if (len == 0) {
+        return -1;
+    }
+    while (len > 0) {
+        n = len > GRDMAC2_CHUNK ? GRDMAC2_CHUNK : len;
+        if ((iv = grdmac2_slot(c)) == NULL) {
+            return -1;
+        }
+        memcpy((void *)iv, ctr, GRDMAC2_AES_IV_SIZE);
+        if (grdmac2_chain_acc(c, (void *)iv, GRDMAC2_AES_IV_SIZE) != 0 ||
+            grdmac2_chain_xfer(c, GRDMAC2_TYPE_AES, d, s, n, 0) != 0) {
+            return -1;
+        }
+        grdmac2_ctr_add(ctr, (n + GRDMAC2_AES_IV_SIZE - 1) / GRDMAC2_AES_IV_SIZE);
+        d += n;
+        s += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int grdmac2_chain_sha(struct grdmac2_chain *c, unsigned char *digest, const void *src,
+                      unsigned int len)
+{
+    if (len == 0 || len > GRDMAC2_DATA_MAX) {
+        return -1;
+    }
+    return grdmac2_chain_xfer(c, GRDMAC2_TYPE_SHA, grdmac2_addr(digest), grdmac2_addr(src), len, 0);
+}
+
+void grdmac2_start(struct grdmac2_regs *regs, struct grdmac2_chain *c)
+{
+    grdmac2_wmb();
+    regs->status = 0xFFFFFFFF;
+    regs->control = GRDMAC2_CTRL_RESTART;
+    regs->fdesc = grdmac2_addr(c->head != NULL ? c->head : c->desc);
+    regs->control = GRDMAC2_CTRL_EN;
+}
+
+int grdmac2_busy(struct grdmac2_regs *regs)
+{
+    uint32_t status = regs->status;
+
+    if (status & GRDMAC2_STS_ERR) {
+        return -1;
+    }
+    return !(status & GRDMAC2_STS_CMP);
+}
+
+int grdmac2_wait(struct grdmac2_regs *regs)
+{
+    int busy;
+
+    while ((busy = grdmac2_busy(regs)) == 1);
+    return busy;
+}
+
+int grdmac2_init(struct grdmac2_dev *dev, struct grdmac2_regs *regs, int size)
+{
+    dev->regs = regs;
+    dev->acc = (regs->capability & GRDMAC2_CAP_ACC) >> GRDMAC2_CAP_ACC_BIT;
+    memset(dev->ctr, 0, sizeof(dev->ctr));
+    regs->control = GRDMAC2_CTRL_RST;
+    regs->timer = 0;
+    return grdmac2_chain_init(&dev->chain, size);
+}
+
+int grdmac2_memcpy_async(struct grdmac2_dev *dev, void *dst, const void *src, unsigned int len)
+{
+    grdmac2_chain_reset(&dev->chain);
+    if (grdmac2_chain_data(&dev->chain, dst, src, len, 0) != 0) {
+        return -1;
+    }
+    grdmac2_start(dev->regs, &dev->chain);
+    return 0;
+}
+
+int grdmac2_memset_async(struct grdmac2_dev *dev, void *dst, int c, unsigned int len)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        dev->pattern[i] = (c & 0xFF) * 0x01010101;
+    }
+    grdmac2_chain_reset(&dev->chain);
+    if (grdmac2_chain_data(&dev->chain, dst, dev->pattern, len, GRDMAC2_DATA_SRCFIX) != 0) {
+        return -1;
+    }
+    grdmac2_start(dev->regs, &dev->chain);
+    return 0;
+}
+
+int grdmac2_aes256_async(struct grdmac2_dev *dev, void *dst, const void *src, unsigned int len,
+                         const unsigned char *key, const unsigned char *iv)
+{
+    struct grdmac2_desc *k;
+
+    if (!(dev->acc & GRDMAC2_CAP_AES256)) {
+        return -1;
+    }
+    grdmac2_chain_reset(&dev->chain);
+    if (key != NULL) {
+        if ((k = grdmac2_slot(&dev->chain)) == NULL) {
+            return -1;
+        }
+        memcpy((void *)k, key, GRDMAC2_AES_KEY_SIZE);
+        if (grdmac2_chain_acc(&dev->chain, (void *)k, GRDMAC2_AES_KEY_SIZE) != 0) {
+            return -1;
+        }
+    }
+    if (iv != NULL) {
+        memcpy(dev->ctr, iv, GRDMAC2_AES_IV_SIZE);
+    }
+    if (grdmac2_chain_aes(&dev->chain, dst, src, len, dev->ctr) != 0) {
+        return -1;
+    }
+    grdmac2_start(dev->regs, &dev->chain);
+    return 0;
+}
+
+int grdmac2_sha256_async(struct grdmac2_dev *dev, unsigned char *digest, const void *src,
+                         unsigned int len)
+{
+    if (!(dev->acc & GRDMAC2_CAP_SHA256)) {
+        return -1;
+    }
+    grdmac2_chain_reset(&dev->chain);
+    if (grdmac2_chain_sha(&dev->chain, digest, src, len) != 0) {
+        return -1;
+    }
+    grdmac2_start(dev->regs, &dev->chain);
+    return 0;
+}
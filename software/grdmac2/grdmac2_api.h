@@ -0,0 +1,160 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* GRDMAC2 descriptor chain library.
+ *
+ * Descriptors are built in a chain and handed to the GRDMAC2 with
+ * grdmac2_start(), which returns at once. grdmac2_wait() waits for the
+ * chain to complete. The GRDMAC2 always fetches 7 words per descriptor,
+ * every descriptor uses one 32 byte slot of the chain. */
+
+#ifndef __GRDMAC2_API_H__
+#define __GRDMAC2_API_H__
+
+#include <stdint.h>
+
+/* Control register */
+#define GRDMAC2_CTRL_EN      0x01
+#define GRDMAC2_CTRL_RST     0x02
+#define GRDMAC2_CTRL_KICK    0x04
+#define GRDMAC2_CTRL_RESTART 0x08
+#define GRDMAC2_CTRL_IE      0x10
+
+/* Status register */
+#define GRDMAC2_STS_CMP      0x01
+#define GRDMAC2_STS_ERR      0x02
+#define GRDMAC2_STS_ONG      0x04
+#define GRDMAC2_STS_PAU      0x08
+#define GRDMAC2_STS_IF       0x10
+
+/* Capability register */
+#define GRDMAC2_CAP_ACC      0xF000
+#define GRDMAC2_CAP_ACC_BIT  12
+#define GRDMAC2_CAP_AES256   0x01
+#define GRDMAC2_CAP_SHA256   0x02
+
+/* Descriptor control fields */
+#define GRDMAC2_DESC_EN      0x01
+#define GRDMAC2_DESC_TYPE    1
+#define GRDMAC2_DESC_WB      0x20
+#define GRDMAC2_DESC_LAST    0x01       /* In the next pointer */
+
+#define GRDMAC2_TYPE_DATA    0
+#define GRDMAC2_TYPE_POLL    1
+#define GRDMAC2_TYPE_AES     4
+#define GRDMAC2_TYPE_ACC     5
+#define GRDMAC2_TYPE_SHA     6
+
+/* Data, AES and SHA descriptors */
+#define GRDMAC2_DATA_IE      0x100
+#define GRDMAC2_DATA_SRCFIX  0x200
+#define GRDMAC2_DATA_DSTFIX  0x400
+#define GRDMAC2_DATA_SIZE    11
+#define GRDMAC2_DATA_MAX     0x1FFFFF
+
+/* Conditional poll descriptor */
+#define GRDMAC2_POLL_ERRTO   0x80
+#define GRDMAC2_POLL_IE      0x4000
+#define GRDMAC2_POLL_INTV    16
+#define GRDMAC2_POLL_COUNT   24
+
+/* Accelerator update descriptor, 16 bytes load the AES IV and 32 the key */
+#define GRDMAC2_ACC_IE       0x80
+#define GRDMAC2_ACC_SIZE     9
+
+/* Largest piece put in one descriptor, a multiple of the AES block size */
+#define GRDMAC2_CHUNK        0x100000
+
+#define GRDMAC2_AES_IV_SIZE  16
+#define GRDMAC2_AES_KEY_SIZE 32
+#define GRDMAC2_SHA_SIZE     32
+
+struct grdmac2_regs {
+    volatile uint32_t control;          /* 0x00 */
+    volatile uint32_t status;           /* 0x04 */
+    volatile uint32_t timer;            /* 0x08 */
+    volatile uint32_t capability;       /* 0x0C */
+    volatile uint32_t fdesc;            /* 0x10 */
+    volatile uint32_t desc_ctrl;        /* 0x14 */
+    volatile uint32_t desc_next;        /* 0x18 */
+    volatile uint32_t desc_fnext;       /* 0x1C */
+    volatile uint32_t poll_src;         /* 0x20 */
+    volatile uint32_t desc_sts;         /* 0x24 */
+    volatile uint32_t expd_data;        /* 0x28 */
+    volatile uint32_t cond_mask;        /* 0x2C */
+    volatile uint32_t curr_desc;        /* 0x30 */
+};
+
+/* One descriptor slot. Data descriptors use ctrl, next, w[0] (destination),
+ * w[1] (source) and w[2] (status). Conditional descriptors use w[0] (next on
+ * failure), w[1] (polled address), w[2] (status), w[3] (expected data) and
+ * w[4] (mask). Accelerator updates use w[0] (source) and w[1] (status). */
+struct grdmac2_desc {
+    volatile uint32_t ctrl;
+    volatile uint32_t next;
+    volatile uint32_t w[6];
+};
+
+struct grdmac2_chain {
+    struct grdmac2_desc *desc;          /* Slots, desc[0] ends failed polls */
+    int size;
+    int used;
+    struct grdmac2_desc *head;          /* First descriptor added */
+    struct grdmac2_desc *tail;          /* Last descriptor added */
+    void *mem;
+};
+
+struct grdmac2_dev {
+    struct grdmac2_regs *regs;
+    struct grdmac2_chain chain;
+    int acc;                            /* GRDMAC2_CAP_AES256/SHA256 */
+    unsigned char ctr[GRDMAC2_AES_IV_SIZE]; /* Next AES counter block */
+    uint32_t pattern[4] __attribute__ ((aligned (16))); /* memset source */
+};
+
+/* Chain building, all return 0 on success and -1 when the chain is full
+ * or a parameter is out of range */
+int grdmac2_chain_init(struct grdmac2_chain *c, int size);
+void grdmac2_chain_free(struct grdmac2_chain *c);
+void grdmac2_chain_reset(struct grdmac2_chain *c);
+int grdmac2_chain_data(struct grdmac2_chain *c, void *dst, const void *src,
+                       unsigned int len, uint32_t flags);
+int grdmac2_chain_poll(struct grdmac2_chain *c, const volatile void *addr,
+                       uint32_t expected, uint32_t mask, int count, int interval);
+int grdmac2_chain_acc(struct grdmac2_chain *c, const void *src, unsigned int len);
+/* AES-256 CTR from the counter block ctr, which is advanced past the data */
+int grdmac2_chain_aes(struct grdmac2_chain *c, void *dst, const void *src,
+                      unsigned int len, unsigned char *ctr);
+int grdmac2_chain_sha(struct grdmac2_chain *c, unsigned char *digest, const void *src,
+                      unsigned int len);
+
+/* Starts the chain and returns at once */
+void grdmac2_start(struct grdmac2_regs *regs, struct grdmac2_chain *c);
+/* Returns 1 while the chain runs, 0 when complete and -1 on error */
+int grdmac2_busy(struct grdmac2_regs *regs);
+/* Waits for the chain, returns 0 when complete and -1 on error */
+int grdmac2_wait(struct grdmac2_regs *regs);
+
+/* Asynchronous operations, each replaces the chain of the device. Wait
+ * with grdmac2_wait(dev->regs) before touching the buffers. */
+int grdmac2_init(struct grdmac2_dev *dev, struct grdmac2_regs *regs, int size);
+int grdmac2_memcpy_async(struct grdmac2_dev *dev, void *dst, const void *src, unsigned int len);
+int grdmac2_memset_async(struct grdmac2_dev *dev, void *dst, int c, unsigned int len);
+/* AES-256 CTR. The key is loaded first unless NULL. With iv NULL the counter
+ * continues at the block after the previous operation. */
+int grdmac2_aes256_async(struct grdmac2_dev *dev, void *dst, const void *src, unsigned int len,
+                         const unsigned char *key, const unsigned char *iv);
+/* SHA-256 of up to GRDMAC2_DATA_MAX bytes, digest in big endian order */
+int grdmac2_sha256_async(struct grdmac2_dev *dev, unsigned char *digest, const void *src,
+                         unsigned int len);
+
+#endif
@@ -0,0 +1,253 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* Changelog */
+/* 2026-10-18: GRDMAC2 chain library benchmark */
+
+/* Checks the GRDMAC2 memcpy, memset, AES-256 and SHA-256 operations and
+ * compares their throughput with the CPU doing the same work. Data read
+ * back after DMA relies on the data cache snooping the bus. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "grdmac2_api.h"
+
+#define GRDMAC2_ADDR 0xFC000000
+
+/* Buffer size and number of runs per measurement */
+#define BENCH_SIZE (4*1024*1024)
+#define BENCH_RUNS 4
+/* A SHA-256 descriptor takes at most GRDMAC2_DATA_MAX bytes */
+#define SHA_SIZE (1024*1024)
+
+/* Descriptor slots of the chain */
+#define CHAIN_SIZE 64
+
+static unsigned char aes_iv[] = {
+    0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+    0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,
+};
+
+static unsigned char aes_key[] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+    0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+    0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4,
+};
+
+static unsigned char aes_plaintext[] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+};
+
+static unsigned char aes_ciphertext[] = {
+    0x60, 0x1e, 0xc3, 0x13, 0x77, 0x57, 0x89, 0xa5,
+    0xb7, 0xa7, 0xf5, 0x04, 0xbb, 0xf3, 0xd2, 0x28,
+    0xf4, 0x43, 0xe3, 0xca, 0x4d, 0x62, 0xb5, 0x9a,
+    0xca, 0x84, 0xe9, 0x90, 0xca, 0xca, 0xf5, 0xc5,
+};
+
+/* CPU SHA-256 as reference */
+static const uint32_t sha_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t *h, const unsigned char *p)
+{
+    uint32_t w[64], a, b, c, d, e, f, g, k, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = (p[4*i] << 24) | (p[4*i + 1] << 16) | (p[4*i + 2] << 8) | p[4*i + 3];
+    }
+    for (i = 16; i < 64; i++) {
+        w[i] = w[i - 16] + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+               w[i - 7] + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+    a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4]; f = h[5]; g = h[6]; k = h[7];
+    for (i = 0; i < 64; i++) {
+        t1 = k + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + sha_k[i] + w[i];
+        t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static void sha256(unsigned char *digest, const unsigned char *p, unsigned int len)
+{
+    uint32_t h[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    unsigned char last[128];
+    unsigned int n, i;
+
+    for (n = len; n >= 64; n -= 64, p += 64) {
+        sha256_block(h, p);
+    }
+    memset(last, 0, sizeof(last));
+    memcpy(last, p, n);
+    last[n] = 0x80;
+    n = n < 56 ? 64 : 128;
+    for (i = 0; i < 8; i++) {
+        last[n - 1 - i] = (unsigned long long)len * 8 >> (8 * i);
+    }
+    sha256_block(h, last);
+    if (n == 128) {
+        sha256_block(h, last + 64);
+    }
+    for (i = 0; i < 32; i++) {
+        digest[i] = h[i / 4] >> (24 - 8 * (i % 4));
+    }
+}
+
+static double elapsed(clock_t t)
+{
+    return (double)(clock() - t) / CLOCKS_PER_SEC;
+}
+
+static void report(const char *name, int size, double dma, double cpu)
+{
+    double bytes = (double)size * BENCH_RUNS;
+
+    printf("%-8s GRDMAC2 %7.3f GB/s  CPU %7.3f GB/s\n", name,
+           bytes / (dma * 1e9), bytes / (cpu * 1e9));
+}
+
+int main(void)
+{
+    struct grdmac2_dev dev;
+    unsigned char *src, *dst, *ref;
+    unsigned char hw[GRDMAC2_SHA_SIZE] __attribute__ ((aligned (16)));
+    unsigned char sw[GRDMAC2_SHA_SIZE];
+    double tdma, tcpu;
+    clock_t t;
+    int i, fail = 0;
+
+    src = malloc(BENCH_SIZE);
+    dst = malloc(BENCH_SIZE);
+    ref = malloc(BENCH_SIZE);
+    if (src == NULL || dst == NULL || ref == NULL ||
+        grdmac2_init(&dev, (struct grdmac2_regs *)GRDMAC2_ADDR, CHAIN_SIZE) != 0) {
+        printf("Allocation failed\n");
+        return 1;
+    }
+    for (i = 0; i < BENCH_SIZE; i++) {
+        src[i] = i * 7 + (i >> 12);
+    }
+
+    /* memcpy, several descriptors per operation */
+    memset(dst, 0, BENCH_SIZE);
+    if (grdmac2_memcpy_async(&dev, dst, src, BENCH_SIZE) != 0 ||
+        grdmac2_wait(dev.regs) != 0 || memcmp(dst, src, BENCH_SIZE) != 0) {
+        printf("memcpy: data error\n");
+        fail++;
+    }
+    t = clock();
+    for (i = 0; i < BENCH_RUNS; i++) {
+        grdmac2_memcpy_async(&dev, dst, src, BENCH_SIZE);
+        grdmac2_wait(dev.regs);
+    }
+    tdma = elapsed(t);
+    t = clock();
+    for (i = 0; i < BENCH_RUNS; i++) {
+        memcpy(ref, src, BENCH_SIZE);
+    }
+    tcpu = elapsed(t);
+    report("memcpy", BENCH_SIZE, tdma, tcpu);
+
+    /* memset */
+    if (grdmac2_memset_async(&dev, dst, 0x5A, BENCH_SIZE) != 0 || grdmac2_wait(dev.regs) != 0 ||
+        dst[0] != 0x5A || dst[BENCH_SIZE - 1] != 0x5A) {
+        printf("memset: data error\n");
+        fail++;
+    }
+    t = clock();
+    for (i = 0; i < BENCH_RUNS; i++) {
+        grdmac2_memset_async(&dev, dst, i, BENCH_SIZE);
+        grdmac2_wait(dev.regs);
+    }
+    tdma = elapsed(t);
+    t = clock();
+    for (i = 0; i < BENCH_RUNS; i++) {
+        memset(ref, i, BENCH_SIZE);
+    }
+    tcpu = elapsed(t);
+    report("memset", BENCH_SIZE, tdma, tcpu);
+
+    if (dev.acc & GRDMAC2_CAP_AES256) {
+        /* Known answer, in two operations chaining the counter */
+        if (grdmac2_aes256_async(&dev, dst, aes_plaintext, 16, aes_key, aes_iv) != 0 ||
+            grdmac2_wait(dev.regs) != 0 ||
+            grdmac2_aes256_async(&dev, dst + 16, aes_plaintext + 16, 16, NULL, NULL) != 0 ||
+            grdmac2_wait(dev.regs) != 0 || memcmp(dst, aes_ciphertext, 32) != 0) {
+            printf("AES-256: known answer error\n");
+            fail++;
+        }
+        /* Round trip over several descriptors */
+        grdmac2_aes256_async(&dev, dst, src, BENCH_SIZE, aes_key, aes_iv);
+        grdmac2_wait(dev.regs);
+        grdmac2_aes256_async(&dev, ref, dst, BENCH_SIZE, NULL, aes_iv);
+        if (grdmac2_wait(dev.regs) != 0 || memcmp(ref, src, BENCH_SIZE) != 0) {
+            printf("AES-256: round trip error\n");
+            fail++;
+        }
+        t = clock();
+        for (i = 0; i < BENCH_RUNS; i++) {
+            grdmac2_aes256_async(&dev, dst, src, BENCH_SIZE, NULL, NULL);
+            grdmac2_wait(dev.regs);
+        }
+        tdma = elapsed(t);
+        printf("AES-256  GRDMAC2 %7.3f GB/s\n", (double)BENCH_SIZE * BENCH_RUNS / (tdma * 1e9));
+    }
+
+    if (dev.acc & GRDMAC2_CAP_SHA256) {
+        if (grdmac2_sha256_async(&dev, hw, src, SHA_SIZE) != 0 || grdmac2_wait(dev.regs) != 0) {
+            printf("SHA-256: error\n");
+            fail++;
+        }
+        sha256(sw, src, SHA_SIZE);
+        if (memcmp(hw, sw, GRDMAC2_SHA_SIZE) != 0) {
+            printf("SHA-256: digest differs from CPU\n");
+            fail++;
+        }
+        t = clock();
+        for (i = 0; i < BENCH_RUNS; i++) {
+            grdmac2_sha256_async(&dev, hw, src, SHA_SIZE);
+            grdmac2_wait(dev.regs);
+        }
+        tdma = elapsed(t);
+        t = clock();
+        for (i = 0; i < BENCH_RUNS; i++) {
+            sha256(sw, src, SHA_SIZE);
+        }
+        tcpu = elapsed(t);
+        report("SHA-256", SHA_SIZE, tdma, tcpu);
+    }
+
+    grdmac2_chain_free(&dev.chain);
+    printf("%d errors\n", fail);
+    return fail != 0;
+}
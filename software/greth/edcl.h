@@ -0,0 +1,77 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* EDCL (Ethernet debug communication link) packet layout, shared by the
+ * GRETH system tests and the host side edcltool/edclsim.
+ *
+ * The EDCL part of a packet is the UDP payload:
+ *   [0..1]  two zero bytes
+ *   [2..5]  control word: seq[31:18] rw/nak[17] len[16:7]
+ *   [6..9]  address
+ *   [10..]  data, for write requests and read replies
+ *
+ * The EDCL executes requests in sequence number order only. A request with
+ * an unexpected sequence number is answered with the nak bit set and the
+ * sequence number the EDCL expects. */
+
+#ifndef __EDCL_H__
+#define __EDCL_H__
+
+#define EDCL_HDR     10
+#define EDCL_MAXLEN  0x3FF
+#define EDCL_SEQMASK 0x3FFF
+
+static inline unsigned int edcl_ctrl(unsigned int seq, unsigned int rw, unsigned int dlen)
+{
+    return ((seq & EDCL_SEQMASK) << 18) | ((rw & 1) << 17) | ((dlen & EDCL_MAXLEN) << 7);
+}
+
+/* Builds an EDCL request at p, returns the UDP payload length */
+static inline int edcl_build(unsigned char *p, unsigned int seq, unsigned int rw,
+                             unsigned int addr, unsigned int dlen,
+                             const unsigned char *data)
+{
+    unsigned int ctrl = edcl_ctrl(seq, rw, dlen);
+    unsigned int i;
+
+    p[0] = 0;
+    p[1] = 0;
+    p[2] = (ctrl >> 24) & 0xFF;
+    p[3] = (ctrl >> 16) & 0xFF;
+    p[4] = (ctrl >> 8) & 0xFF;
+    p[5] = ctrl & 0xFF;
+    p[6] = (addr >> 24) & 0xFF;
+    p[7] = (addr >> 16) & 0xFF;
+    p[8] = (addr >> 8) & 0xFF;
+    p[9] = addr & 0xFF;
+    if (!rw) {
+        return EDCL_HDR;
+    }
+    for (i = 0; i < dlen; i++) {
+        p[EDCL_HDR + i] = data[i];
+    }
+    return EDCL_HDR + dlen;
+}
+
+/* Decodes the control word and address of an EDCL packet at p */
+static inline void edcl_parse(const unsigned char *p, unsigned int *seq, unsigned int *rw,
+                              unsigned int *dlen, unsigned int *addr)
+{
+    unsigned int ctrl = (p[2] << 24) | (p[3] << 16) | (p[4] << 8) | p[5];
+
+    *seq = (ctrl >> 18) & EDCL_SEQMASK;
+    *rw = (ctrl >> 17) & 1;
+    *dlen = (ctrl >> 7) & EDCL_MAXLEN;
+    *addr = ((unsigned int)p[6] << 24) | (p[7] << 16) | (p[8] << 8) | p[9];
+}
+
+#endif
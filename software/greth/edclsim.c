@@ -0,0 +1,110 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* UDP stand-in for the GRETH EDCL, used to test edcltool on a Linux host.
+ *
+ * Requests are served from a memory area in sequence number order as the
+ * EDCL does. Requests with another sequence number are nak'ed with the
+ * expected one. Requests and replies can be dropped at random to exercise
+ * the resynchronisation in edcltool. */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "edcl.h"
+
+#define EDCL_PORT 8000
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: edclsim [-p port] [-b base] [-m size] [-d percent]\n"
+            "  -p  UDP port (%d)\n"
+            "  -b  address of the memory area (0x40000000)\n"
+            "  -m  size of the memory area (16 MiB)\n"
+            "  -d  percentage of requests and replies dropped (0)\n", EDCL_PORT);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char pkt[EDCL_HDR + EDCL_MAXLEN + 1];
+    unsigned char *mem;
+    unsigned int base = 0x40000000;
+    unsigned int size = 16 * 1024 * 1024;
+    unsigned int expected = 0;
+    unsigned int seq, rw, dlen, addr;
+    struct sockaddr_in sa, from;
+    socklen_t fromlen;
+    int drop = 0;
+    int fd, c, n, len;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons(EDCL_PORT);
+
+    while ((c = getopt(argc, argv, "p:b:m:d:")) != -1) {
+        switch (c) {
+        case 'p': sa.sin_port = htons(atoi(optarg)); break;
+        case 'b': base = strtoul(optarg, NULL, 0); break;
+        case 'm': size = strtoul(optarg, NULL, 0); break;
+        case 'd': drop = atoi(optarg); break;
+        default: usage();
+        }
+    }
+    if (!(mem = calloc(size, 1))) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0 ||
+        bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        perror("socket");
+        return 1;
+    }
+    srand(getpid());
+
+    while (1) {
+        fromlen = sizeof(from);
+        n = recvfrom(fd, pkt, sizeof(pkt), 0, (struct sockaddr *)&from, &fromlen);
+        if (n < EDCL_HDR || (rand() % 100) < drop) {
+            continue;
+        }
+        edcl_parse(pkt, &seq, &rw, &dlen, &addr);
+        if (seq != expected) {
+            len = edcl_build(pkt, expected, 1, addr, 0, NULL);
+        } else {
+            expected = (expected + 1) & EDCL_SEQMASK;
+            if (addr < base || addr - base + dlen > size) {
+                /* Outside of the memory area, reads return zeroes */
+                memset(&pkt[EDCL_HDR], 0, dlen);
+            } else if (rw) {
+                if (n - EDCL_HDR >= (int)dlen) {
+                    memcpy(&mem[addr - base], &pkt[EDCL_HDR], dlen);
+                }
+            } else {
+                memcpy(&pkt[EDCL_HDR], &mem[addr - base], dlen);
+            }
+            /* Replies to writes carry no data */
+            len = edcl_build(pkt, seq, 0, addr, rw ? 0 : dlen, NULL) + (rw ? 0 : dlen);
+        }
+        if ((rand() % 100) < drop) {
+            continue;
+        }
+        sendto(fd, pkt, len, 0, (struct sockaddr *)&from, fromlen);
+    }
+    return 0;
+}
@@ -0,0 +1,418 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* Linux host tool for bulk memory transfers over EDCL.
+ *
+ * A window of requests is kept outstanding instead of waiting for each
+ * reply. The EDCL only executes requests in sequence order, so when a
+ * request is lost the following ones are nak'ed with the expected sequence
+ * number. The tool then resynchronises on the first nak: writes before the
+ * expected sequence number have been executed and are done, everything else
+ * is sent again starting from the expected sequence number (go-back-N). The
+ * naks for the rest of the old window carry the same sequence number and are
+ * ignored. Replies come in order, so a reply to a later request shows that
+ * the replies to the earlier ones were lost: those writes are done and those
+ * reads are sent again. If no reply at all arrives within the timeout the
+ * outstanding requests are repeated.
+ *
+ * Use edclsim to test without hardware. */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "edcl.h"
+
+#define EDCL_PORT 8000
+
+#define REQ_PENDING  0
+#define REQ_INFLIGHT 1
+#define REQ_DONE     2
+
+struct edcl {
+    int fd;
+    struct sockaddr_in sa;
+    int window;
+    unsigned int chunk;
+    int timeout;            /* ms */
+    unsigned int seq;       /* Next sequence number to send */
+    unsigned int acked;     /* Sequence number after the newest reply */
+    unsigned int naks;
+    unsigned int retries;
+};
+
+struct edcl_req {
+    unsigned int addr;
+    unsigned int len;
+    unsigned char *data;
+    unsigned int seq;
+    int state;
+    int resent;             /* First request sent after a nak */
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int edcl_send(struct edcl *e, int rw, struct edcl_req *r)
+{
+    unsigned char pkt[EDCL_HDR + EDCL_MAXLEN + 1];
+    int len;
+
+    len = edcl_build(pkt, r->seq, rw, r->addr, r->len, r->data);
+    if (sendto(e->fd, pkt, len, 0, (struct sockaddr *)&e->sa, sizeof(e->sa)) != len) {
+        perror("sendto");
+        return -1;
+    }
+    return 0;
+}
+
+/* Sequence number a is older than b */
+static int seq_before(unsigned int a, unsigned int b)
+{
+    unsigned int diff = (b - a) & EDCL_SEQMASK;
+    return diff != 0 && diff < (EDCL_SEQMASK + 1) / 2;
+}
+
+/* Acquires the sequence number expected by the EDCL with a zero length read */
+static int edcl_sync(struct edcl *e)
+{
+    unsigned char pkt[EDCL_HDR + EDCL_MAXLEN + 1];
+    struct edcl_req r;
+    unsigned int seq, nak, dlen, raddr;
+    struct pollfd pfd;
+    int i, n;
+
+    memset(&r, 0, sizeof(r));
+    for (i = 0; i < 10; i++) {
+        if (edcl_send(e, 0, &r)) {
+            return -1;
+        }
+        pfd.fd = e->fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, e->timeout) > 0 &&
+            (n = recv(e->fd, pkt, sizeof(pkt), 0)) >= EDCL_HDR) {
+            edcl_parse(pkt, &seq, &nak, &dlen, &raddr);
+            e->seq = nak ? seq : (seq + 1) & EDCL_SEQMASK;
+            e->acked = e->seq;
+            return 0;
+        }
+    }
+    fprintf(stderr, "no reply from EDCL\n");
+    return -1;
+}
+
+/* Reads (rw = 0) or writes (rw = 1) len bytes at addr */
+static int edcl_transfer(struct edcl *e, int rw, unsigned int addr,
+                         unsigned char *data, unsigned int len)
+{
+    unsigned char pkt[EDCL_HDR + EDCL_MAXLEN + 1];
+    struct edcl_req *req;
+    int *inflight, *pendq;
+    int nreq, next, done, goback;
+    int ninflight, phead, ptail, npend;
+    unsigned int seq, nak, dlen, raddr;
+    double sent;
+    int i, j, n, r;
+
+    nreq = (len + e->chunk - 1) / e->chunk;
+    req = calloc(nreq, sizeof(*req));
+    inflight = calloc(e->window, sizeof(int));
+    pendq = calloc(nreq, sizeof(int));
+    if (!req || !inflight || !pendq) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    for (i = 0; i < nreq; i++) {
+        req[i].addr = addr + i * e->chunk;
+        req[i].data = &data[i * e->chunk];
+        req[i].len = len - i * e->chunk < e->chunk ? len - i * e->chunk : e->chunk;
+    }
+
+    next = 0;
+    done = 0;
+    goback = 0;
+    ninflight = 0;
+    phead = ptail = npend = 0;
+    sent = now();
+    while (done < nreq) {
+        /* Fill the window, requests to be repeated first */
+        while (ninflight < e->window && (npend || next < nreq)) {
+            if (npend) {
+                r = pendq[ptail];
+                ptail = (ptail + 1) % nreq;
+                npend--;
+            } else {
+                r = next++;
+            }
+            req[r].seq = e->seq;
+            req[r].state = REQ_INFLIGHT;
+            req[r].resent = goback;
+            goback = 0;
+            e->seq = (e->seq + 1) & EDCL_SEQMASK;
+            if (edcl_send(e, rw, &req[r])) {
+                return -1;
+            }
+            if (ninflight == 0) {
+                sent = now();
+            }
+            inflight[ninflight++] = r;
+        }
+
+        struct pollfd pfd = { e->fd, POLLIN, 0 };
+        int wait = e->timeout - (int)((now() - sent) * 1000);
+        if (wait < 0) {
+            wait = 0;
+        }
+        n = poll(&pfd, 1, wait);
+        if (n < 0 && errno != EINTR) {
+            perror("poll");
+            return -1;
+        }
+        if (n <= 0) {
+            /* Nothing at all came back, repeat the window */
+            e->retries++;
+            for (i = 0; i < ninflight; i++) {
+                if (edcl_send(e, rw, &req[inflight[i]])) {
+                    return -1;
+                }
+            }
+            sent = now();
+            continue;
+        }
+
+        n = recv(e->fd, pkt, sizeof(pkt), 0);
+        if (n < EDCL_HDR) {
+            continue;
+        }
+        edcl_parse(pkt, &seq, &nak, &dlen, &raddr);
+
+        if (nak) {
+            /*
+             * Go back on a nak for the oldest request, which sends the same
+             * requests with the same sequence numbers again. Naks behind a
+             * reply or a request already sent again are stale, and a later
+             * request in the window may still be executed from a repeat.
+             */
+            if (seq_before(seq, e->acked)) {
+                continue;
+            }
+            for (i = 0; i < ninflight; i++) {
+                if (req[inflight[i]].seq == seq) {
+                    break;
+                }
+            }
+            if (i < ninflight && (i > 0 || req[inflight[0]].resent)) {
+                continue;
+            }
+            e->naks++;
+            for (i = 0; i < ninflight; i++) {
+                r = inflight[i];
+                if (rw && seq_before(req[r].seq, seq)) {
+                    req[r].state = REQ_DONE;
+                    done++;
+                } else {
+                    req[r].state = REQ_PENDING;
+                    pendq[phead] = r;
+                    phead = (phead + 1) % nreq;
+                    npend++;
+                }
+            }
+            ninflight = 0;
+            e->seq = seq;
+            goback = 1;
+            continue;
+        }
+
+        for (i = 0; i < ninflight; i++) {
+            if (req[inflight[i]].seq == seq) {
+                break;
+            }
+        }
+        if (i == ninflight) {
+            continue;
+        }
+        r = inflight[i];
+        if (!rw) {
+            if ((unsigned int)(n - EDCL_HDR) < req[r].len) {
+                continue;
+            }
+            memcpy(req[r].data, &pkt[EDCL_HDR], req[r].len);
+        }
+        req[r].state = REQ_DONE;
+        done++;
+        if (!seq_before((seq + 1) & EDCL_SEQMASK, e->acked)) {
+            e->acked = (seq + 1) & EDCL_SEQMASK;
+        }
+        /* The replies to the requests before it were lost */
+        for (j = 0; j < i; j++) {
+            r = inflight[j];
+            if (rw) {
+                req[r].state = REQ_DONE;
+                done++;
+            } else {
+                req[r].state = REQ_PENDING;
+                pendq[phead] = r;
+                phead = (phead + 1) % nreq;
+                npend++;
+            }
+        }
+        for (j = i + 1; j < ninflight; j++) {
+            inflight[j - i - 1] = inflight[j];
+        }
+        ninflight -= i + 1;
+        sent = now();
+    }
+
+    free(req);
+    free(inflight);
+    free(pendq);
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: edcltool [-p port] [-w window] [-s size] [-t timeout] host cmd ...\n"
+            "  read addr len file   read memory to file\n"
+            "  write addr file      write file to memory\n"
+            "  bench addr len       write, read back and compare random data\n"
+            "  -p  UDP port (%d)\n"
+            "  -w  outstanding requests (8)\n"
+            "  -s  bytes per request, at most %d (512)\n"
+            "  -t  reply timeout in ms (100)\n", EDCL_PORT, EDCL_MAXLEN & ~3);
+    exit(1);
+}
+
+static void report(const char *what, unsigned int len, double t, struct edcl *e)
+{
+    printf("%s %u bytes in %.3f s: %.2f MB/s (%u naks, %u timeouts)\n",
+           what, len, t, len / t / (1024 * 1024), e->naks, e->retries);
+}
+
+int main(int argc, char **argv)
+{
+    struct edcl e;
+    unsigned char *buf, *chk;
+    unsigned int addr, len, i;
+    double t;
+    FILE *f;
+    int c;
+
+    memset(&e, 0, sizeof(e));
+    e.window = 8;
+    e.chunk = 512;
+    e.timeout = 100;
+    e.sa.sin_family = AF_INET;
+    e.sa.sin_port = htons(EDCL_PORT);
+
+    while ((c = getopt(argc, argv, "p:w:s:t:")) != -1) {
+        switch (c) {
+        case 'p': e.sa.sin_port = htons(atoi(optarg)); break;
+        case 'w': e.window = atoi(optarg); break;
+        case 's': e.chunk = strtoul(optarg, NULL, 0); break;
+        case 't': e.timeout = atoi(optarg); break;
+        default: usage();
+        }
+    }
+    if (argc - optind < 3 || e.window < 1 || e.chunk < 1 || e.chunk > EDCL_MAXLEN) {
+        usage();
+    }
+    if (inet_aton(argv[optind], &e.sa.sin_addr) == 0) {
+        fprintf(stderr, "bad address %s\n", argv[optind]);
+        return 1;
+    }
+    if ((e.fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("socket");
+        return 1;
+    }
+    if (edcl_sync(&e)) {
+        return 1;
+    }
+    addr = strtoul(argv[optind + 2], NULL, 0);
+
+    if (!strcmp(argv[optind + 1], "read") && argc - optind == 5) {
+        len = strtoul(argv[optind + 3], NULL, 0);
+        buf = malloc(len);
+        t = now();
+        if (!buf || edcl_transfer(&e, 0, addr, buf, len)) {
+            return 1;
+        }
+        report("read", len, now() - t, &e);
+        if (!(f = fopen(argv[optind + 4], "wb")) || fwrite(buf, 1, len, f) != len) {
+            perror(argv[optind + 4]);
+            return 1;
+        }
+        fclose(f);
+    } else if (!strcmp(argv[optind + 1], "write") && argc - optind == 4) {
+        if (!(f = fopen(argv[optind + 3], "rb"))) {
+            perror(argv[optind + 3]);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        len = ftell(f);
+        rewind(f);
+        buf = malloc(len);
+        if (!buf || fread(buf, 1, len, f) != len) {
+            perror(argv[optind + 3]);
+            return 1;
+        }
+        fclose(f);
+        t = now();
+        if (edcl_transfer(&e, 1, addr, buf, len)) {
+            return 1;
+        }
+        report("wrote", len, now() - t, &e);
+    } else if (!strcmp(argv[optind + 1], "bench") && argc - optind == 4) {
+        len = strtoul(argv[optind + 3], NULL, 0);
+        buf = malloc(len);
+        chk = malloc(len);
+        if (!buf || !chk) {
+            return 1;
+        }
+        srand(1);
+        for (i = 0; i < len; i++) {
+            buf[i] = rand();
+        }
+        t = now();
+        if (edcl_transfer(&e, 1, addr, buf, len)) {
+            return 1;
+        }
+        report("wrote", len, now() - t, &e);
+        e.naks = e.retries = 0;
+        t = now();
+        if (edcl_transfer(&e, 0, addr, chk, len)) {
+            return 1;
+        }
+        report("read", len, now() - t, &e);
+        for (i = 0; i < len; i++) {
+            if (buf[i] != chk[i]) {
+                printf("compare error at 0x%08x: 0x%02x, expected 0x%02x\n",
+                       addr + i, chk[i], buf[i]);
+                return 1;
+            }
+        }
+    } else {
+        usage();
+    }
+    close(e.fd);
+    return 0;
+}
@@ -13,6 +13,9 @@
 /* Changelog */
 /* 2007-11-13: Simple Ethernet speed test added - Kristoffer Glembo */
 /* 2007-11-13: GRETH BareC API added            - Kristoffer Glembo */
+/* 2026-10-18: Burst transmit, 64/1514 byte frames and cycles per frame */
+/* 2026-10-18: UDP checksum offload test */
+/* 2026-10-18: Non-blocking PHY setup clocked by a GPTIMER */
 
 #include <stdlib.h>
 #include <time.h>
@@ -30,8 +33,22 @@
 /* Set to 1 to enable timestamping */
 #define GRETH_TIMESTAMPS 0
 
+/* Set to 1 to also measure receive rate with the RX buffer pool */
+#define GRETH_RXTEST 0
+
 #define GRETH_ADDR 0x80000b00
 
+/* GPTIMER clocking the PHY manager, and the timer used. Timer 0 runs the
+ * BCC clock() used by the tests and the last timer is the watchdog when the
+ * GPTIMER has one. The prescaler is assumed to be set up for 1 MHz ticks by
+ * the boot code */
+#define GPTIMER_ADDR 0x80000300
+#define PHY_TIMER 1
+#define PHY_TICK_US 1000
+/* Ticks allowed for the PHY reset, and ticks to wait for the link */
+#define PHY_RESET_TICKS 500
+#define PHY_LINK_TICKS 5000
+
 /* Destination MAC address */
 #define DEST_MAC0  0x00
 #define DEST_MAC1  0x13
@@ -49,14 +66,254 @@
 #define SRC_MAC5  0x20
 
 struct greth_info greth;
+struct greth_phy phy;
+
+struct gptimer_timer {
+    volatile unsigned int counter;
+    volatile unsigned int reload;
+    volatile unsigned int control;
+    volatile unsigned int latch;
+};
+
+struct gptimer_regs {
+    volatile unsigned int scalercnt;
+    volatile unsigned int scalerload;
+    volatile unsigned int config;
+    volatile unsigned int latchcfg;
+    struct gptimer_timer timer[7];
+};
+
+#define GPTIMER_IP 0x10
+#define GPTIMER_IE 0x08
+#define GPTIMER_LD 0x04
+#define GPTIMER_RS 0x02
+#define GPTIMER_EN 0x01
+
+static volatile struct gptimer_timer *phytimer;
+
+static int phy_timer_init(int tn)
+{
+    volatile struct gptimer_regs *gpt = (struct gptimer_regs *) GPTIMER_ADDR;
+
+    if (tn >= (int)(gpt->config & 7)) {
+        return -1;
+    }
+    phytimer = &gpt->timer[tn];
+    phytimer->reload = PHY_TICK_US - 1;
+    /* IP is only set with IE set. The timer interrupt stays masked in the
+     * IRQMP, underflows are polled through IP */
+    phytimer->control = GPTIMER_IP | GPTIMER_IE | GPTIMER_LD | GPTIMER_RS | GPTIMER_EN;
+    return 0;
+}
+
+/* Steps the PHY manager once per timer underflow. Called from the main loop
+ * here, a GPTIMER interrupt handler could call greth_phy_tick() instead. */
+static int phy_poll(void)
+{
+    if (!(phytimer->control & GPTIMER_IP)) {
+        return 0;
+    }
+    phytimer->control = GPTIMER_IP | GPTIMER_IE | GPTIMER_RS | GPTIMER_EN;
+    if (greth_phy_tick(&phy)) {
+        if (phy.link) {
+            printf("Link up, %d Mbps %s duplex\n", phy.speed, phy.duplex ? "full" : "half");
+        } else {
+            printf("Link down\n");
+        }
+    }
+    return 1;
+}
+
+/* Number of frames sent per test */
+#define NFRAMES (1024*1024)
+
+/* Cycle counter in %asr23, enabled through %asr22 */
+static inline unsigned int cycles(void)
+{
+    unsigned int tmp;
+    asm volatile("mov %%asr23, %0" : "=r"(tmp) : );
+    return tmp;
+}
+
+static void speedtest(int size, int burst, unsigned char *buf)
+{
+    int i;
+    int n;
+    unsigned long long frames;
+    unsigned long long cpu;
+    unsigned int c;
+    int sizes[GRETH_TXBD_NUM];
+    char *bufs[GRETH_TXBD_NUM];
+    clock_t t1, t2;
+    double time, bitrate;
+
+    for (i = 0; i < GRETH_TXBD_NUM; i++) {
+        sizes[i] = size;
+        bufs[i] = (char *)buf;
+    }
+
+    cpu = 0;
+    frames = 0;
+    t1 = clock();
+    while(frames < NFRAMES) {
+        n = NFRAMES - frames;
+        if (n > GRETH_TXBD_NUM) {
+            n = GRETH_TXBD_NUM;
+        }
+        c = cycles();
+        /* both return the number of frames queued */
+        if (burst) {
+            n = greth_tx_burst(n, sizes, bufs, &greth);
+        } else {
+            n = greth_tx(size, (char *)buf, &greth);
+        }
+        if (n) {
+            cpu += cycles() - c;
+            frames += n;
+        }
+    }
+    t2 = clock();
+
+    time = (double)(t2 - t1)/CLOCKS_PER_SEC;
+    bitrate = (double)frames*size*8/time;
+    printf("%s %4d byte frames: %f s, %f Mbps, %u cycles/frame\n",
+           burst ? "greth_tx_burst" : "greth_tx      ", size, time,
+           bitrate/(1024*1024), (unsigned int)(cpu/frames));
+}
+
+/* Fills in IPv4 header and UDP checksums of the frame in software */
+static void udp_csum(unsigned char *buf, int size)
+{
+    unsigned int sum;
+    int i;
+    int udplen = size - 34;
+
+    buf[24] = 0;
+    buf[25] = 0;
+    sum = 0;
+    for (i = 14; i < 34; i += 2) {
+        sum += (buf[i] << 8) | buf[i+1];
+    }
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    buf[24] = (~sum >> 8) & 0xFF;
+    buf[25] = ~sum & 0xFF;
+
+    /* pseudo header: addresses, protocol and UDP length */
+    buf[40] = 0;
+    buf[41] = 0;
+    sum = 17 + udplen;
+    for (i = 26; i < 34; i += 2) {
+        sum += (buf[i] << 8) | buf[i+1];
+    }
+    for (i = 34; i < size - 1; i += 2) {
+        sum += (buf[i] << 8) | buf[i+1];
+    }
+    if (udplen & 1) {
+        sum += buf[size-1] << 8;
+    }
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = ~sum & 0xFFFF;
+    if (sum == 0) {
+        sum = 0xFFFF;
+    }
+    buf[40] = (sum >> 8) & 0xFF;
+    buf[41] = sum & 0xFF;
+}
+
+/* Sends UDP frames with the checksums calculated either by the CPU or by
+ * the GRETH_GBIT and reports the CPU cycles spent per frame */
+static void udptest(int size, int offload, unsigned char *buf)
+{
+    int n;
+    unsigned long long frames;
+    unsigned long long cpu;
+    unsigned int c;
+    int iplen = size - 14;
+    int udplen = size - 34;
+
+    /* IPv4 header, 192.168.0.2 -> 192.168.0.1 */
+    buf[12] = 0x08; buf[13] = 0x00;
+    buf[14] = 0x45; buf[15] = 0x00;
+    buf[16] = (iplen >> 8) & 0xFF; buf[17] = iplen & 0xFF;
+    buf[18] = 0; buf[19] = 0; buf[20] = 0x40; buf[21] = 0;
+    buf[22] = 0x40; buf[23] = 0x11;
+    buf[26] = 192; buf[27] = 168; buf[28] = 0; buf[29] = 2;
+    buf[30] = 192; buf[31] = 168; buf[32] = 0; buf[33] = 1;
+    /* UDP header, port 5001 -> 5001 */
+    buf[34] = 0x13; buf[35] = 0x89; buf[36] = 0x13; buf[37] = 0x89;
+    buf[38] = (udplen >> 8) & 0xFF; buf[39] = udplen & 0xFF;
+
+    cpu = 0;
+    frames = 0;
+    while(frames < NFRAMES) {
+        c = cycles();
+        if (offload) {
+            n = greth_tx_csum(size, (char *)buf, GRETH_TXBD_IPCS | GRETH_TXBD_UDPCS, &greth);
+        } else {
+            udp_csum(buf, size);
+            n = greth_tx(size, (char *)buf, &greth);
+        }
+        if (n) {
+            cpu += cycles() - c;
+            frames++;
+        }
+    }
+    printf("UDP %4d byte frames, %s checksums: %u cycles/frame\n", size,
+           offload ? "GRETH" : "CPU  ", (unsigned int)(cpu/frames));
+}
+
+#if GRETH_RXTEST
+static struct greth_rxpool pool;
+
+static void rxtest(void)
+{
+    int i;
+    int n;
+    unsigned long long frames;
+    unsigned long long bytes;
+    struct greth_rxframe rxf[32];
+    clock_t t1, t2;
+    double time;
+
+    if (!greth_rx_pool_init(&pool, GRETH_RXPOOL_BUFS, &greth)) {
+        printf("RX buffer pool allocation failed\n");
+        return;
+    }
+    printf("\nWaiting for %d frames\n", NFRAMES);
+
+    /* Wait for the first frame before starting the clock */
+    while ((n = greth_rx_poll(&pool, rxf, 32)) == 0);
+    frames = n;
+    bytes = 0;
+    t1 = clock();
+    while (1) {
+        for (i = 0; i < n; i++) {
+            bytes += rxf[i].len;
+            greth_rx_release(&pool, rxf[i].buf);
+        }
+        if (frames >= NFRAMES) {
+            break;
+        }
+        n = greth_rx_poll(&pool, rxf, 32);
+        frames += n;
+    }
+    t2 = clock();
+
+    time = (double)(t2 - t1)/CLOCKS_PER_SEC;
+    printf("Received %u frames: %f s, %f Mbps, %u dropped with errors\n",
+           (unsigned int)frames, time, (double)bytes*8/time/(1024*1024), pool.errors);
+}
+#endif
 
 int main(void) {
 
     unsigned long long i;
     unsigned char buf[1514];
-    clock_t t1, t2;
-    unsigned long long datasize;
-    double time, bitrate;
+    unsigned int tmp;
+    unsigned int c;
+    int n;
 
     greth.regs = (greth_regs *) GRETH_ADDR;
 
@@ -86,32 +343,50 @@ int main(void) {
         buf[i] = i;
     }
 
-    greth_init(&greth);
+    /* Start the cycle counter */
+    tmp = ~(1 << 31);
+    asm volatile("mov %0, %%asr22; nop; nop; nop " : : "r"(tmp));
+
+    c = cycles();
+    greth_init_async(&greth, &phy, PHY_RESET_TICKS);
+    printf("GRETH ready after %u cycles, waiting for link\n", cycles() - c);
 
     /* Enable timestamping if requested by user */
     if(GRETH_TIMESTAMPS)
         if(!greth_enable_timestamps(&greth))
             printf("\nTried to enable timestamps for a non-capable GRETH\n");
 
-    printf("\nSending 1500 Mbyte of data to %.02x:%.02x:%.02x:%.02x:%.02x:%.02x\n", buf[0], buf[1], \
+    if (phy_timer_init(PHY_TIMER)) {
+        printf("No GPTIMER timer %d for the PHY manager\n", PHY_TIMER);
+        return 1;
+    }
+    n = 0;
+    while (!phy.link && n < PHY_LINK_TICKS) {
+        n += phy_poll();
+    }
+    if (!phy.link) {
+        printf("No link\n");
+    }
+
+    printf("\nSending %d frames per test to %.02x:%.02x:%.02x:%.02x:%.02x:%.02x\n", NFRAMES, \
+                                                                                    buf[0], buf[1], \
                                                                                     buf[2], buf[3], \
                                                                                     buf[4], buf[5]);
-    t1 = clock();
-    i = 0;
-    while(i < (unsigned long long) 1024*1024) {
-
-        /* greth_tx() returns 1 if a free descriptor is found, otherwise 0 */
-        i += greth_tx(1514, buf, &greth);
+    speedtest(64, 0, buf);
+    speedtest(64, 1, buf);
+    speedtest(1514, 0, buf);
+    speedtest(1514, 1, buf);
 
+    if (greth.gbit) {
+        udptest(64, 0, buf);
+        udptest(64, 1, buf);
+        udptest(1514, 0, buf);
+        udptest(1514, 1, buf);
     }
-    t2 = clock();
-
-    time = (double)(t2 - t1)/CLOCKS_PER_SEC;
-    printf("\nTime: %f\n", time);
 
-    datasize = (unsigned long long)1024*1024*1500*8; /* In bits */
-    bitrate = (double) datasize/time;
-    printf("Bitrate: %f Mbps\n", bitrate/(1024*1024));
+#if GRETH_RXTEST
+    rxtest();
+#endif
 
     return 0;
 }
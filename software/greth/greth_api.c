@@ -14,89 +14,28 @@
 /* 2008-02-01: GRETH API separated from test  - Marko Isomaki */
 /* 2012-09-06: include stdlib.h */
 /* 2013-06-11: Clarify almalloc */
+/* 2026-10-18: Register and DMA memory access through greth_mmio.h */
+/* 2026-10-18: Non-blocking PHY manager, greth_init_async/greth_phy_tick */
 
 #include "greth_api.h"
 #include <stdlib.h>
 
-#ifdef NOELV_SYSTEST
-/* Bypass cache load  */
-static inline int load(addr_t addr)
-{
-    int tmp;
-    asm volatile ("lw %0, 0(%1)"
-    : "=r"(tmp)
-    : "r"(addr)
-    );
-    return tmp;
-}
-
-static inline int save(addr_t addr, unsigned int data)
-{
-    *((volatile unsigned int*)addr) = data;
-}
-
-static inline int saved(addr_t addr, uint64_t data)
-{
-    asm volatile ("sd %0, 0(%1)"
-    : "=r"(data)
-    : "r"(addr)
-    );
-}
-
 /* Allocate memory aligned to the size. Size needs to be a power of two. */
 static char *almalloc(int sz)
 {
-    // NOTE: each descriptor size is 8 bytes: ctrl+addr
-    int descriptor_table_size = sz / 8;
-    char* mem_8aligned;
-    uint32_t* mem_32aligned;
+    uint32_t *mem;
     int i;
-    mem_8aligned = malloc(2 * sz);
-    mem_8aligned = (char*)(((uint32_t)mem_8aligned + sz) & ~(sz - 1));
 
-    /* Initialize, what will be, every ctrl word */
-    mem_32aligned = (uint32_t*)mem_8aligned;
-    for (i = 0; i < descriptor_table_size; ++i) {
-        mem_32aligned[i * 2] = 0;
-        if (i == 0) {
-        }
+    mem = dma_alloc(sz, sz);
+    if (mem == NULL) {
+        return NULL;
     }
-    return(mem_8aligned);
-}
-#else // Leon3
-/* Bypass cache load  */
-static inline int load(int addr)
-{
-    int tmp;
-    asm volatile(" lda [%1]1, %0 "
-    : "=r"(tmp)
-    : "r"(addr)
-    );
-    return tmp;
-}
-
-static inline int save(unsigned int addr, unsigned int data)
-{
-    *((volatile unsigned int *)addr) = data;
-}
-
-/* Allocate memory aligned to the size. Size needs to be a power of two. */
-static char *almalloc(int sz)
-{
-    char* mem_8aligned;
-    int* mem_32aligned;
-    int i;
-    mem_8aligned = malloc(2 * sz);
-    mem_8aligned = (char*)(((int)mem_8aligned + sz) & ~(sz - 1));
-
     /* Initialize, what will be, every ctrl word */
-    mem_32aligned = (int*)mem_8aligned;
     for (i = 0; i < sz / 8; ++i) {
-        mem_32aligned[i * 2] = 0;
+        mem[i * 2] = 0;
     }
-    return(mem_8aligned);
+    return (char *)mem;
 }
-#endif // end ifdef NOELV_SYSTEST
 
 
 int read_mii(int phyaddr, int addr, volatile greth_regs *regs)
@@ -104,18 +43,18 @@ int read_mii(int phyaddr, int addr, volatile greth_regs *regs)
     unsigned int tmp;
 
     do {
-        tmp = load((addr_t)&(regs->mdio));
+        tmp = mmio_load32((addr_t)&(regs->mdio));
     } while (tmp & GRETH_MII_BUSY);
 
     tmp = (phyaddr << 11) | ((addr & 0x1F) << 6) | 2;
-    save((addr_t)&(regs->mdio), tmp);
+    mmio_store32((addr_t)&(regs->mdio), tmp);
 
     do {
-        tmp = load((addr_t)&(regs->mdio));
+        tmp = mmio_load32((addr_t)&(regs->mdio));
     } while (tmp & GRETH_MII_BUSY);
 
     if (!(tmp & GRETH_MII_NVALID)) {
-        tmp = load((addr_t)&(regs->mdio));
+        tmp = mmio_load32((addr_t)&(regs->mdio));
         return (tmp >> 16) & 0xFFFF;
     } else {
         return -1;
@@ -127,15 +66,15 @@ void write_mii(int phyaddr, int addr, int data, volatile greth_regs *regs)
     unsigned int tmp;
 
     do {
-        tmp = load((addr_t)&(regs->mdio));
+        tmp = mmio_load32((addr_t)&(regs->mdio));
     } while (tmp & GRETH_MII_BUSY);
 
     tmp = ((data & 0xFFFF) << 16) | (phyaddr << 11) | ((addr & 0x1F) << 6) | 1;
 
-    save((addr_t)&regs->mdio, tmp);
+    mmio_store32((addr_t)&regs->mdio, tmp);
 
     do {
-        tmp = load((addr_t)&(regs->mdio));
+        tmp = mmio_load32((addr_t)&(regs->mdio));
     } while (tmp & GRETH_MII_BUSY);
 
 }
@@ -148,51 +87,63 @@ int greth_set_mac_address(struct greth_info *greth, unsigned char *addr)
     greth->esa[3] = addr[3];
     greth->esa[4] = addr[4];
     greth->esa[5] = addr[5];
-    save((addr_t)&greth->regs->esa_msb, addr[0] << 8 | addr[1]);
-    save((addr_t)&greth->regs->esa_lsb, addr[2] << 24 | addr[3] << 16 | addr[4] << 8 | addr[5]);
+    mmio_store32((addr_t)&greth->regs->esa_msb, addr[0] << 8 | addr[1]);
+    mmio_store32((addr_t)&greth->regs->esa_lsb, addr[2] << 24 | addr[3] << 16 | addr[4] << 8 | addr[5]);
     return 1;
 }
 
-int greth_init(struct greth_info *greth)
+/* Controller reset and descriptor setup shared by greth_init() and
+ * greth_init_async() */
+static int greth_init_mac(struct greth_info *greth)
 {
     unsigned int tmp;
-    int i;
-    int duplex, speed;
-    int gbit;
 
-    tmp = load((addr_t)&greth->regs->control);
+    tmp = mmio_load32((addr_t)&greth->regs->control);
     greth->gbit = (tmp >> 27) & 1;
     greth->edcl = (tmp >> 31) & 1;
     greth->timestamps = (tmp >> GRETH_CTRL_TS_CAPABLE_BIT) & 1;
+    greth->tsen = 0;
     greth->edclen = ((tmp >> 14) & 1) ^ 1;
 
     if (greth->edcl == 0) {
         /* Reset the controller. */
-        save((addr_t)&greth->regs->control, GRETH_RESET);
+        mmio_store32((addr_t)&greth->regs->control, GRETH_RESET);
         do {
-            tmp = load((addr_t)&greth->regs->control);
+            tmp = mmio_load32((addr_t)&greth->regs->control);
         } while (tmp & GRETH_RESET);
     }
 
     /* Get the phy address which assumed to have been set
      * correctly with the reset value in hardware
      */
-    tmp = load((addr_t)&greth->regs->mdio);
+    tmp = mmio_load32((addr_t)&greth->regs->mdio);
     greth->phyaddr = ((tmp >> 11) & 0x1F);
 
     greth->txd = (struct descriptor *) almalloc(1024); // Orig: 1024
     greth->rxd = (struct descriptor *) almalloc(1024); // Orig: 1024
-#ifdef NOELV_SYSTEST
-    save((greth_reg_t)&(greth->regs->tx_desc_p), (greth_reg_t) greth->txd);
-    save((greth_reg_t)&(greth->regs->rx_desc_p), (greth_reg_t) greth->rxd);
-#else
-    save((int)&(greth->regs->tx_desc_p), (unsigned int) greth->txd);
-    save((int)&(greth->regs->rx_desc_p), (unsigned int) greth->rxd);
-#endif
+    /* The descriptor pointers are 32 bits wide */
+    if (!dma_addr(greth->txd) || !dma_addr(greth->rxd)) {
+        return 0;
+    }
+    mmio_store32((addr_t)&(greth->regs->tx_desc_p), dma_addr(greth->txd));
+    mmio_store32((addr_t)&(greth->regs->rx_desc_p), dma_addr(greth->rxd));
     greth->txpnt = 0;
     greth->rxpnt = 0;
     greth->txchkpnt = 0;
     greth->rxchkpnt = 0;
+    return 1;
+}
+
+int greth_init(struct greth_info *greth)
+{
+    unsigned int tmp;
+    int i;
+    int duplex, speed;
+    int gbit;
+
+    if (!greth_init_mac(greth)) {
+        return 0;
+    }
 
     /* Reset PHY */
     if (greth->edcl == 0 || greth->edclen == 0) {
@@ -225,12 +176,12 @@ int greth_init(struct greth_info *greth)
            write_mii(greth->phyaddr, 0x9, 0x0000 , greth->regs);
         }
 
-        save((addr_t)&greth->regs->control, ((greth->edclen^1) << 14) | (duplex << 4) | (speed << 7) | (gbit << 8));
+        mmio_store32((addr_t)&greth->regs->control, ((greth->edclen^1) << 14) | (duplex << 4) | (speed << 7) | (gbit << 8));
     } else {
         /* Wait for edcl phy initialisation to finish */
         i = 0;
         while (i < 3) {
-            tmp = load((addr_t)&greth->regs->mdio);
+            tmp = mmio_load32((addr_t)&greth->regs->mdio);
             if ((tmp >> 3) & 1) {
                 i = 0;
             } else {
@@ -243,66 +194,277 @@ int greth_init(struct greth_info *greth)
     //        (unsigned int)(greth->regs),  \
     //        (speed == 0x2000) ? 100:10, duplex ? "full":"half");
     greth_set_mac_address(greth, greth->esa);
+    return 1;
+}
+
+/* Starts an MDIO operation without waiting for it, the interface must be idle */
+static void greth_mdio_start(struct greth_phy *phy, int addr, int write, int data)
+{
+    unsigned int tmp;
+
+    tmp = ((data & 0xFFFF) << 16) | (phy->greth->phyaddr << 11) | ((addr & 0x1F) << 6);
+    mmio_store32((addr_t)&phy->greth->regs->mdio, tmp | (write ? 1 : 2));
+    phy->reg = write ? -1 : addr;
+}
+
+/* Speed and duplex from the registers read in GRETH_PHY_RESOLVE */
+static void greth_phy_resolve(struct greth_phy *phy)
+{
+    int *mii = phy->mii;
+    int common;
+
+    if (mii[0] & 0x1000) {
+        common = mii[4] & mii[5];
+        if (phy->greth->gbit && (mii[9] & GRETH_MII_EXTADV_1000FD) &&
+            (mii[10] & GRETH_MII_EXTPRT_1000FD)) {
+            phy->speed = 1000; phy->duplex = 1;
+        } else if (phy->greth->gbit && (mii[9] & GRETH_MII_EXTADV_1000HD) &&
+                   (mii[10] & GRETH_MII_EXTPRT_1000HD)) {
+            phy->speed = 1000; phy->duplex = 0;
+        } else if (common & GRETH_MII_100TXFD) {
+            phy->speed = 100; phy->duplex = 1;
+        } else if (common & GRETH_MII_100TXHD) {
+            phy->speed = 100; phy->duplex = 0;
+        } else if (common & GRETH_MII_10FD) {
+            phy->speed = 10; phy->duplex = 1;
+        } else {
+            phy->speed = 10; phy->duplex = 0;
+        }
+    } else {
+        if (phy->greth->gbit && !((mii[0] >> 13) & 1) && ((mii[0] >> 6) & 1)) {
+            phy->speed = 1000;
+        } else if (((mii[0] >> 13) & 1) && !((mii[0] >> 6) & 1)) {
+            phy->speed = 100;
+        } else {
+            phy->speed = 10;
+        }
+        phy->duplex = (mii[0] >> 8) & 1;
+    }
+}
+
+int greth_init_async(struct greth_info *greth, struct greth_phy *phy, unsigned int timeout)
+{
+    if (!greth_init_mac(greth)) {
+        return 0;
+    }
+
+    phy->greth = greth;
+    phy->reg = -1;
+    phy->step = 0;
+    phy->ticks = 0;
+    phy->timeout = timeout;
+    phy->link = 0;
+    phy->speed = 10;
+    phy->duplex = 0;
+    /* Assume auto-negotiation until the PHY control register has been read */
+    phy->mii[0] = 0x1000;
+
+    if (greth->edcl == 0 || greth->edclen == 0) {
+        /* 10 Mbit half duplex until the link has been resolved */
+        mmio_store32((addr_t)&greth->regs->control, (greth->edclen^1) << 14);
+        greth_mdio_start(phy, 0, 1, 0x8000);
+        phy->state = GRETH_PHY_RESET;
+    } else {
+        /* The EDCL owns the PHY setup, only follow the link */
+        phy->state = GRETH_PHY_ANEG;
+    }
+    greth_set_mac_address(greth, greth->esa);
+    return 1;
+}
+
+int greth_phy_tick(struct greth_phy *phy)
+{
+    static const int resolve[] = {0, 4, 5, 9, 10};
+    struct greth_info *greth = phy->greth;
+    unsigned int tmp;
+    int reg, val;
+
+    tmp = mmio_load32((addr_t)&greth->regs->mdio);
+    if (tmp & GRETH_MII_BUSY) {
+        return 0;
+    }
+    phy->ticks++;
+    reg = phy->reg;
+    phy->reg = -1;
+    val = (tmp & GRETH_MII_NVALID) ? -1 : (tmp >> 16) & 0xFFFF;
+
+    switch (phy->state) {
+    case GRETH_PHY_RESET:
+        if ((reg == 0 && val >= 0 && !(val & 0x8000)) || phy->ticks > phy->timeout) {
+            if (reg == 0 && val >= 0) {
+                phy->mii[0] = val;
+            }
+            phy->state = GRETH_PHY_ANEG;
+            phy->ticks = 0;
+            /* Disable Gbit PHY if Gigabit GRETH isn't included */
+            if (!greth->gbit) {
+                greth_mdio_start(phy, 0x9, 1, 0x0000);
+                return 0;
+            }
+        }
+        greth_mdio_start(phy, phy->state == GRETH_PHY_RESET ? 0 : 1, 0, 0);
+        return 0;
+
+    case GRETH_PHY_ANEG:
+        /* Link up and, when enabled, auto-negotiation complete */
+        if (reg == 1 && val >= 0 && (val & 0x04) &&
+            ((val & 0x20) || !(phy->mii[0] & 0x1000))) {
+            phy->state = GRETH_PHY_RESOLVE;
+            phy->step = 0;
+            greth_mdio_start(phy, resolve[0], 0, 0);
+        } else {
+            greth_mdio_start(phy, 1, 0, 0);
+        }
+        return 0;
+
+    case GRETH_PHY_RESOLVE:
+        if (reg != resolve[phy->step] || val < 0) {
+            /* Read failed, start over */
+            phy->state = GRETH_PHY_ANEG;
+            greth_mdio_start(phy, 1, 0, 0);
+            return 0;
+        }
+        phy->mii[reg] = val;
+        phy->step++;
+        if (phy->step < (greth->gbit ? 5 : 3)) {
+            greth_mdio_start(phy, resolve[phy->step], 0, 0);
+            return 0;
+        }
+        greth_phy_resolve(phy);
+        tmp = mmio_load32((addr_t)&greth->regs->control) & ~(GRETH_FD | GRETH_CTRL_SP | GRETH_CTRL_GB);
+        if (phy->duplex) {
+            tmp |= GRETH_FD;
+        }
+        if (phy->speed == 100) {
+            tmp |= GRETH_CTRL_SP;
+        } else if (phy->speed == 1000) {
+            tmp |= GRETH_CTRL_GB;
+        }
+        mmio_store32((addr_t)&greth->regs->control, tmp);
+        phy->state = GRETH_PHY_UP;
+        phy->link = 1;
+        phy->ticks = 0;
+        greth_mdio_start(phy, 1, 0, 0);
+        return 1;
 
+    case GRETH_PHY_UP:
+        if (reg == 1 && (val < 0 || !(val & 0x04))) {
+            phy->state = GRETH_PHY_ANEG;
+            phy->link = 0;
+            phy->ticks = 0;
+            greth_mdio_start(phy, 1, 0, 0);
+            return 1;
+        }
+        greth_mdio_start(phy, 1, 0, 0);
+        return 0;
+    }
+    return 0;
 }
 
 inline int greth_tx(int size, char *buf, struct greth_info *greth)
+{
+    return greth_tx_csum(size, buf, 0, greth);
+}
+
+inline int greth_tx_csum(int size, char *buf, unsigned int csum, struct greth_info *greth)
 {
     int timestamps_enabled;
     volatile struct descriptor_timestamps *descriptors_ts;
 
-    timestamps_enabled = load((addr_t)&(greth->regs->control)) &
-                              (1u << GRETH_CTRL_TS_ENABLE_BIT);
+    timestamps_enabled = greth->tsen;
+    csum &= GRETH_TXBD_CSUM;
 
     if (timestamps_enabled) {
         descriptors_ts = (struct descriptors_timestamps *) greth->txd;
 
-        if ((load((addr_t)&(descriptors_ts[greth->txpnt].ctrl)) >> 11) & 1) {
+        if ((mmio_load32((addr_t)&(descriptors_ts[greth->txpnt].ctrl)) >> 11) & 1) {
             return 0;
         }
 
-        descriptors_ts[greth->txpnt].addr = (greth_reg_t)buf;
+        descriptors_ts[greth->txpnt].addr = dma_addr(buf);
+        mmio_wmb();
         if (greth->txpnt == GRETH_TXBD_NUM_TS - 1) {
-            descriptors_ts[greth->txpnt].ctrl = GRETH_BD_WR | GRETH_BD_EN | size;
+            descriptors_ts[greth->txpnt].ctrl = GRETH_BD_WR | GRETH_BD_EN | csum | size;
             greth->txpnt = 0u;
         } else {
-            descriptors_ts[greth->txpnt].ctrl = GRETH_BD_EN | size;
+            descriptors_ts[greth->txpnt].ctrl = GRETH_BD_EN | csum | size;
             greth->txpnt++;
         }
     } else {
-        if ((load((addr_t)&(greth->txd[greth->txpnt].ctrl)) >> 11) & 1) {
+        if ((mmio_load32((addr_t)&(greth->txd[greth->txpnt].ctrl)) >> 11) & 1) {
             return 0;
         }
 
-        greth->txd[greth->txpnt].addr = (greth_reg_t)buf;
+        greth->txd[greth->txpnt].addr = dma_addr(buf);
+        mmio_wmb();
         if (greth->txpnt == GRETH_TXBD_NUM - 1) {
-            greth->txd[greth->txpnt].ctrl = GRETH_BD_WR | GRETH_BD_EN | size;
+            greth->txd[greth->txpnt].ctrl = GRETH_BD_WR | GRETH_BD_EN | csum | size;
             greth->txpnt = 0u;
         } else {
-            greth->txd[greth->txpnt].ctrl = GRETH_BD_EN | size;
+            greth->txd[greth->txpnt].ctrl = GRETH_BD_EN | csum | size;
             greth->txpnt++;
         }
     }
 
-    greth->regs->control = load((addr_t)&(greth->regs->control)) | GRETH_TXEN; // Original
+    mmio_wmb();
+    greth->regs->control = mmio_load32((addr_t)&(greth->regs->control)) | GRETH_TXEN; // Original
     return 1;
 }
 
+inline int greth_tx_burst(int n, int *size, char **buf, struct greth_info *greth)
+{
+    int i;
+    unsigned int num;
+    unsigned int stride;
+    volatile struct descriptor *d;
+
+    /* Timestamp descriptors are twice as large, step over them as pairs */
+    if (greth->tsen) {
+        num = GRETH_TXBD_NUM_TS;
+        stride = 2;
+    } else {
+        num = GRETH_TXBD_NUM;
+        stride = 1;
+    }
+
+    for (i = 0; i < n; i++) {
+        d = &greth->txd[greth->txpnt * stride];
+        if ((mmio_load32((addr_t)&(d->ctrl)) >> 11) & 1) {
+            break;
+        }
+        d->addr = dma_addr(buf[i]);
+        mmio_wmb();
+        if (greth->txpnt == num - 1) {
+            d->ctrl = GRETH_BD_WR | GRETH_BD_EN | size[i];
+            greth->txpnt = 0u;
+        } else {
+            d->ctrl = GRETH_BD_EN | size[i];
+            greth->txpnt++;
+        }
+    }
+
+    if (i) {
+        mmio_wmb();
+        greth->regs->control = mmio_load32((addr_t)&(greth->regs->control)) | GRETH_TXEN;
+    }
+    return i;
+}
+
 inline int greth_rx(char *buf, struct greth_info *greth)
 {
     int timestamps_enabled;
     volatile struct descriptor_timestamps *descriptors_ts;
 
-    timestamps_enabled = load((addr_t)&(greth->regs->control)) &
-                              (1u << GRETH_CTRL_TS_ENABLE_BIT);
+    timestamps_enabled = greth->tsen;
 
     if(timestamps_enabled) {
         descriptors_ts = (struct descriptors_timestamps *) greth->rxd;
 
-        if (((load((addr_t)&(descriptors_ts[greth->rxpnt].ctrl)) >> 11) & 1)) {
+        if (((mmio_load32((addr_t)&(descriptors_ts[greth->rxpnt].ctrl)) >> 11) & 1)) {
             return 0;
         }
-        descriptors_ts[greth->rxpnt].addr = (greth_reg_t)buf;
+        descriptors_ts[greth->rxpnt].addr = dma_addr(buf);
+        mmio_wmb();
         if (greth->rxpnt == GRETH_RXBD_NUM_TS - 1) {
             descriptors_ts[greth->rxpnt].ctrl = GRETH_BD_WR | GRETH_BD_EN;
             greth->rxpnt = 0;
@@ -311,10 +473,11 @@ inline int greth_rx(char *buf, struct greth_info *greth)
             greth->rxpnt++;
         }
     } else {
-        if (((load((addr_t)&(greth->rxd[greth->rxpnt].ctrl)) >> 11) & 1)) {
+        if (((mmio_load32((addr_t)&(greth->rxd[greth->rxpnt].ctrl)) >> 11) & 1)) {
             return 0;
         }
-        greth->rxd[greth->rxpnt].addr = (greth_reg_t)buf;
+        greth->rxd[greth->rxpnt].addr = dma_addr(buf);
+        mmio_wmb();
         if (greth->rxpnt == GRETH_RXBD_NUM - 1) {
             greth->rxd[greth->rxpnt].ctrl = GRETH_BD_WR | GRETH_BD_EN;
             greth->rxpnt = 0;
@@ -324,27 +487,170 @@ inline int greth_rx(char *buf, struct greth_info *greth)
         }
     }
 
-    greth->regs->control = load((addr_t)&(greth->regs->control)) | GRETH_RXEN; // Original
+    mmio_wmb();
+    greth->regs->control = mmio_load32((addr_t)&(greth->regs->control)) | GRETH_RXEN; // Original
     return 1;
 }
 
+/* Hardware timestamp of a timestamp descriptor */
+static unsigned long long greth_ts(volatile struct descriptor_timestamps *d)
+{
+    unsigned int msb, lsb;
+
+    msb = mmio_load32((addr_t)&(d->ts_msb));
+    lsb = mmio_load32((addr_t)&(d->ts_lsb));
+    return ((unsigned long long)msb << 32) | lsb;
+}
+
+int greth_rx_pool_init(struct greth_rxpool *pool, int nbufs, struct greth_info *greth)
+{
+    int i;
+    char *mem;
+
+    if (nbufs <= 0 || nbufs > GRETH_RXPOOL_BUFS) {
+        return 0;
+    }
+    mem = malloc(nbufs * GRETH_RX_BUF_SIZE + GRETH_CACHE_LINE);
+    if (mem == NULL) {
+        return 0;
+    }
+    mem = (char *)(((addr_t)mem + GRETH_CACHE_LINE - 1) & ~(addr_t)(GRETH_CACHE_LINE - 1));
+
+    pool->greth = greth;
+    pool->armed = 0;
+    pool->errors = 0;
+    pool->nfree = 0;
+    for (i = nbufs - 1; i >= 0; i--) {
+        pool->free[pool->nfree++] = &mem[i * GRETH_RX_BUF_SIZE];
+    }
+    greth->rxpnt = 0;
+    greth->rxchkpnt = 0;
+    greth_rx_poll(pool, NULL, 0);
+    return 1;
+}
+
+/* Arms free descriptors with free buffers and enables the receiver once */
+static void greth_rx_refill(struct greth_rxpool *pool)
+{
+    struct greth_info *greth = pool->greth;
+    unsigned int num, stride;
+    volatile struct descriptor *d;
+    char *buf;
+    int n;
+
+    if (greth->tsen) {
+        num = GRETH_RXBD_NUM_TS;
+        stride = 2;
+    } else {
+        num = GRETH_RXBD_NUM;
+        stride = 1;
+    }
+
+    n = 0;
+    while (pool->nfree && pool->armed < num) {
+        buf = pool->free[--pool->nfree];
+        pool->bd[greth->rxpnt] = buf;
+        d = &greth->rxd[greth->rxpnt * stride];
+        d->addr = dma_addr(buf);
+        mmio_wmb();
+        if (greth->rxpnt == num - 1) {
+            d->ctrl = GRETH_BD_WR | GRETH_BD_EN;
+            greth->rxpnt = 0;
+        } else {
+            d->ctrl = GRETH_BD_EN;
+            greth->rxpnt++;
+        }
+        pool->armed++;
+        n++;
+    }
+
+    if (n) {
+        mmio_wmb();
+        greth->regs->control = mmio_load32((addr_t)&(greth->regs->control)) | GRETH_RXEN;
+    }
+}
+
+int greth_rx_poll(struct greth_rxpool *pool, struct greth_rxframe *frames, int budget)
+{
+    struct greth_info *greth = pool->greth;
+    unsigned int num, stride;
+    unsigned int tmp;
+    volatile struct descriptor *d;
+    char *buf;
+    int n;
+
+    if (greth->tsen) {
+        num = GRETH_RXBD_NUM_TS;
+        stride = 2;
+    } else {
+        num = GRETH_RXBD_NUM;
+        stride = 1;
+    }
+
+    n = 0;
+    while (n < budget && pool->armed) {
+        d = &greth->rxd[greth->rxchkpnt * stride];
+        tmp = mmio_load32((addr_t)&(d->ctrl));
+        if (tmp & GRETH_BD_EN) {
+            break;
+        }
+        mmio_rmb();
+        buf = pool->bd[greth->rxchkpnt];
+        if (greth->rxchkpnt == num - 1) {
+            greth->rxchkpnt = 0;
+        } else {
+            greth->rxchkpnt++;
+        }
+        pool->armed--;
+        if (tmp & GRETH_RXBD_ERR) {
+            pool->errors++;
+            pool->free[pool->nfree++] = buf;
+            continue;
+        }
+        frames[n].buf = buf;
+        frames[n].len = tmp & GRETH_BD_LEN;
+        frames[n].status = tmp & GRETH_RXBD_STATUS;
+        frames[n].ts = greth->tsen ? greth_ts((volatile struct descriptor_timestamps *)d) : 0;
+        n++;
+    }
+
+    greth_rx_refill(pool);
+    return n;
+}
+
+void greth_rx_release(struct greth_rxpool *pool, char *buf)
+{
+    pool->free[pool->nfree++] = buf;
+}
+
+void greth_rx_decode(unsigned int status, struct rxstatus *rxs)
+{
+    rxs->status = status & GRETH_RXBD_STATUS;
+    rxs->ipcs = !(status & GRETH_RXBD_IP_DEC) ? GRETH_CS_NONE :
+                (status & GRETH_RXBD_IP_CSERR) ? GRETH_CS_ERR : GRETH_CS_OK;
+    rxs->udpcs = !(status & GRETH_RXBD_UDP_DEC) ? GRETH_CS_NONE :
+                 (status & GRETH_RXBD_UDP_CSERR) ? GRETH_CS_ERR : GRETH_CS_OK;
+    rxs->tcpcs = !(status & GRETH_RXBD_TCP_DEC) ? GRETH_CS_NONE :
+                 (status & GRETH_RXBD_TCP_CSERR) ? GRETH_CS_ERR : GRETH_CS_OK;
+}
+
 inline int greth_checkrx(int *size, struct rxstatus *rxs, struct greth_info *greth)
 {
     int tmp;
     int timestamps_enabled;
     volatile struct descriptor_timestamps *descriptors_ts;
 
-    timestamps_enabled = load((addr_t)&(greth->regs->control)) &
-                              (1u << GRETH_CTRL_TS_ENABLE_BIT);
+    timestamps_enabled = greth->tsen;
 
     if (timestamps_enabled) {
         descriptors_ts = (struct descriptors_timestamps *) greth->rxd;
-        tmp = load((addr_t)&(descriptors_ts[greth->rxchkpnt].ctrl));
+        tmp = mmio_load32((addr_t)&(descriptors_ts[greth->rxchkpnt].ctrl));
     } else {
-        tmp = load((addr_t)&(greth->rxd[greth->rxchkpnt].ctrl));
+        tmp = mmio_load32((addr_t)&(greth->rxd[greth->rxchkpnt].ctrl));
     }
     if (!((tmp >> 11) & 1)) { // Check Enable bit
         *size = tmp & GRETH_BD_LEN; // Get number of bytes received (10 downto 0)
+        greth_rx_decode(tmp, rxs);
         if (tmp & GRETH_BD_WR) { // Descriptor is indicating to wrap.
             greth->rxchkpnt = 0;
         } else {
@@ -362,14 +668,13 @@ inline int greth_checktx(struct greth_info *greth)
     int timestamps_enabled;
     volatile struct descriptor_timestamps *descriptors_ts;
 
-    timestamps_enabled = load((addr_t)&(greth->regs->control)) &
-                              (1u << GRETH_CTRL_TS_ENABLE_BIT);
+    timestamps_enabled = greth->tsen;
 
     if (timestamps_enabled) {
-        descriptors_ts = (struct descriptors_timestamps *) greth->rxd;
-        tmp = load((addr_t)&(descriptors_ts[greth->txchkpnt].ctrl));
+        descriptors_ts = (struct descriptors_timestamps *) greth->txd;
+        tmp = mmio_load32((addr_t)&(descriptors_ts[greth->txchkpnt].ctrl));
     } else {
-        tmp = load((addr_t)&(greth->txd[greth->txchkpnt].ctrl));
+        tmp = mmio_load32((addr_t)&(greth->txd[greth->txchkpnt].ctrl));
     }
     if (!((tmp >> 11) & 1)) {
         if (tmp & GRETH_BD_WR) { /* Descriptor indicates to wrap */
@@ -383,10 +688,35 @@ inline int greth_checktx(struct greth_info *greth)
     }
 }
 
+int greth_checkrx_ts(int *size, struct rxstatus *rxs, unsigned long long *ts, struct greth_info *greth)
+{
+    volatile struct descriptor_timestamps *d;
+
+    d = (struct descriptor_timestamps *) greth->rxd + greth->rxchkpnt;
+    if (!greth_checkrx(size, rxs, greth)) {
+        return 0;
+    }
+    *ts = greth->tsen ? greth_ts(d) : 0;
+    return 1;
+}
+
+int greth_checktx_ts(unsigned long long *ts, struct greth_info *greth)
+{
+    volatile struct descriptor_timestamps *d;
+
+    d = (struct descriptor_timestamps *) greth->txd + greth->txchkpnt;
+    if (!greth_checktx(greth)) {
+        return 0;
+    }
+    *ts = greth->tsen ? greth_ts(d) : 0;
+    return 1;
+}
+
 inline int greth_enable_timestamps(struct greth_info *greth)
 {
     unsigned int tmp;
-    tmp = load((addr_t)&(greth->regs->control));
-    save((addr_t)&(greth->regs->control), tmp | (1 << GRETH_CTRL_TS_ENABLE_BIT));
+    tmp = mmio_load32((addr_t)&(greth->regs->control));
+    mmio_store32((addr_t)&(greth->regs->control), tmp | (1 << GRETH_CTRL_TS_ENABLE_BIT));
+    greth->tsen = (tmp >> GRETH_CTRL_TS_CAPABLE_BIT) & 1;
     return (tmp >> GRETH_CTRL_TS_CAPABLE_BIT) & 1;
 }
@@ -29,6 +29,7 @@
 #define GRETH_TXBD_IPCS 0x40000
 #define GRETH_TXBD_TCPCS 0x80000
 #define GRETH_TXBD_UDPCS 0x100000
+#define GRETH_TXBD_CSUM (GRETH_TXBD_IPCS | GRETH_TXBD_TCPCS | GRETH_TXBD_UDPCS)
 #define GRETH_TXBD_ERR_LC 0x10000
 #define GRETH_TXBD_ERR_UE 0x4000
 #define GRETH_TXBD_ERR_AL 0x8000
@@ -60,26 +61,36 @@
 #define GRETH_RXBD_NUM_MASK (GRETH_RXBD_NUM-1)
 #define GRETH_RX_BUF_SIZE 2048
 
+/* RX buffer pool, twice as many buffers as descriptors so that the ring
+ * can be re-armed while received frames are still held by the caller */
+#define GRETH_RXPOOL_BUFS (2 * GRETH_RXBD_NUM)
+#define GRETH_CACHE_LINE 64
+#define GRETH_RXBD_ERR (GRETH_RXBD_ERR_AE | GRETH_RXBD_ERR_FT | GRETH_RXBD_ERR_CRC | \
+                        GRETH_RXBD_ERR_OE | GRETH_RXBD_ERR_LE)
+
 #define GRETH_CTRL_TS_CAPABLE_BIT 23
 #define GRETH_CTRL_TS_ENABLE_BIT 15
+#define GRETH_CTRL_SP 0x80
+#define GRETH_CTRL_GB 0x100
 
-#ifdef NOELV_SYSTEST
-#include <stdint.h>
+/* States of the non-blocking PHY manager */
+#define GRETH_PHY_RESET   0      /* PHY reset issued, waiting for it to finish */
+#define GRETH_PHY_ANEG    1      /* Waiting for link and auto-negotiation */
+#define GRETH_PHY_RESOLVE 2      /* Reading the negotiated speed and duplex */
+#define GRETH_PHY_UP      3      /* Link up, polling for link loss */
 
-typedef uint64_t addr_t;
+#include "greth_mmio.h"
+
+#ifdef NOELV_SYSTEST
+typedef uint64_t addr_t;         /* Same as report.h of the NOEL-V system test */
+#else
+typedef uintptr_t addr_t;
+#endif
 typedef uint32_t greth_reg_t;
 typedef uint32_t descrptr_t;
 typedef uint32_t descrctrl_t;
 typedef uint32_t descraddr_t;
 typedef uint32_t descrts_t; /* timestamp component */
-#else
-typedef int addr_t;
-typedef int greth_reg_t;
-typedef int descrptr_t;
-typedef int descrctrl_t;
-typedef int descraddr_t;
-typedef int descrts_t; /* timestamp component */
-#endif
 
 /* Ethernet configuration registers */
 typedef struct _greth_regs {
@@ -113,9 +124,38 @@ struct descriptor_timestamps
     volatile descrts_t ts_lsb;
 };
 
+/* Checksum verdicts, only GRETH_GBIT decodes and checks checksums */
+#define GRETH_CS_NONE 0          /* Not an IP/UDP/TCP frame, not checked */
+#define GRETH_CS_OK 1
+#define GRETH_CS_ERR 2
+
 struct rxstatus
 {
+    unsigned int status;         /* GRETH_RXBD_STATUS bits of the descriptor */
+    int ipcs;
+    int udpcs;
+    int tcpcs;
+};
+
+/* Frame handed out by greth_rx_poll() */
+struct greth_rxframe
+{
+    char *buf;
+    int len;
+    unsigned int status;         /* GRETH_RXBD_STATUS bits of the descriptor */
+    unsigned long long ts;       /* Receive timestamp, 0 unless timestamps are enabled */
+};
+
+struct greth_info;
 
+struct greth_rxpool
+{
+    struct greth_info *greth;
+    unsigned int armed;          /* Descriptors armed and not yet polled */
+    unsigned int nfree;
+    unsigned int errors;         /* Frames dropped due to receive errors */
+    char *free[GRETH_RXPOOL_BUFS];
+    char *bd[GRETH_RXBD_NUM];    /* Buffer armed in each descriptor */
 };
 
 struct greth_info {
@@ -127,6 +167,7 @@ struct greth_info {
     unsigned int edcl;
     unsigned int edclen;
     unsigned int timestamps;
+    unsigned int tsen;           /* Timestamp descriptors enabled, cached control bit */
 
     struct descriptor *txd;
     struct descriptor *rxd;
@@ -137,6 +178,21 @@ struct greth_info {
 
 };
 
+/* PHY manager stepped by greth_phy_tick(), one MDIO operation per tick */
+struct greth_phy
+{
+    struct greth_info *greth;
+    int state;
+    int reg;                     /* MII register being read, -1 if none */
+    int step;
+    unsigned int ticks;          /* Ticks spent in the current state */
+    unsigned int timeout;        /* Ticks allowed for the PHY reset */
+    int mii[16];                 /* Registers read when resolving the link */
+    int link;
+    int speed;                   /* 10, 100 or 1000 */
+    int duplex;
+};
+
 int read_mii(int phyaddr, int addr, volatile greth_regs *regs);
 
 void write_mii(int phyaddr, int addr, int data, volatile greth_regs *regs);
@@ -145,12 +201,58 @@ int greth_set_mac_address(struct greth_info *greth, unsigned char *addr);
 
 int greth_init(struct greth_info *greth);
 
+/* Same as greth_init() but returns without waiting for the PHY. The PHY is
+ * reset and the link followed by calling greth_phy_tick() periodically, for
+ * example from a GPTIMER interrupt or poll loop. timeout is the number of
+ * ticks allowed for the PHY reset. */
+int greth_init_async(struct greth_info *greth, struct greth_phy *phy, unsigned int timeout);
+
+/* Advances the PHY manager by at most one MDIO operation and never waits.
+ * Speed and duplex in the control register are updated when the link comes
+ * up. Returns 1 when phy->link changed, otherwise 0. */
+int greth_phy_tick(struct greth_phy *phy);
+
 int greth_tx(int size, char *buf, struct greth_info *greth);
 
+/* Transmits one frame and requests the checksums given by csum
+ * (GRETH_TXBD_IPCS, GRETH_TXBD_TCPCS, GRETH_TXBD_UDPCS) to be inserted by
+ * the GRETH_GBIT. Returns 1 if a free descriptor was found, otherwise 0. */
+int greth_tx_csum(int size, char *buf, unsigned int csum, struct greth_info *greth);
+
+/* Queues up to n frames and enables the transmitter once.
+ * Returns the number of frames queued. */
+int greth_tx_burst(int n, int *size, char **buf, struct greth_info *greth);
+
 int greth_rx(char *buf, struct greth_info *greth);
 
+/* Allocates nbufs cache line aligned receive buffers, at most
+ * GRETH_RXPOOL_BUFS, and arms the receive ring with them. The pool owns the
+ * receive ring, greth_rx()/greth_checkrx() must not be used together with it.
+ * Returns 1 on success, 0 on failure. */
+int greth_rx_pool_init(struct greth_rxpool *pool, int nbufs, struct greth_info *greth);
+
+/* Returns up to budget received frames without copying. Frames with receive
+ * errors are recycled directly. Buffers are handed back with
+ * greth_rx_release() and are re-armed on the next poll. The frame data is
+ * written by DMA, read it with dma_load8()/dma_load32(). */
+int greth_rx_poll(struct greth_rxpool *pool, struct greth_rxframe *frames, int budget);
+
+void greth_rx_release(struct greth_rxpool *pool, char *buf);
+
+/* Decodes descriptor status bits into checksum verdicts, also usable
+ * on the status of frames from greth_rx_poll() */
+void greth_rx_decode(unsigned int status, struct rxstatus *rxs);
+
 int greth_checkrx(int *size, struct rxstatus *rxs, struct greth_info *greth);
 
 int greth_checktx(struct greth_info *greth);
 
+/* Same as greth_checkrx()/greth_checktx() but also return the hardware
+ * timestamp of the frame, ts_msb in the upper and ts_lsb in the lower 32
+ * bits. The timestamp unit is given by the timestamp input of the GRETH.
+ * *ts is set to 0 when timestamps are not enabled. */
+int greth_checkrx_ts(int *size, struct rxstatus *rxs, unsigned long long *ts, struct greth_info *greth);
+
+int greth_checktx_ts(unsigned long long *ts, struct greth_info *greth);
+
 int greth_enable_timestamps(struct greth_info *greth);
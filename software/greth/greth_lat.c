@@ -0,0 +1,341 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* Changelog */
+/* 2026-10-18: Latency test using GRETH hardware timestamps */
+
+/* Two boards, or two GRETHs, with timestamping GRETH_GBITs run this test,
+ * one with LAT_REFLECTOR set to 1. The initiator sends probes and the
+ * reflector answers each probe with a reply followed by a follow-up frame
+ * carrying the hardware receive (t2) and transmit (t3) timestamps of the
+ * probe and reply, as two-step PTP does:
+ *
+ *   round trip = t4 - t1
+ *   one way    = (t4 - t1 - (t3 - t2)) / 2
+ *
+ * t1 is the transmit timestamp of the probe and t4 the receive timestamp of
+ * the reply at the initiator. The clocks of the two boards need not be
+ * synchronised. LOAD_FRAMES full size frames are sent before each probe to
+ * measure under load. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "greth_api.h"
+
+/* Set to 1 on the board answering the probes */
+#define LAT_REFLECTOR 0
+
+#define GRETH_ADDR 0x80000b00
+
+/* Probes sent, and full size frames sent before each probe */
+#define NPROBES 100000
+#define LOAD_FRAMES 0
+
+/* Nanoseconds per timestamp tick, depends on the timestamp source */
+#define TS_TICK_NS 1
+
+/* Peer MAC address */
+#define DEST_MAC0  0x00
+#define DEST_MAC1  0x13
+#define DEST_MAC2  0x72
+#define DEST_MAC3  0xAE
+#define DEST_MAC4  0x72
+#define DEST_MAC5  0x21
+
+/* Own MAC address */
+#define SRC_MAC0  0xDE
+#define SRC_MAC1  0xAD
+#define SRC_MAC2  0xBE
+#define SRC_MAC3  0xEF
+#define SRC_MAC4  0x00
+#define SRC_MAC5  0x20
+
+/* IEEE 802 local experimental ethertype */
+#define LAT_ETHTYPE 0x88B5
+#define LAT_PROBE 1
+#define LAT_REPLY 2
+#define LAT_FOLLOWUP 3
+
+/* Frame layout after the Ethernet header */
+#define LAT_TYPE 14
+#define LAT_SEQ 15
+#define LAT_T2 19
+#define LAT_T3 27
+#define LAT_SIZE 64
+
+/* Seconds to wait for a reply */
+#define LAT_TIMEOUT 1
+
+/* Histograms: 16 linear sub-buckets per power of two, about 6% resolution
+ * over the full 64 bit range without any per sample allocation */
+#define HIST_SUB 4
+#define HIST_BUCKETS ((64 - HIST_SUB + 1) << HIST_SUB)
+
+struct hist {
+    const char *name;
+    unsigned int count;
+    unsigned long long min;
+    unsigned long long max;
+    unsigned int bucket[HIST_BUCKETS];
+};
+
+struct greth_info greth;
+
+static struct hist rtt = { "round trip" };
+static struct hist owd = { "one way   " };
+
+static unsigned char rxbuf[GRETH_RXBD_NUM_TS][1536] __attribute__ ((aligned (32)));
+static unsigned int rxnext;
+
+static int hist_index(unsigned long long v)
+{
+    int e;
+
+    if (v < (1 << HIST_SUB)) {
+        return v;
+    }
+    e = 63 - __builtin_clzll(v);
+    return ((e - HIST_SUB + 1) << HIST_SUB) | ((v >> (e - HIST_SUB)) & ((1 << HIST_SUB) - 1));
+}
+
+/* Upper bound of the values counted in bucket i */
+static unsigned long long hist_value(int i)
+{
+    int e = (i >> HIST_SUB) + HIST_SUB - 1;
+
+    if (i < (1 << HIST_SUB)) {
+        return i;
+    }
+    return ((1ULL << e) | ((unsigned long long)(i & ((1 << HIST_SUB) - 1)) << (e - HIST_SUB))) +
+           (1ULL << (e - HIST_SUB)) - 1;
+}
+
+static void hist_add(struct hist *h, unsigned long long v)
+{
+    if (h->count == 0 || v < h->min) {
+        h->min = v;
+    }
+    if (v > h->max) {
+        h->max = v;
+    }
+    h->count++;
+    h->bucket[hist_index(v)]++;
+}
+
+static unsigned long long hist_pct(struct hist *h, int pct)
+{
+    unsigned long long n = 0;
+    unsigned long long limit = ((unsigned long long)h->count * pct + 99) / 100;
+    int i;
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        n += h->bucket[i];
+        if (n >= limit) {
+            break;
+        }
+    }
+    return hist_value(i) < h->max ? hist_value(i) : h->max;
+}
+
+static void hist_print(struct hist *h)
+{
+    if (h->count == 0) {
+        printf("%s: no samples\n", h->name);
+        return;
+    }
+    printf("%s: min %llu p50 %llu p99 %llu max %llu ns (%u samples)\n", h->name,
+           h->min * TS_TICK_NS, hist_pct(h, 50) * TS_TICK_NS,
+           hist_pct(h, 99) * TS_TICK_NS, h->max * TS_TICK_NS, h->count);
+}
+
+static void put32(unsigned char *p, unsigned int v)
+{
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+/* Received frames are written by DMA, read them bypassing the cache */
+static unsigned int get32(unsigned char *p)
+{
+    uintptr_t a = (uintptr_t)p;
+
+    return (dma_load8(a) << 24) | (dma_load8(a + 1) << 16) | (dma_load8(a + 2) << 8) | dma_load8(a + 3);
+}
+
+static void put64(unsigned char *p, unsigned long long v)
+{
+    put32(p, v >> 32);
+    put32(p + 4, v);
+}
+
+static unsigned long long get64(unsigned char *p)
+{
+    return ((unsigned long long)get32(p) << 32) | get32(p + 4);
+}
+
+static void build(unsigned char *buf, unsigned char *dest, int type, unsigned int seq)
+{
+    memcpy(buf, dest, 6);
+    memcpy(&buf[6], greth.esa, 6);
+    buf[12] = LAT_ETHTYPE >> 8;
+    buf[13] = LAT_ETHTYPE & 0xFF;
+    buf[LAT_TYPE] = type;
+    put32(&buf[LAT_SEQ], seq);
+}
+
+/* Sends a frame and returns its transmit timestamp */
+static unsigned long long send_ts(int size, unsigned char *buf)
+{
+    unsigned long long ts;
+
+    while (!greth_tx(size, (char *)buf, &greth));
+    while (!greth_checktx_ts(&ts, &greth));
+    return ts;
+}
+
+/* Returns the next received frame of this test, or NULL on timeout. The
+ * buffer is handed back to the receiver by the next call. */
+static unsigned char *receive(unsigned long long *ts)
+{
+    static unsigned char *prev;
+    struct rxstatus rxs;
+    unsigned char *buf;
+    clock_t t;
+    int size;
+
+    if (prev) {
+        greth_rx((char *)prev, &greth);
+        prev = NULL;
+    }
+    t = clock();
+    while (1) {
+        if (!greth_checkrx_ts(&size, &rxs, ts, &greth)) {
+            if (clock() - t > LAT_TIMEOUT * CLOCKS_PER_SEC) {
+                return NULL;
+            }
+            continue;
+        }
+        buf = rxbuf[rxnext];
+        rxnext = (rxnext + 1) % GRETH_RXBD_NUM_TS;
+        if (size >= LAT_SIZE - 4 && !(rxs.status & GRETH_RXBD_ERR) &&
+            ((dma_load8((uintptr_t)&buf[12]) << 8) | dma_load8((uintptr_t)&buf[13])) == LAT_ETHTYPE) {
+            prev = buf;
+            return buf;
+        }
+        greth_rx((char *)buf, &greth);
+    }
+}
+
+static void reflector(void)
+{
+    unsigned char tx[LAT_SIZE];
+    unsigned char src[6];
+    unsigned long long t2, t3;
+    unsigned char *rx;
+    unsigned int seq;
+    int i;
+
+    memset(tx, 0, sizeof(tx));
+    printf("Reflecting probes\n");
+    while (1) {
+        if ((rx = receive(&t2)) == NULL || dma_load8((uintptr_t)&rx[LAT_TYPE]) != LAT_PROBE) {
+            continue;
+        }
+        for (i = 0; i < 6; i++) {
+            src[i] = dma_load8((uintptr_t)&rx[6 + i]);
+        }
+        seq = get32(&rx[LAT_SEQ]);
+        build(tx, src, LAT_REPLY, seq);
+        t3 = send_ts(LAT_SIZE, tx);
+        build(tx, src, LAT_FOLLOWUP, seq);
+        put64(&tx[LAT_T2], t2);
+        put64(&tx[LAT_T3], t3);
+        send_ts(LAT_SIZE, tx);
+    }
+}
+
+static void initiator(void)
+{
+    unsigned char dest[6] = { DEST_MAC0, DEST_MAC1, DEST_MAC2, DEST_MAC3, DEST_MAC4, DEST_MAC5 };
+    unsigned char tx[LAT_SIZE];
+    unsigned char *load;
+    unsigned long long t1, t2, t3, t4, ts;
+    unsigned char *rx;
+    unsigned int seq;
+    unsigned int lost;
+    int i, got;
+
+    memset(tx, 0, sizeof(tx));
+    load = malloc(1514);
+    memset(load, 0, 1514);
+    build(load, dest, 0, 0);
+
+    lost = 0;
+    printf("Sending %d probes, %d load frames per probe\n", NPROBES, LOAD_FRAMES);
+    for (seq = 0; seq < NPROBES; seq++) {
+        for (i = 0; i < LOAD_FRAMES; i++) {
+            send_ts(1514, load);
+        }
+        build(tx, dest, LAT_PROBE, seq);
+        t1 = send_ts(LAT_SIZE, tx);
+
+        got = 0;
+        while (got != 3 && (rx = receive(&ts)) != NULL) {
+            if (get32(&rx[LAT_SEQ]) != seq) {
+                continue;
+            }
+            if (dma_load8((uintptr_t)&rx[LAT_TYPE]) == LAT_REPLY) {
+                t4 = ts;
+                got |= 1;
+            } else if (dma_load8((uintptr_t)&rx[LAT_TYPE]) == LAT_FOLLOWUP) {
+                t2 = get64(&rx[LAT_T2]);
+                t3 = get64(&rx[LAT_T3]);
+                got |= 2;
+            }
+        }
+        if (got != 3) {
+            lost++;
+            continue;
+        }
+        hist_add(&rtt, t4 - t1);
+        hist_add(&owd, (t4 - t1 - (t3 - t2)) / 2);
+    }
+
+    hist_print(&rtt);
+    hist_print(&owd);
+    printf("%u probes lost\n", lost);
+}
+
+int main(void)
+{
+    unsigned char esa[6] = { SRC_MAC0, SRC_MAC1, SRC_MAC2, SRC_MAC3, SRC_MAC4, SRC_MAC5 };
+    int i;
+
+    greth.regs = (greth_regs *) GRETH_ADDR;
+    memcpy(greth.esa, esa, 6);
+    greth_init(&greth);
+    if (!greth_enable_timestamps(&greth)) {
+        printf("GRETH without timestamp support, test skipped\n");
+        return 0;
+    }
+    for (i = 0; i < GRETH_RXBD_NUM_TS; i++) {
+        greth_rx((char *)rxbuf[i], &greth);
+    }
+    rxnext = 0;
+
+    if (LAT_REFLECTOR) {
+        reflector();
+    } else {
+        initiator();
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY                        */
+/*   Copyright (C) 2007 GAISLER RESEARCH                                     */
+/*                                                                           */
+/*   This program is free software; you can redistribute it and/or modify    */
+/*   it under the terms of the GNU General Public License as published by    */
+/*   the Free Software Foundation; either version 2 of the License, or       */
+/*   (at your option) any later version.                                     */
+/*                                                                           */
+/*   See the file COPYING for the full details of the license.               */
+/*****************************************************************************/
+
+/* Register and DMA memory access shared by the GRETH drivers on LEON
+ * (SPARC) and NOEL-V (RISC-V).
+ *
+ * mmio_load32/mmio_load8 bypass the data cache and are used for registers
+ * and descriptors. On NOEL-V plain loads are used, as the GRETH tests always
+ * have. cached_load32/cached_load8 are plain loads on both, for DMA buffers
+ * known to be coherent. Received payload is read with dma_load32/dma_load8,
+ * which are the cached loads when GRETH_DMA_COHERENT is set because the
+ * data cache snoops, and the bypassing loads otherwise. Addresses are
+ * uintptr_t so that nothing is truncated on 64-bit systems. */
+
+#ifndef __GRETH_MMIO_H__
+#define __GRETH_MMIO_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__riscv)
+static inline uint32_t mmio_load32(uintptr_t addr)
+{
+    uint32_t tmp;
+    asm volatile ("lw %0, 0(%1)"
+    : "=r"(tmp)
+    : "r"(addr)
+    );
+    return tmp;
+}
+
+static inline uint8_t mmio_load8(uintptr_t addr)
+{
+    uint8_t tmp;
+    asm volatile ("lbu %0, 0(%1)"
+    : "=r"(tmp)
+    : "r"(addr)
+    );
+    return tmp;
+}
+
+/* Orders memory writes before later memory and register writes, used
+ * before a descriptor is handed to the hardware */
+static inline void mmio_wmb(void)
+{
+    asm volatile ("fence ow, ow" : : : "memory");
+}
+
+/* Orders descriptor reads before the reads of the data they describe */
+static inline void mmio_rmb(void)
+{
+    asm volatile ("fence ir, ir" : : : "memory");
+}
+#else // Leon3
+static inline uint32_t mmio_load32(uintptr_t addr)
+{
+    uint32_t tmp;
+    asm volatile (" lda [%1]1, %0 "
+    : "=r"(tmp)
+    : "r"(addr)
+    );
+    return tmp;
+}
+
+static inline uint8_t mmio_load8(uintptr_t addr)
+{
+    uint8_t tmp;
+    asm volatile (" lduba [%1]1, %0 "
+    : "=r"(tmp)
+    : "r"(addr)
+    );
+    return tmp;
+}
+
+/* LEON stores are performed in order through the write-through cache, only
+ * the compiler needs to be kept from reordering */
+static inline void mmio_wmb(void)
+{
+    asm volatile ("" : : : "memory");
+}
+
+static inline void mmio_rmb(void)
+{
+    asm volatile ("" : : : "memory");
+}
+#endif
+
+static inline void mmio_store32(uintptr_t addr, uint32_t data)
+{
+    *((volatile uint32_t *)addr) = data;
+}
+
+static inline uint32_t cached_load32(uintptr_t addr)
+{
+    return *((volatile uint32_t *)addr);
+}
+
+static inline uint8_t cached_load8(uintptr_t addr)
+{
+    return *((volatile uint8_t *)addr);
+}
+
+#ifndef GRETH_DMA_COHERENT
+#define GRETH_DMA_COHERENT 0
+#endif
+
+#if GRETH_DMA_COHERENT
+#define dma_load32 cached_load32
+#define dma_load8 cached_load8
+#else
+#define dma_load32 mmio_load32
+#define dma_load8 mmio_load8
+#endif
+
+/* Allocates sz bytes aligned to align, a power of two. The allocation is
+ * never freed. */
+static inline void *dma_alloc(size_t sz, size_t align)
+{
+    uintptr_t mem;
+
+    mem = (uintptr_t)malloc(sz + align - 1);
+    if (mem == 0) {
+        return NULL;
+    }
+    return (void *)((mem + align - 1) & ~(uintptr_t)(align - 1));
+}
+
+/* Address as seen by the DMA engines, which only have 32 address bits.
+ * Returns 0 if the memory cannot be reached by DMA. */
+static inline uint32_t dma_addr(const volatile void *p)
+{
+    uintptr_t addr = (uintptr_t)p;
+
+    if (addr != (uint32_t)addr) {
+        return 0;
+    }
+    return (uint32_t)addr;
+}
+
+#endif
@@ -1,16 +1,8 @@
+#include <stdlib.h>
 #include "grpci2api.h"
 
-static inline int loadmem(int addr){
-  int tmp;        
-  asm volatile (" lda [%1]1, %0 "
-    : "=r"(tmp)
-    : "r"(addr)
-  );
-  return tmp;
-};
-  
 unsigned int grpci2_tw(unsigned int data){
-  return ((data & 0xff) << 24) | (((data >> 8) & 0xff) << 16) | (((data >> 16) & 0xff) << 8) | (((data >> 24) & 0xff)); 
+  return __builtin_bswap32(data);
 }
 
 /* GRPCI2 Get Master/Target/DMA enabled ****************************************** */
@@ -105,8 +97,8 @@ unsigned int grpci2_tw(unsigned int data){
     struct grpci2_dma_ch_desc *ch = malloc(sizeof(struct grpci2_dma_ch_desc)*(num_ch+1));
     struct grpci2_dma_data_desc *ddesc = malloc(sizeof(struct grpci2_dma_data_desc)*(ch_entry*num_ch+1));
     /*printf("ch: %p, desc: %p\n", ch, ddesc);*/
-    if (((int)ch & 0xf) != 0) ch = (struct grpci2_dma_ch_desc*)((int)ch + (0x10 - (int)ch & 0xf));
-    if (((int)ddesc & 0xf) != 0) ddesc = (struct grpci2_dma_data_desc*)((int)ddesc + (0x10 - (int)ddesc & 0xf));
+    if (((int)ch & 0xf) != 0) ch = (struct grpci2_dma_ch_desc*)((int)ch + (0x10 - ((int)ch & 0xf)));
+    if (((int)ddesc & 0xf) != 0) ddesc = (struct grpci2_dma_data_desc*)((int)ddesc + (0x10 - ((int)ddesc & 0xf)));
     /*printf("ch: %p, desc: %p\n", ch, ddesc);*/
 
     *chdesc = (int*)ch;
@@ -187,4 +179,289 @@ unsigned int grpci2_tw(unsigned int data){
     };
     return res;
   };
+/* ******************************************************************************* */
+
+/* GRPCI2 Config space shadow ************************************************** */
+  void grpci2_cfg_init(struct grpci2_cfg_shadow *s, volatile unsigned int *base){
+    s->base = base;
+    s->cycles = 0;
+    grpci2_cfg_invalidate(s);
+  };
+
+  void grpci2_cfg_invalidate(struct grpci2_cfg_shadow *s){
+    int i;
+
+    for (i=0; i<GRPCI2_CFG_DWORDS/32; i++) {
+      s->valid[i] = 0;
+      s->dirty[i] = 0;
+    };
+  };
+
+  unsigned int grpci2_cfg_read(struct grpci2_cfg_shadow *s, int off){
+    int i = (off >> 2) & (GRPCI2_CFG_DWORDS-1);
+
+    if (!(s->valid[i >> 5] & (1 << (i & 31)))) {
+      s->data[i] = __builtin_bswap32(loadmem((int)&s->base[i]));
+      s->valid[i >> 5] |= 1 << (i & 31);
+      s->cycles++;
+    };
+    return s->data[i];
+  };
+
+  void grpci2_cfg_write(struct grpci2_cfg_shadow *s, int off, unsigned int data){
+    int i = (off >> 2) & (GRPCI2_CFG_DWORDS-1);
+
+    s->data[i] = data;
+    s->valid[i >> 5] |= 1 << (i & 31);
+    s->dirty[i >> 5] |= 1 << (i & 31);
+  };
+
+  void grpci2_cfg_modify(struct grpci2_cfg_shadow *s, int off, unsigned int mask, 
+                         unsigned int data){
+    grpci2_cfg_write(s, off, (grpci2_cfg_read(s, off) & ~mask) | (data & mask));
+  };
+
+  int grpci2_cfg_flush(struct grpci2_cfg_shadow *s){
+    int i, n;
+    unsigned int data;
+
+    n = 0;
+    for (i=0; i<GRPCI2_CFG_DWORDS; i++) {
+      if (s->dirty[i >> 5] & (1 << (i & 31))) {
+        data = s->data[i];
+        /* The status half is write-one-to-clear, never write back the
+         * cached status bits */
+        if (i == GRPCI2_CFG_STA_CMD/4) data &= 0xffff;
+        s->base[i] = __builtin_bswap32(data);
+        n++;
+      };
+    };
+    for (i=0; i<GRPCI2_CFG_DWORDS/32; i++) s->dirty[i] = 0;
+    s->cycles += n;
+    return n;
+  };
+/* ******************************************************************************* */
+
+/* GRPCI2 Bus enumeration ******************************************************** */
+  /* One configuration read, returns 0xffffffff when no device answered */
+  static unsigned int grpci2_cfg_probe(volatile struct grpci2regs *apb, unsigned int addr){
+    unsigned int tmp;
+
+    tmp = loadmem(addr);
+    if (loadmem((int)&apb->status) & GRPCI2_STA_CFG_ERR) {
+      apb->status = GRPCI2_STA_CFG_ERR;
+      return 0xffffffff;
+    };
+    return __builtin_bswap32(tmp);
+  };
+
+  int grpci2_cfg_scan(volatile struct grpci2regs *apb, unsigned int cfgbase, int maxbus,
+                      struct grpci2_pci_func *found, int max, int *cycles){
+    int bus, dev, func, nfunc, n;
+    unsigned int ctrl, addr, id, hdr;
+
+    n = 0;
+    *cycles = 0;
+    ctrl = apb->ctrl;
+    for (bus=0; bus<=maxbus; bus++) {
+      apb->ctrl = (ctrl & ~GRPCI2_CTRL_CFG_BUS_MASK) | 
+                  ((bus << GRPCI2_CTRL_CFG_BUS) & GRPCI2_CTRL_CFG_BUS_MASK);
+      for (dev=0; dev<32; dev++) {
+        nfunc = 1;
+        for (func=0; func<nfunc; func++) {
+          addr = cfgbase | (dev << 11) | (func << 8);
+          id = grpci2_cfg_probe(apb, addr + GRPCI2_CFG_ID);
+          (*cycles)++;
+          if ((id & 0xffff) == 0xffff) continue;
+          if (func == 0) {
+            hdr = grpci2_cfg_probe(apb, addr + GRPCI2_CFG_LAT_TIMER);
+            (*cycles)++;
+            if (hdr & GRPCI2_CFG_MULTIFUNC) nfunc = 8;
+          };
+          if (n < max) {
+            found[n].bus = bus;
+            found[n].dev = dev;
+            found[n].func = func;
+            found[n].id = id;
+            found[n].class_rev = grpci2_cfg_probe(apb, addr + GRPCI2_CFG_CLASS_REV);
+            (*cycles)++;
+          };
+          n++;
+        };
+      };
+    };
+    apb->ctrl = ctrl;
+    return n;
+  };
+/* ******************************************************************************* */
+
+/* GRPCI2 DMA ring init/free ***************************************************** */
+  int grpci2_dma_ring_init(struct grpci2_dma_ring *r, volatile struct grpci2regs *apb,
+                           int num_ch, int entries, int irqen){
+    int i, depth[GRPCI2_DMA_MAX_CH];
+
+    if (num_ch < 1 || num_ch > GRPCI2_DMA_MAX_CH) return -1;
+    for(i=0; i<num_ch; i++) depth[i] = entries;
+    return grpci2_dma_ring_init_depth(r, apb, num_ch, depth, irqen);
+  };
 
+  int grpci2_dma_ring_init_depth(struct grpci2_dma_ring *r, volatile struct grpci2regs *apb,
+                                 int num_ch, const int *entries, int irqen){
+    int i,j,total,first;
+    char *p;
+    struct grpci2_dma_chan *c;
+
+    if (num_ch < 1 || num_ch > GRPCI2_DMA_MAX_CH) return -1;
+    total = 0;
+    for(i=0; i<num_ch; i++){
+      if (entries[i] < 1) return -1;
+      total += entries[i];
+    }
+
+    r->mem = malloc(sizeof(struct grpci2_dma_ch_desc)*num_ch + 
+                    sizeof(struct grpci2_dma_data_desc)*total + total + 0xf);
+    if (r->mem == NULL) return -1;
+
+    /* Both descriptor types are 16 bytes, aligning the start aligns all */
+    p = (char*)(((unsigned int)r->mem + 0xf) & ~0xf);
+    r->ch = (struct grpci2_dma_ch_desc*)p;
+    p += sizeof(struct grpci2_dma_ch_desc)*num_ch;
+    r->apb = apb;
+    r->num_ch = num_ch;
+    r->irqen = irqen;
+
+    first = 0;
+    for(i=0; i<num_ch; i++){
+      c = &r->chan[i];
+      c->desc = (struct grpci2_dma_data_desc*)p + first;
+      c->last = (unsigned char*)((struct grpci2_dma_data_desc*)p + total) + first;
+      c->entries = entries[i];
+      c->head = 0;
+      c->tail = 0;
+      c->count = 0;
+      c->errors = 0;
+      c->coal = 0;
+      c->pending = 0;
+      first += entries[i];
+      for(j=0; j<c->entries; j++){
+        c->desc[j].ctrl = 0;
+        c->desc[j].paddr = 0;
+        c->desc[j].aaddr = 0;
+        c->desc[j].next = (unsigned int)&c->desc[(j+1) % c->entries];
+        c->last[j] = 0;
+      }
+      r->ch[i].ctrl = GRPCI2_DMA_CHDESC_EN | 
+                      ((i << GRPCI2_DMA_CHDESC_ID) & GRPCI2_DMA_CHDESC_ID_MASK) | 
+                      GRPCI2_DMA_DESC_TYPE_CH;
+      r->ch[i].next = (unsigned int)&r->ch[(i+1) % num_ch];
+      r->ch[i].desc = (unsigned int)c->desc;
+      r->ch[i].res = 0;
+    }
+
+    apb->dma_ctrl = GRPCI2_DMACTRL_GUARD | GRPCI2_DMACTRL_MABORT | GRPCI2_DMACTRL_TABORT | 
+                    GRPCI2_DMACTRL_PERR | GRPCI2_DMACTRL_AHBDATA_ERR | GRPCI2_DMACTRL_AHBDESC_ERR |
+                    (((num_ch-1) << GRPCI2_DMACTRL_NUMCH) & GRPCI2_DMACTRL_NUMCH_MASK) |
+                    (irqen*GRPCI2_DMACTRL_IRQEN);
+    apb->dma_desc = (unsigned int)r->ch;
+    apb->status = GRPCI2_STA_IRQ_DMAINT | GRPCI2_STA_IRQ_DMAERR;
+    return 0;
+  };
+
+  void grpci2_dma_ring_free(struct grpci2_dma_ring *r){
+    /* Let the engine finish the queued descriptors before they go away */
+    while (loadmem((int)&r->apb->dma_ctrl) & GRPCI2_DMACTRL_ACTIVE);
+    free(r->mem);
+    r->mem = NULL;
+  };
+/* ******************************************************************************* */
+
+/* GRPCI2 DMA ring interrupt coalescing ****************************************** */
+  void grpci2_dma_ring_coalesce(struct grpci2_dma_ring *r, int ch, int count){
+    r->chan[ch].coal = count;
+    r->chan[ch].pending = 0;
+  };
+/* ******************************************************************************* */
+
+/* GRPCI2 DMA ring submit ******************************************************** */
+  int grpci2_dma_ring_submit(struct grpci2_dma_ring *r, int ch, 
+                             const struct grpci2_dma_xfer *x, int n, int ien){
+    struct grpci2_dma_chan *c = &r->chan[ch];
+    struct grpci2_dma_data_desc *d;
+    unsigned int paddr, aaddr, ctrl;
+    int i, len, words, ndesc, nxfer;
+
+    /* Whole transfers that fit, so that the last descriptor is known before
+     * any of them is handed to the engine. The engine moves words only. */
+    ndesc = 0;
+    for(nxfer=0; nxfer<n; nxfer++){
+      if (x[nxfer].len <= 0 || (x[nxfer].len & 3)) {
+        if (nxfer == 0) return -1;
+        break;
+      }
+      len = (x[nxfer].len/4 + GRPCI2_DMA_MAX_LEN - 1) / GRPCI2_DMA_MAX_LEN;
+      if (c->entries - c->count < ndesc + len) break;
+      ndesc += len;
+    }
+
+    for(i=0; i<nxfer; i++){
+      paddr = x[i].paddr;
+      aaddr = x[i].aaddr;
+      len = x[i].len/4;
+      while (len > 0) {
+        words = (len > GRPCI2_DMA_MAX_LEN) ? GRPCI2_DMA_MAX_LEN : len;
+        len -= words;
+        ndesc--;
+        d = &c->desc[c->head];
+        d->paddr = paddr;
+        d->aaddr = aaddr;
+        ctrl = GRPCI2_DMA_DESC_EN | GRPCI2_DMA_DESC_DIR*x[i].dir | GRPCI2_DMA_DESC_TYPE_DATA |
+               ((words-1) & GRPCI2_DMA_DESC_LENGTH_MASK) << GRPCI2_DMA_DESC_LENGTH;
+        c->pending++;
+        if ((ien && ndesc == 0) || (c->coal && c->pending >= c->coal)) {
+          ctrl |= GRPCI2_DMA_DESC_IRQEN;
+          c->pending = 0;
+        }
+        c->last[c->head] = (len == 0);
+        d->ctrl = ctrl;
+        paddr += 4*words;
+        aaddr += 4*words;
+        c->count++;
+        if (++c->head == c->entries) c->head = 0;
+      }
+    }
+
+    if (nxfer > 0) {
+      r->apb->dma_ctrl = (r->apb->dma_ctrl & GRPCI2_DMACTRL_NUMCH_MASK) | 
+                         (r->apb->dma_ctrl & GRPCI2_DMACTRL_IRQEN) | GRPCI2_DMACTRL_EN;
+    }
+    return nxfer;
+  };
+/* ******************************************************************************* */
+
+/* GRPCI2 DMA ring reap ********************************************************** */
+  int grpci2_dma_ring_reap(struct grpci2_dma_ring *r, int ch){
+    struct grpci2_dma_chan *c = &r->chan[ch];
+    unsigned int ctrl;
+    int done = 0;
+
+    while (c->count > 0) {
+      ctrl = loadmem((int)&c->desc[c->tail].ctrl);
+      if (ctrl & GRPCI2_DMA_DESC_EN) break;
+      if (ctrl & GRPCI2_DMA_DESC_ERR) c->errors++;
+      done += c->last[c->tail];
+      c->count--;
+      if (++c->tail == c->entries) c->tail = 0;
+    }
+    return done;
+  };
+
+  int grpci2_dma_ring_reap_all(struct grpci2_dma_ring *r, int *done){
+    int i, n, total = 0;
+
+    for(i=0; i<r->num_ch; i++){
+      n = grpci2_dma_ring_reap(r, i);
+      if (done != NULL) done[i] = n;
+      total += n;
+    }
+    return total;
+  };
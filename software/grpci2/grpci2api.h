@@ -284,6 +284,89 @@ struct grpci2_dma_data_desc {
   unsigned int next;
 };
 
+/* GRPCI2 DMA ring ************************************************************** */
+#define GRPCI2_DMA_MAX_CH 8
+
+/* One transfer, split into descriptors of at most GRPCI2_DMA_MAX_LEN words */
+struct grpci2_dma_xfer {
+  unsigned int paddr;                   /* PCI address */
+  unsigned int aaddr;                   /* AHB address */
+  int len;                              /* Bytes, non-zero multiple of 4 */
+  int dir;                              /* 0: PCI to AHB, 1: AHB to PCI */
+};
+
+struct grpci2_dma_chan {
+  struct grpci2_dma_data_desc *desc;    /* Ring of data descriptors */
+  unsigned char *last;                  /* Descriptor ends a transfer */
+  int entries;
+  int head;                             /* Next descriptor to fill */
+  int tail;                             /* Next descriptor to reap */
+  int count;                            /* Descriptors owned by hardware */
+  int errors;                           /* Descriptors completed with error */
+  int coal;                             /* Descriptors per interrupt, 0: none */
+  int pending;                          /* Descriptors since the last interrupt */
+};
+
+struct grpci2_dma_ring {
+  volatile struct grpci2regs *apb;
+  struct grpci2_dma_ch_desc *ch;
+  void *mem;                            /* Allocation holding all descriptors */
+  int num_ch;
+  int irqen;
+  struct grpci2_dma_chan chan[GRPCI2_DMA_MAX_CH];
+};
+/* ******************************************************************************* */
+
+/* GRPCI2 Config space shadow ************************************************** */
+#define GRPCI2_CFG_DWORDS 64                   /* 256 byte configuration space */
+
+/* Type 0 header offsets */
+#define GRPCI2_CFG_ID         0x00
+#define GRPCI2_CFG_STA_CMD    0x04
+#define GRPCI2_CFG_CLASS_REV  0x08
+#define GRPCI2_CFG_LAT_TIMER  0x0C
+#define GRPCI2_CFG_BAR(n)     (0x10 + 4*(n))
+#define GRPCI2_CFG_CAP        0x34
+/* GRPCI2 extended capability, relative to the capability pointer */
+#define GRPCI2_CFG_EXT_BARMAP(n) (0x04 + 4*(n))
+#define GRPCI2_CFG_EXT_ENDIAN    0x20
+
+#define GRPCI2_CFG_CMD_IO     (1 << 0)
+#define GRPCI2_CFG_CMD_MEM    (1 << 1)
+#define GRPCI2_CFG_CMD_MST    (1 << 2)
+#define GRPCI2_CFG_MULTIFUNC  (1 << 23)        /* Header type bit 7 */
+
+/* Cached copy of one function's configuration space in CPU byte order.
+ * Each dword is read at most once, writes only update the cache until
+ * grpci2_cfg_flush() writes back the dirty dwords. */
+struct grpci2_cfg_shadow {
+  volatile unsigned int *base;
+  unsigned int valid[GRPCI2_CFG_DWORDS/32];
+  unsigned int dirty[GRPCI2_CFG_DWORDS/32];
+  unsigned int data[GRPCI2_CFG_DWORDS];
+  int cycles;                                  /* Configuration cycles done */
+};
+
+/* Function found by grpci2_cfg_scan() */
+struct grpci2_pci_func {
+  int bus;
+  int dev;
+  int func;
+  unsigned int id;                             /* Device ID << 16 | vendor ID */
+  unsigned int class_rev;
+};
+/* ******************************************************************************* */
+
+/* Load bypassing the data cache, for descriptors and DMA buffers */
+static inline int loadmem(int addr){
+  int tmp;        
+  asm volatile (" lda [%1]1, %0 "
+    : "=r"(tmp)
+    : "r"(addr)
+  );
+  return tmp;
+};
+
 unsigned int grpci2_tw(unsigned int data);
 
 /* GRPCI2 Set/Get AHB Master-to-PCI map ****************************************** */
@@ -334,3 +417,60 @@ int grpci2_dma_desc_init(struct grpci2regs* apb, volatile unsigned int **chdesc,
 /* GRPCI2 DMA check transfer ***************************************************** */
   unsigned int grpci2_dma_check(volatile unsigned int **ddesc);
 
+/* GRPCI2 Config space shadow ************************************************** */
+/* base is the start of the function's configuration space in AHB space */
+  void grpci2_cfg_init(struct grpci2_cfg_shadow *s, volatile unsigned int *base);
+  unsigned int grpci2_cfg_read(struct grpci2_cfg_shadow *s, int off);
+  void grpci2_cfg_write(struct grpci2_cfg_shadow *s, int off, unsigned int data);
+/* Replaces the bits in mask of the dword at off */
+  void grpci2_cfg_modify(struct grpci2_cfg_shadow *s, int off, unsigned int mask, 
+                         unsigned int data);
+/* Writes back dirty dwords, returns the number of configuration writes */
+  int grpci2_cfg_flush(struct grpci2_cfg_shadow *s);
+  void grpci2_cfg_invalidate(struct grpci2_cfg_shadow *s);
+
+/* GRPCI2 Bus enumeration ******************************************************** */
+/* Scans buses 0 to maxbus through the configuration area at cfgbase, reading
+ * only the ID of empty slots and function 0 of single function devices.
+ * Stores up to max functions in found, returns the number of functions
+ * present. *cycles is set to the number of configuration cycles used. */
+  int grpci2_cfg_scan(volatile struct grpci2regs *apb, unsigned int cfgbase, int maxbus,
+                      struct grpci2_pci_func *found, int max, int *cycles);
+
+/* GRPCI2 DMA ring init/free ***************************************************** */
+/* Allocates num_ch channels of entries data descriptors each in one 16-byte
+ * aligned block and programs the DMA engine. Returns 0 on success, -1 on bad
+ * parameters or failed allocation. */
+  int grpci2_dma_ring_init(struct grpci2_dma_ring *r, volatile struct grpci2regs *apb,
+                           int num_ch, int entries, int irqen);
+/* As grpci2_dma_ring_init with entries[i] data descriptors on channel i */
+  int grpci2_dma_ring_init_depth(struct grpci2_dma_ring *r, volatile struct grpci2regs *apb,
+                                 int num_ch, const int *entries, int irqen);
+  void grpci2_dma_ring_free(struct grpci2_dma_ring *r);
+
+/* GRPCI2 DMA ring interrupt coalescing ****************************************** */
+/* Requests an interrupt every count descriptors on channel ch. With count 0
+ * the channel only interrupts on the last descriptor of a batch submitted
+ * with ien set, completions can then be collected from a timer with
+ * grpci2_dma_ring_reap_all. */
+  void grpci2_dma_ring_coalesce(struct grpci2_dma_ring *r, int ch, int count);
+
+/* GRPCI2 DMA ring submit ******************************************************** */
+/* Queues up to n transfers on channel ch and enables the DMA engine once.
+ * Only whole transfers are queued. With ien set the last descriptor of the
+ * batch requests an interrupt, others only as set by grpci2_dma_ring_coalesce.
+ * Returns the number of transfers queued. A transfer whose len is not a
+ * non-zero multiple of 4 ends the batch, and -1 is returned when it is the
+ * first one. */
+  int grpci2_dma_ring_submit(struct grpci2_dma_ring *r, int ch, 
+                             const struct grpci2_dma_xfer *x, int n, int ien);
+
+/* GRPCI2 DMA ring reap ********************************************************** */
+/* Returns the number of transfers completed on channel ch since the last
+ * call, in submission order. Descriptors completed with an error are counted
+ * in chan[ch].errors. */
+  int grpci2_dma_ring_reap(struct grpci2_dma_ring *r, int ch);
+/* Reaps all channels, from an interrupt handler or a timer tick. Stores the
+ * transfers completed per channel in done unless NULL and returns the total. */
+  int grpci2_dma_ring_reap_all(struct grpci2_dma_ring *r, int *done);
+
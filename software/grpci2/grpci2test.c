@@ -4,6 +4,7 @@
  * ******************************************************************************* */
 
 #include <stdlib.h>
+#include <time.h>
 #include "grpci2api.h"
 #include "grpci2extra.h"
 
@@ -65,6 +66,18 @@
 
 #define DBG 1
 
+/* DMA ring throughput benchmark, PCI<->AHB through the own PCI target */
+#define DMA_BENCH 1
+#define BENCH_BYTES (8*1024*1024)       /* Moved per transfer size and direction */
+#define BENCH_MAX_SIZE (1024*1024)
+#define BENCH_CH_ENTRY 64
+#define BENCH_MC_SIZE (16*1024)         /* Transfer size of the channel benchmark */
+#define BENCH_COAL 16                   /* Descriptors per interrupt when coalescing */
+
+/* Bus enumeration through the configuration area */
+#define SCAN_MAXBUS 0
+#define SCAN_MAX_FUNC 32
+
 
   
 /* ******************************************************************************* */
@@ -72,11 +85,13 @@
 
   
   static irq_cnt[8] = {0,0,0,0,0,0,0,0};
+  static volatile int irq_calls = 0;
 
   static grpci2dma_irqhandler(int irq){
   
     struct grpci2regs *apb = (struct grpci2regs*)APB_ADDR;
     int i, tmp; 
+    irq_calls++;
     apb->status = 0x10000;
     tmp = apb->dma_ctrl;
     apb->dma_ctrl = tmp | GRPCI2_DMACTRL_EN;
@@ -84,6 +99,132 @@
     for (i=0; i<8; i++) if ((tmp>>i)&1) irq_cnt[i]++;
   };
 
+/* GRPCI2 DMA ring benchmark ***************************************************** */
+  static void dma_bench(struct grpci2regs *apb){
+    struct grpci2_dma_ring ring;
+    struct grpci2_dma_xfer x[BENCH_CH_ENTRY];
+    unsigned int *abuf, *pbuf, paddr;
+    int size, dir, i, n, queued, done, total;
+    clock_t t1, t2;
+    double t;
+
+    abuf = malloc(BENCH_MAX_SIZE);
+    pbuf = malloc(BENCH_MAX_SIZE);
+    if (abuf == NULL || pbuf == NULL || grpci2_dma_ring_init(&ring, apb, 1, BENCH_CH_ENTRY, 0) != 0) {
+      printf("DMA benchmark: allocation failed\n");
+      return;
+    };
+    paddr = PCI_ADDR | (((unsigned int)pbuf) &~ PCI_ADDR_MASK);
+
+    /* Data check of one transfer spanning several descriptors */
+    for (i=0; i<BENCH_MAX_SIZE/4; i++) {
+      abuf[i] = i * 0x01010101;
+      pbuf[i] = 0;
+    };
+    x[0].paddr = paddr;
+    x[0].aaddr = (unsigned int)abuf;
+    x[0].len = BENCH_MAX_SIZE;
+    x[0].dir = 1;
+    while (grpci2_dma_ring_submit(&ring, 0, x, 1, 0) == 0);
+    while (grpci2_dma_ring_reap(&ring, 0) == 0);
+    for (i=0; i<BENCH_MAX_SIZE/4; i++) {
+      if (loadmem((int)&pbuf[i]) != abuf[i]) {
+        printf("DMA benchmark: data error at %p\n", &pbuf[i]);
+        break;
+      };
+    };
+
+    for (size=4096; size<=BENCH_MAX_SIZE; size*=4) {
+      for (dir=0; dir<2; dir++) {
+        for (i=0; i<BENCH_CH_ENTRY; i++) {
+          x[i].paddr = paddr;
+          x[i].aaddr = (unsigned int)abuf;
+          x[i].len = size;
+          x[i].dir = dir;
+        };
+        total = BENCH_BYTES / size;
+        queued = 0;
+        done = 0;
+        t1 = clock();
+        while (done < total) {
+          n = total - queued;
+          if (n > BENCH_CH_ENTRY) n = BENCH_CH_ENTRY;
+          if (n > 0) queued += grpci2_dma_ring_submit(&ring, 0, x, n, 0);
+          done += grpci2_dma_ring_reap(&ring, 0);
+        };
+        t2 = clock();
+        t = (double)(t2 - t1)/CLOCKS_PER_SEC;
+        printf("DMA %s %7d byte transfers: %8.3f MB/s\n", dir ? "AHB->PCI" : "PCI->AHB", 
+               size, (double)BENCH_BYTES/(t*1024*1024));
+      };
+    };
+    if (ring.chan[0].errors) printf("DMA benchmark: %d descriptor errors\n", ring.chan[0].errors);
+
+    grpci2_dma_ring_free(&ring);
+    free(abuf);
+    free(pbuf);
+  };
+
+  /* BENCH_BYTES in BENCH_MC_SIZE transfers spread over 1 to 8 channels, with
+   * an interrupt per descriptor and coalesced every BENCH_COAL descriptors */
+  static void dma_bench_channels(struct grpci2regs *apb){
+    struct grpci2_dma_ring ring;
+    struct grpci2_dma_xfer x[BENCH_CH_ENTRY];
+    int depth[GRPCI2_DMA_MAX_CH];
+    unsigned int *abuf, *pbuf, paddr;
+    int nch, coal, ch, i, n, queued, done, total, irqs;
+    clock_t t1, t2;
+    double t;
+
+    abuf = malloc(BENCH_MC_SIZE);
+    pbuf = malloc(BENCH_MC_SIZE);
+    if (abuf == NULL || pbuf == NULL) {
+      printf("DMA channel benchmark: allocation failed\n");
+      return;
+    };
+    paddr = PCI_ADDR | (((unsigned int)pbuf) &~ PCI_ADDR_MASK);
+    for (i=0; i<BENCH_CH_ENTRY; i++) {
+      x[i].paddr = paddr;
+      x[i].aaddr = (unsigned int)abuf;
+      x[i].len = BENCH_MC_SIZE;
+      x[i].dir = i & 1;
+    };
+
+    for (nch=1; nch<=GRPCI2_DMA_MAX_CH; nch++) {
+      /* Same total queue depth for every channel count */
+      for (ch=0; ch<nch; ch++) depth[ch] = BENCH_CH_ENTRY/nch;
+      for (coal=1; coal<=BENCH_COAL; coal*=BENCH_COAL) {
+        if (grpci2_dma_ring_init_depth(&ring, apb, nch, depth, 1) != 0) {
+          printf("DMA channel benchmark: allocation failed\n");
+          break;
+        };
+        for (ch=0; ch<nch; ch++) grpci2_dma_ring_coalesce(&ring, ch, coal);
+        total = BENCH_BYTES / BENCH_MC_SIZE;
+        queued = 0;
+        done = 0;
+        irqs = irq_calls;
+        t1 = clock();
+        while (done < total) {
+          for (ch=0; ch<nch && queued<total; ch++) {
+            n = total - queued;
+            if (n > depth[ch]) n = depth[ch];
+            queued += grpci2_dma_ring_submit(&ring, ch, x, n, 0);
+          };
+          done += grpci2_dma_ring_reap_all(&ring, NULL);
+        };
+        t2 = clock();
+        irqs = irq_calls - irqs;
+        t = (double)(t2 - t1)/CLOCKS_PER_SEC;
+        printf("DMA %d ch, irq every %2d desc: %8.3f MB/s, %8.1f irq/MB\n", nch, coal,
+               (double)BENCH_BYTES/(t*1024*1024), irqs/((double)BENCH_BYTES/(1024*1024)));
+        grpci2_dma_ring_free(&ring);
+      };
+    };
+    free(abuf);
+    free(pbuf);
+  };
+/* ******************************************************************************* */
+
 int main(){
 
 
@@ -91,6 +232,10 @@ int main(){
   struct grpci2regs *slot_apb;
   struct grpci2_pci_conf_space_regs conf_host;
   struct grpci2_pci_conf_space_regs *conf[21];
+  struct grpci2_cfg_shadow shadow;
+  struct grpci2_pci_func func[SCAN_MAX_FUNC];
+  int nfunc, cycles, ext;
+  clock_t t1, t2;
 
   int i,j,k;
   int dir_pta = 0;
@@ -118,19 +263,39 @@ int main(){
   conf[0]->ext = (struct grpci2_ext_pci_conf_space_regs*)((unsigned int)conf[0]->head + 
                  (grpci2_tw(conf[0]->head->cap_pointer) & 0xff));
 
-  grpci2_mst_enable(conf[0]);
-  grpci2_mem_enable(conf[0]);
-  grpci2_io_disable(conf[0]);
-  grpci2_set_latency_timer(conf[0], 0x20);
-  grpci2_set_bar(conf[0], 0, PCI_ADDR);
-  grpci2_set_barmap(conf[0], 0, 0);
-  grpci2_set_bus_big_endian(conf[0]);
+  /* Set up through the shadow: each dword is read and written once */
+  grpci2_cfg_init(&shadow, (volatile unsigned int*)PCI_CONF_ADDR);
+  ext = grpci2_cfg_read(&shadow, GRPCI2_CFG_CAP) & 0xfc;
+  grpci2_cfg_modify(&shadow, GRPCI2_CFG_STA_CMD, 
+                    GRPCI2_CFG_CMD_MST | GRPCI2_CFG_CMD_MEM | GRPCI2_CFG_CMD_IO, 
+                    GRPCI2_CFG_CMD_MST | GRPCI2_CFG_CMD_MEM);
+  grpci2_cfg_modify(&shadow, GRPCI2_CFG_LAT_TIMER, 0xff00, 0x20 << 8);
+  grpci2_cfg_write(&shadow, GRPCI2_CFG_BAR(0), PCI_ADDR);
+  grpci2_cfg_write(&shadow, ext + GRPCI2_CFG_EXT_BARMAP(0), 0);
+  grpci2_cfg_modify(&shadow, ext + GRPCI2_CFG_EXT_ENDIAN, 1, 0);
+  grpci2_cfg_flush(&shadow);
+  printf("Host configuration: %d configuration cycles\n", shadow.cycles);
 
   grpci2_set_mstmap(apb, 0, PCI_ADDR);
 
+  /* Bus enumeration */
+  t1 = clock();
+  nfunc = grpci2_cfg_scan(apb, PCI_CONF_ADDR, SCAN_MAXBUS, func, SCAN_MAX_FUNC, &cycles);
+  t2 = clock();
+  printf("Scan of %d buses: %d functions, %d configuration cycles, %ld us\n", 
+         SCAN_MAXBUS+1, nfunc, cycles, (long)((t2 - t1) * 1000000.0 / CLOCKS_PER_SEC));
+  for (i=0; i<nfunc && i<SCAN_MAX_FUNC; i++) 
+    printf("  %02x:%02x.%d %04x:%04x class %06x\n", func[i].bus, func[i].dev, func[i].func, 
+           func[i].id & 0xffff, func[i].id >> 16, func[i].class_rev >> 8);
+
   catch_interrupt(grpci2dma_irqhandler, DMA_IRQ);
   *(unsigned int*)(IRQMP_ADDR + 0x40) = (1 << DMA_IRQ); // Unmask PCIDMA irq
 
+  if (DMA_BENCH) {
+    dma_bench(apb);
+    dma_bench_channels(apb);
+  };
+
   /* DMA descriptor table setup */
   grpci2_dma_desc_init(apb, &q.chbase, irq_en, NUM_CH, CH_ENTRY);
   grpci2_dma_desc_print(q.chbase); /**/
@@ -0,0 +1,572 @@
+/*
+ * Command line capture for the on-chip logic analyzer (LOGAN)
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ * Connects to GRMON in GDB mode, like logan.tcl, reads the status and the
+ * trace buffer of the core with memory packets and writes the samples,
+ * oldest first, as a VCD file for GTKWave. Samples are unpacked with word
+ * shifts and only changed signals are written, so that full-depth captures
+ * of 16384 x 256 bits take well under a second once read.
+ *
+ * The signals are taken from the setup file (setup.logan), one "name size"
+ * per line, the first signal in the most significant bits. Without it one
+ * vector of all bits is written. A 1-bit signal "trigger" marks the sample
+ * the core triggered on.
+ *
+ * usage: logan_capture [-h host] [-p port] [-a addr] [-c setup] [-o file]
+ *                      [-f MHz] [-b bytes] [-A] [-w secs]
+ *   -a addr   core address, otherwise found with the GRMON "la" command
+ *   -f MHz    trace clock, otherwise the VCD time unit is one trace clock
+ *   -b bytes  bytes per memory packet (default 1024)
+ *   -A        arm the core and wait up to -w seconds (default 10) for the
+ *             capture to finish
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define LOGAN_STATUS    0x00
+#define LOGAN_INDEX     0x04
+#define LOGAN_PAGE      0x08
+#define LOGAN_COUNT     0x0C    /* Samples stored after the trigger */
+#define LOGAN_DIV       0x10
+#define LOGAN_QUAL      0x14
+#define LOGAN_BUF       0x8000  /* 32 bytes per sample, 1024 samples per page */
+
+#define LOGAN_ARMED     0x20000000
+#define LOGAN_TRIGGED   0x10000000
+
+#define MAX_SIGS        256
+#define MAX_PKT         (2 * 8192 + 16)
+
+struct rsp {
+        int fd;
+        unsigned char buf[4096];
+        int len;
+        int pos;
+};
+
+struct sig {
+        char name[64];
+        int lo;                         /* Lowest bit in the sample */
+        int size;
+        char id[4];                     /* VCD identifier */
+};
+
+static struct sig sigs[MAX_SIGS];
+static int nsig;
+
+static const char hexchar[] = "0123456789abcdef";
+
+static int hexval(int c)
+{
+        if (c >= '0' && c <= '9') {
+                return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+        }
+        return -1;
+}
+
+static int rsp_getc(struct rsp *r)
+{
+        if (r->pos == r->len) {
+                r->len = recv(r->fd, r->buf, sizeof(r->buf), 0);
+                r->pos = 0;
+                if (r->len <= 0) {
+                        r->len = 0;
+                        return -1;
+                }
+        }
+        return r->buf[r->pos++];
+}
+
+static int rsp_write(struct rsp *r, const char *p, int len)
+{
+        int n;
+
+        while (len > 0) {
+                n = send(r->fd, p, len, 0);
+                if (n <= 0) {
+                        return -1;
+                }
+                p += n;
+                len -= n;
+        }
+        return 0;
+}
+
+/* Sends $cmd#cs and waits for the acknowledge, resending on '-' */
+static int rsp_send(struct rsp *r, const char *cmd)
+{
+        static char pkt[MAX_PKT];
+        unsigned int sum = 0;
+        int len = strlen(cmd), i, c;
+
+        if (len + 4 > MAX_PKT) {
+                return -1;
+        }
+        pkt[0] = '$';
+        for (i = 0; i < len; i++) {
+                pkt[i + 1] = cmd[i];
+                sum += (unsigned char)cmd[i];
+        }
+        pkt[len + 1] = '#';
+        pkt[len + 2] = hexchar[(sum >> 4) & 15];
+        pkt[len + 3] = hexchar[sum & 15];
+        for (;;) {
+                if (rsp_write(r, pkt, len + 4) < 0) {
+                        return -1;
+                }
+                do {
+                        c = rsp_getc(r);
+                } while (c != '+' && c != '-' && c >= 0);
+                if (c == '+') {
+                        return 0;
+                }
+                if (c < 0) {
+                        return -1;
+                }
+                fprintf(stderr, "checksum error in receiver, resending\n");
+        }
+}
+
+/* Receives one packet into pkt, acknowledging it, and returns its length */
+static int rsp_recv(struct rsp *r, char *pkt, int max)
+{
+        unsigned int sum, cs;
+        int c, len, h, l;
+
+        for (;;) {
+                do {
+                        c = rsp_getc(r);
+                } while (c != '$' && c >= 0);
+                if (c < 0) {
+                        return -1;
+                }
+                sum = 0;
+                len = 0;
+                while ((c = rsp_getc(r)) != '#' && c >= 0) {
+                        if (len < max - 1) {
+                                pkt[len++] = c;
+                        }
+                        sum += c;
+                }
+                h = hexval(rsp_getc(r));
+                l = hexval(rsp_getc(r));
+                if (c < 0 || h < 0 || l < 0) {
+                        return -1;
+                }
+                cs = (h << 4) | l;
+                pkt[len] = 0;
+                if (cs == (sum & 0xff)) {
+                        rsp_write(r, "+", 1);
+                        return len;
+                }
+                fprintf(stderr, "checksum error\n");
+                rsp_write(r, "-", 1);
+        }
+}
+
+/* Runs a GRMON command and collects the text of its output packets */
+static int rsp_monitor(struct rsp *r, const char *cmd, char *out, int max)
+{
+        static char pkt[MAX_PKT];
+        char *p = pkt;
+        int i, n, len = 0;
+
+        p += sprintf(p, "qRcmd,");
+        for (i = 0; cmd[i] && p < pkt + MAX_PKT - 3; i++) {
+                *p++ = hexchar[((unsigned char)cmd[i] >> 4) & 15];
+                *p++ = hexchar[cmd[i] & 15];
+        }
+        *p = 0;
+        if (rsp_send(r, pkt) < 0) {
+                return -1;
+        }
+        for (;;) {
+                if ((n = rsp_recv(r, pkt, sizeof(pkt))) < 0) {
+                        return -1;
+                }
+                if (pkt[0] != 'O' || strcmp(pkt, "OK") == 0) {
+                        break;
+                }
+                for (i = 1; i + 1 < n && len < max - 1; i += 2) {
+                        out[len++] = (hexval(pkt[i]) << 4) | hexval(pkt[i + 1]);
+                }
+        }
+        out[len] = 0;
+        return pkt[0] == 'E' ? -1 : len;
+}
+
+static int rsp_read(struct rsp *r, unsigned int addr, unsigned char *p, int len)
+{
+        static char pkt[MAX_PKT];
+        char cmd[32];
+        int i, n;
+
+        sprintf(cmd, "m%x,%x", addr, len);
+        if (rsp_send(r, cmd) < 0 || (n = rsp_recv(r, pkt, sizeof(pkt))) < 0) {
+                return -1;
+        }
+        if (n != 2 * len) {
+                fprintf(stderr, "memory read at %08x failed: %s\n", addr, pkt);
+                return -1;
+        }
+        for (i = 0; i < len; i++) {
+                p[i] = (hexval(pkt[2 * i]) << 4) | hexval(pkt[2 * i + 1]);
+        }
+        return 0;
+}
+
+/* Words are big endian on the target */
+static int rsp_read32(struct rsp *r, unsigned int addr, unsigned int *v)
+{
+        unsigned char b[4];
+
+        if (rsp_read(r, addr, b, 4) < 0) {
+                return -1;
+        }
+        *v = (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+        return 0;
+}
+
+static int rsp_write32(struct rsp *r, unsigned int addr, unsigned int v)
+{
+        char cmd[64], pkt[16];
+
+        sprintf(cmd, "M%x,4:%08x", addr, v);
+        if (rsp_send(r, cmd) < 0 || rsp_recv(r, pkt, sizeof(pkt)) < 0) {
+                return -1;
+        }
+        return strcmp(pkt, "OK") == 0 ? 0 : -1;
+}
+
+static int rsp_connect(struct rsp *r, const char *host, const char *port)
+{
+        struct addrinfo hints, *ai, *a;
+        int one = 1;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host, port, &hints, &ai) != 0) {
+                return -1;
+        }
+        r->fd = -1;
+        for (a = ai; a != NULL; a = a->ai_next) {
+                r->fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                if (r->fd < 0) {
+                        continue;
+                }
+                if (connect(r->fd, a->ai_addr, a->ai_addrlen) == 0) {
+                        break;
+                }
+                close(r->fd);
+                r->fd = -1;
+        }
+        freeaddrinfo(ai);
+        if (r->fd < 0) {
+                return -1;
+        }
+        setsockopt(r->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        r->len = 0;
+        r->pos = 0;
+        return 0;
+}
+
+/* Reads the setup file, stopping when dbits bits are assigned */
+static int read_setup(const char *file, int dbits)
+{
+        char buf[256], name[64];
+        int size, bits = 0;
+        FILE *f;
+
+        nsig = 0;
+        if (file == NULL || (f = fopen(file, "r")) == NULL) {
+                return -1;
+        }
+        while (bits < dbits && nsig < MAX_SIGS && fgets(buf, sizeof(buf), f) != NULL) {
+                if (sscanf(buf, "%63s %d", name, &size) != 2 || size <= 0) {
+                        continue;
+                }
+                if (bits + size > dbits) {
+                        fprintf(stderr, "%s: signal %s exceeds %d bits\n", file, name, dbits);
+                        break;
+                }
+                strcpy(sigs[nsig].name, name);
+                sigs[nsig].size = size;
+                bits += size;
+                sigs[nsig++].lo = dbits - bits;
+        }
+        fclose(f);
+        if (bits != dbits) {
+                fprintf(stderr, "%s: signal sizes don't match %d bits\n", file, dbits);
+                nsig = 0;
+                return -1;
+        }
+        return 0;
+}
+
+/* Bits lo to lo+n-1 of a sample, n at most 32 */
+static unsigned int sample_bits(const unsigned int *w, int lo, int n)
+{
+        unsigned long long v = w[lo >> 5];
+
+        if ((lo & 31) + n > 32) {
+                v |= (unsigned long long)w[(lo >> 5) + 1] << 32;
+        }
+        v >>= lo & 31;
+        return n == 32 ? (unsigned int)v : (unsigned int)v & ((1U << n) - 1);
+}
+
+/* Extracts a signal into words of 32 bits, least significant first */
+static void sig_value(const struct sig *s, const unsigned int *w, unsigned int *v)
+{
+        int i, n;
+
+        for (i = 0; i * 32 < s->size; i++) {
+                n = s->size - i * 32;
+                v[i] = sample_bits(w, s->lo + i * 32, n > 32 ? 32 : n);
+        }
+}
+
+static void put_value(FILE *f, const struct sig *s, const unsigned int *v)
+{
+        static char bin[256][9];
+        char buf[MAX_SIGS + 8], *p = buf;
+        int i, b, n;
+
+        if (bin[0][0] == 0) {
+                for (i = 0; i < 256; i++) {
+                        for (b = 0; b < 8; b++) {
+                                bin[i][b] = (i >> (7 - b)) & 1 ? '1' : '0';
+                        }
+                }
+        }
+        if (s->size == 1) {
+                fprintf(f, "%c%s\n", '0' + (v[0] & 1), s->id);
+                return;
+        }
+        *p++ = 'b';
+        /* Leading bits of the top word, then whole bytes */
+        i = (s->size - 1) >> 5;
+        n = s->size - i * 32;
+        for (b = n - 1; b >= 0 && (b + 1) & 7; b--) {
+                *p++ = '0' + ((v[i] >> b) & 1);
+        }
+        for (; i >= 0; i--) {
+                for (; b >= 0; b -= 8) {
+                        memcpy(p, bin[(v[i] >> (b - 7)) & 0xff], 8);
+                        p += 8;
+                }
+                b = 31;
+        }
+        *p = 0;
+        fprintf(f, "%s %s\n", buf, s->id);
+}
+
+/*
+ * Writes samples oldest first. Sample i is at time i * div trace clocks,
+ * which is exact unless a qualifier bit is used.
+ */
+static void write_vcd(FILE *f, const unsigned int *buf, int nw, int n, int trig, int div,
+                      double mhz)
+{
+        unsigned int (*last)[8], v[8];
+        unsigned long long t;
+        int i, k, id;
+
+        last = calloc(nsig, sizeof(*last));
+        fprintf(f, "$comment logan_capture, %d samples $end\n", n);
+        fprintf(f, "$timescale %s $end\n", mhz > 0 ? "1 ps" : "1 ns");
+        fprintf(f, "$scope module logan $end\n");
+        for (k = 0; k < nsig; k++) {
+                id = k + 1;
+                i = 0;
+                do {
+                        sigs[k].id[i++] = '!' + id % 94;
+                        id /= 94;
+                } while (id);
+                sigs[k].id[i] = 0;
+                fprintf(f, "$var wire %d %s %s $end\n", sigs[k].size, sigs[k].id, sigs[k].name);
+        }
+        if (trig >= 0) {
+                fprintf(f, "$var wire 1 ! trigger $end\n");
+        }
+        fprintf(f, "$upscope $end\n$enddefinitions $end\n");
+        for (i = 0; i < n; i++) {
+                t = (unsigned long long)i * div;
+                if (mhz > 0) {
+                        t = (unsigned long long)(t * 1e6 / mhz + 0.5);
+                }
+                fprintf(f, "#%llu\n", t);
+                if (i == 0) {
+                        fprintf(f, "$dumpvars\n");
+                }
+                for (k = 0; k < nsig; k++) {
+                        sig_value(&sigs[k], buf + i * nw, v);
+                        if (i == 0 || memcmp(v, last[k], (sigs[k].size + 31) / 32 * 4) != 0) {
+                                put_value(f, &sigs[k], v);
+                                memcpy(last[k], v, sizeof(v));
+                        }
+                }
+                if (trig >= 0 && (i == 0 || i == trig || i == trig + 1)) {
+                        fprintf(f, "%c!\n", i == trig ? '1' : '0');
+                }
+                if (i == 0) {
+                        fprintf(f, "$end\n");
+                }
+        }
+        free(last);
+}
+
+int main(int argc, char **argv)
+{
+        const char *host = "localhost", *port = "2222", *setup = "setup.logan";
+        const char *out = "log.vcd";
+        unsigned int addr = 0, status, index, count, div, page, *buf, *w;
+        unsigned char *raw;
+        int dbits, depth, nw, arm = 0, secs = 10, chunk = 1024, n, len, i, k, trig;
+        double mhz = 0;
+        char text[4096], *p;
+        struct rsp r;
+        FILE *f;
+
+        for (i = 1; i < argc; i++) {
+                if (i + 1 < argc && argv[i][0] == '-' && strchr("hpacofbw", argv[i][1])) {
+                        switch (argv[i++][1]) {
+                        case 'h': host = argv[i]; break;
+                        case 'p': port = argv[i]; break;
+                        case 'a': addr = strtoul(argv[i], NULL, 0); break;
+                        case 'c': setup = argv[i]; break;
+                        case 'o': out = argv[i]; break;
+                        case 'f': mhz = atof(argv[i]); break;
+                        case 'b': chunk = atoi(argv[i]) & ~3; break;
+                        case 'w': secs = atoi(argv[i]); break;
+                        }
+                } else if (strcmp(argv[i], "-A") == 0) {
+                        arm = 1;
+                } else {
+                        fprintf(stderr, "usage: logan_capture [-h host] [-p port] [-a addr] "
+                                "[-c setup] [-o file] [-f MHz] [-b bytes] [-A] [-w secs]\n");
+                        return 1;
+                }
+        }
+        if (chunk < 32 || chunk > 8192) {
+                fprintf(stderr, "packet size must be 32 to 8192 bytes\n");
+                return 1;
+        }
+
+        if (rsp_connect(&r, host, port) < 0) {
+                fprintf(stderr, "Error connecting to %s : %s\nPut GRMON in GDB mode.\n",
+                        host, port);
+                return 1;
+        }
+        if (addr == 0) {
+                if (rsp_monitor(&r, "la", text, sizeof(text)) < 0 ||
+                    (p = strstr(text, "0x")) == NULL) {
+                        fprintf(stderr, "No logic analyzer found\n");
+                        return 1;
+                }
+                addr = strtoul(p, NULL, 16);
+        }
+
+        if (arm) {
+                if (rsp_write32(&r, addr + LOGAN_STATUS, 1) < 0) {
+                        fprintf(stderr, "arm failed\n");
+                        return 1;
+                }
+                for (i = 0; i < secs * 10; i++) {
+                        if (rsp_read32(&r, addr + LOGAN_STATUS, &status) < 0) {
+                                return 1;
+                        }
+                        if (!(status & LOGAN_ARMED)) {
+                                break;
+                        }
+                        usleep(100000);
+                }
+        }
+        if (rsp_read32(&r, addr + LOGAN_STATUS, &status) < 0 ||
+            rsp_read32(&r, addr + LOGAN_INDEX, &index) < 0 ||
+            rsp_read32(&r, addr + LOGAN_COUNT, &count) < 0 ||
+            rsp_read32(&r, addr + LOGAN_DIV, &div) < 0) {
+                return 1;
+        }
+        /* 256 signals read as 0 in the 8-bit field */
+        dbits = (status >> 20) & 0xff ? (status >> 20) & 0xff : 256;
+        depth = ((status >> 6) & 0x3fff) + 1;
+        if (status & LOGAN_ARMED) {
+                fprintf(stderr, "warning: still armed, the capture is not complete\n");
+        }
+        nw = (dbits + 31) / 32;
+        div = div & 0xffff ? div & 0xffff : 1;
+
+        /* Only the words holding signals are read of each 32-byte sample */
+        buf = malloc(depth * nw * sizeof(*buf));
+        raw = malloc(1024 * 32);
+        for (page = 0; page * 1024 < (unsigned int)depth; page++) {
+                n = depth - page * 1024 < 1024 ? depth - page * 1024 : 1024;
+                if (rsp_write32(&r, addr + LOGAN_PAGE, page) < 0) {
+                        fprintf(stderr, "page select failed\n");
+                        return 1;
+                }
+                len = (n - 1) * 32 + nw * 4;
+                for (i = 0; i < len; i += chunk) {
+                        if (rsp_read(&r, addr + LOGAN_BUF + i, raw + i,
+                                     len - i < chunk ? len - i : chunk) < 0) {
+                                return 1;
+                        }
+                }
+                for (i = 0; i < n; i++) {
+                        w = buf + (page * 1024 + i) * nw;
+                        for (k = 0; k < nw; k++) {
+                                p = (char *)raw + i * 32 + k * 4;
+                                w[k] = ((unsigned char)p[0] << 24) | ((unsigned char)p[1] << 16) |
+                                       ((unsigned char)p[2] << 8) | (unsigned char)p[3];
+                        }
+                }
+        }
+        rsp_write32(&r, addr + LOGAN_PAGE, 0);
+        rsp_send(&r, "D");
+        rsp_recv(&r, text, sizeof(text));
+        close(r.fd);
+
+        /* The buffer is circular, the oldest sample is at the write index */
+        index &= depth - 1;
+        w = malloc(depth * nw * sizeof(*w));
+        memcpy(w, buf + index * nw, (depth - index) * nw * sizeof(*w));
+        memcpy(w + (depth - index) * nw, buf, index * nw * sizeof(*w));
+        /*
+         * The trigged bit is cleared again when the capture finishes, a
+         * finished capture ends with the trigger sample and count samples
+         */
+        trig = status & (LOGAN_ARMED | LOGAN_TRIGGED) ? -1 : depth - 1 - (int)(count & (depth - 1));
+
+        if (read_setup(setup, dbits) < 0) {
+                strcpy(sigs[0].name, "signals");
+                sigs[0].lo = 0;
+                sigs[0].size = dbits;
+                nsig = 1;
+        }
+        if ((f = fopen(out, "w")) == NULL) {
+                perror(out);
+                return 1;
+        }
+        write_vcd(f, w, nw, depth, trig, div, mhz);
+        fclose(f);
+        printf("%d samples of %d bits, %d signals, trigger %d, written to %s\n", depth, dbits,
+               nsig, trig, out);
+        return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Stand-in for GRMON in GDB mode with a LOGAN core, to test logan_capture
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ * Serves one connection on localhost with the memory and monitor packets
+ * used by logan_capture. The core holds a finished capture in which word k
+ * of the sample taken at time t, counted from the oldest sample, is
+ * t * (k + 1) ^ (k << 24), with the write index in the middle of the buffer.
+ * Arming restarts the capture, which finishes after a few status reads.
+ *
+ * usage: logan_stub [-p port] [-d dbits] [-n depth] [-c count]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define LOGAN_ADDR      0x80100000
+#define MAX_PKT         (2 * 8192 + 16)
+
+static int dbits = 32, depth = 1024, count = 16;
+static unsigned int index_, page, div_ = 1, armed, polls;
+
+static const char hexchar[] = "0123456789abcdef";
+
+static int hexval(int c)
+{
+        if (c >= '0' && c <= '9') {
+                return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+        }
+        return -1;
+}
+
+static void put_packet(int fd, const char *data)
+{
+        static char pkt[MAX_PKT + 8];
+        unsigned int sum = 0;
+        int len = strlen(data), i;
+
+        pkt[0] = '$';
+        for (i = 0; i < len; i++) {
+                sum += (unsigned char)data[i];
+        }
+        memcpy(pkt + 1, data, len);
+        sprintf(pkt + len + 1, "#%02x", sum & 0xff);
+        if (write(fd, pkt, len + 4) < 0) {
+                perror("write");
+        }
+}
+
+static unsigned int read_word(unsigned int off)
+{
+        unsigned int a, k, t;
+
+        if (off >= 0x8000) {
+                a = (page << 10) | ((off - 0x8000) >> 5);
+                k = (off >> 2) & 7;
+                if ((int)a >= depth || (int)k * 32 >= dbits) {
+                        return 0;
+                }
+                t = (a - index_) & (depth - 1);
+                t = t * (k + 1) ^ (k << 24);
+                if ((int)(k + 1) * 32 > dbits) {
+                        t &= (1U << (dbits & 31)) - 1;
+                }
+                return t;
+        }
+        switch (off) {
+        case 0x00:
+                if (armed && ++polls == 3) {
+                        armed = 0;
+                        index_ = (index_ + depth / 3) & (depth - 1);
+                }
+                return (1U << 31) | (armed << 29) | ((dbits & 0xff) << 20) |
+                       ((depth - 1) << 6) | 1;
+        case 0x04:
+                return index_;
+        case 0x08:
+                return page;
+        case 0x0C:
+                return count;
+        case 0x10:
+                return div_;
+        }
+        return 0;
+}
+
+static void write_word(unsigned int off, unsigned int v)
+{
+        switch (off) {
+        case 0x00:
+                armed = v & 1;
+                polls = 0;
+                break;
+        case 0x08:
+                page = v & 15;
+                break;
+        case 0x0C:
+                count = v & (depth - 1);
+                break;
+        case 0x10:
+                div_ = v & 0xffff;
+                break;
+        }
+}
+
+static void handle(int fd, char *cmd)
+{
+        static char reply[MAX_PKT];
+        unsigned int addr, len, i, w;
+        char *p;
+
+        if (strncmp(cmd, "qRcmd,", 6) == 0) {
+                /* Any command prints the core, as one hex encoded O packet */
+                p = "  LOGAN at 0x80100000\n";
+                reply[0] = 'O';
+                for (i = 0; p[i]; i++) {
+                        reply[1 + 2 * i] = hexchar[(p[i] >> 4) & 15];
+                        reply[2 + 2 * i] = hexchar[p[i] & 15];
+                }
+                reply[1 + 2 * i] = 0;
+                put_packet(fd, reply);
+                put_packet(fd, "OK");
+        } else if (sscanf(cmd, "m%x,%x", &addr, &len) == 2) {
+                if (len * 2 >= sizeof(reply) || (addr & 3) || (len & 3) ||
+                    addr < LOGAN_ADDR || addr + len > LOGAN_ADDR + 0x10000) {
+                        put_packet(fd, "E01");
+                        return;
+                }
+                for (i = 0; i < len; i += 4) {
+                        sprintf(reply + 2 * i, "%08x", read_word(addr - LOGAN_ADDR + i));
+                }
+                put_packet(fd, reply);
+        } else if (sscanf(cmd, "M%x,%x:%x", &addr, &len, &w) == 3 && len == 4 &&
+                   addr >= LOGAN_ADDR && addr < LOGAN_ADDR + 0x8000) {
+                write_word(addr - LOGAN_ADDR, w);
+                put_packet(fd, "OK");
+        } else if (strcmp(cmd, "D") == 0) {
+                put_packet(fd, "OK");
+        } else if (strcmp(cmd, "?") == 0) {
+                put_packet(fd, "S05");
+        } else {
+                put_packet(fd, "");
+        }
+}
+
+int main(int argc, char **argv)
+{
+        static char cmd[MAX_PKT];
+        unsigned char buf[4096];
+        struct sockaddr_in sa;
+        int port = 2222, s, fd, one = 1, n, i, len = -1, c;
+        unsigned int sum = 0, cs = 0;
+
+        for (i = 1; i + 1 < argc; i += 2) {
+                if (strcmp(argv[i], "-p") == 0) {
+                        port = atoi(argv[i + 1]);
+                } else if (strcmp(argv[i], "-d") == 0) {
+                        dbits = atoi(argv[i + 1]);
+                } else if (strcmp(argv[i], "-n") == 0) {
+                        depth = atoi(argv[i + 1]);
+                } else if (strcmp(argv[i], "-c") == 0) {
+                        count = atoi(argv[i + 1]);
+                }
+        }
+        if (dbits < 1 || dbits > 255 || depth < 256 || depth > 16384 || (depth & (depth - 1))) {
+                fprintf(stderr, "dbits 1 to 255, depth a power of two 256 to 16384\n");
+                return 1;
+        }
+        index_ = depth / 2;
+
+        s = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(s, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(s, 1) < 0) {
+                perror("bind");
+                return 1;
+        }
+        if ((fd = accept(s, NULL, NULL)) < 0) {
+                perror("accept");
+                return 1;
+        }
+        close(s);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        /* len is -1 outside a packet, -2 and -3 while reading the checksum */
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+                for (i = 0; i < n; i++) {
+                        c = buf[i];
+                        if (c == '$') {
+                                len = 0;
+                                sum = 0;
+                        } else if (len >= 0 && c == '#') {
+                                cmd[len] = 0;
+                                len = -2;
+                        } else if (len >= 0) {
+                                if (len < MAX_PKT - 1) {
+                                        cmd[len++] = c;
+                                }
+                                sum += c;
+                        } else if (len == -2) {
+                                cs = hexval(c) << 4;
+                                len = -3;
+                        } else if (len == -3) {
+                                cs |= hexval(c);
+                                len = -1;
+                                if (cs != (sum & 0xff)) {
+                                        if (write(fd, "-", 1) < 0) {
+                                                return 1;
+                                        }
+                                        continue;
+                                }
+                                if (write(fd, "+", 1) < 0) {
+                                        return 1;
+                                }
+                                handle(fd, cmd);
+                                if (strcmp(cmd, "D") == 0) {
+                                        close(fd);
+                                        return 0;
+                                }
+                        }
+                }
+        }
+        close(fd);
+        return 0;
+}
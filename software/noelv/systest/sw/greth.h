@@ -1,6 +1,8 @@
 #ifndef GRETH_H_
 #define GRETH_H_
 
-int greth_test(addr_t apbaddr);
+#include <stdint.h>
 
-#endif // end GRETH_H_
\ No newline at end of file
+int greth_test(uintptr_t apbaddr);
+
+#endif // end GRETH_H_
@@ -32,6 +32,11 @@ int report_subtest(int subtest);
 
 void report_mem_test(void);
 
+/*
+ * Benchmark id with its minimum and median cycles per run.
+ */
+void report_bench(int id, const char *name, unsigned int min, unsigned int median);
+
 int fail(int id);
 
 #ifdef __cplusplus
@@ -80,3 +80,10 @@ void report_mem_test(void)
 	grtestmod_write(7,1);
 }
 
+void report_bench(int id, const char *name, unsigned int min, unsigned int median)
+{
+	(void)name;
+	grtestmod_write(8, id);
+	grtestmod_write(9, min);
+	grtestmod_write(10, median);
+}
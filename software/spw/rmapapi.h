@@ -32,8 +32,39 @@ struct rmap_pkt
    char *srcspa;
 };
 
+/*maximum header size: 228 path bytes + 12 reply address bytes + 15 + crc*/
+#define RMAP_MAXHDR 256
+
+/*Pre-built header for a stream of commands/replies to the same node. Only
+  tid, addr and len differ between packets and the crc over the invariant
+  prefix is kept so that only the variable tail has to be recalculated*/
+struct rmap_hdr_tmpl
+{
+   int size;
+   int crcoff;
+   int tidoff;
+   int addroff;
+   int lenoff;
+   unsigned char prefixcrc;
+   char hdr[RMAP_MAXHDR];
+};
+
 int build_rmap_hdr(struct rmap_pkt *pkt, char *hdr, int *size);
 
+/*Calculates the RMAP crc over len bytes of buf starting from crc (0 for a
+  new packet)*/
+unsigned char rmap_crc(unsigned char crc, const char *buf, int len);
+
+/*Validates pkt and builds a header template from it. Returns the same error
+  codes as build_rmap_hdr*/
+int rmap_hdr_tmpl_init(struct rmap_pkt *pkt, struct rmap_hdr_tmpl *tmpl);
+
+/*Patches tid, addr and len into the template and updates the header crc.
+  Returns a pointer to the header which is tmpl->size bytes long excluding
+  the crc, the crc is stored at hdr[tmpl->size]. addr is ignored for
+  replies and len for write replies*/
+char *rmap_hdr_tmpl_fill(struct rmap_hdr_tmpl *tmpl, int tid, int addr, int len);
+
 int parse_rmap_pkt(struct rmap_pkt *pkt, char *hdr, int *size);
 
 
@@ -0,0 +1,217 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY */
+/*   Copyright (C) 2004 GAISLER RESEARCH */
+
+/*   This program is free software; you can redistribute it and/or modify */
+/*   it under the terms of the GNU General Public License as published by */
+/*   the Free Software Foundation; either version 2 of the License, or */
+/*   (at your option) any later version. */
+
+/*   See the file COPYING for the full details of the license. */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*RMAP read/write throughput of the hardware RMAP target compared to the     */
+/*software target in rmaptarg.c. Must be used with one device in loopback    */
+/*mode and at least two DMA channels. DMA channel 0 is the initiator, DMA    */
+/*channel 1 runs the software target                                         */
+/*****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "spwapi.h"
+#include "rmapapi.h"
+#include "rmapinit.h"
+#include "rmaptarg.h"
+
+#define SPW_ADDR    0x80000a00
+#define SPW_FREQ    200000       /* Frequency of txclk in khz, set to 0 to use reset value  */
+#define AHBFREQ     40000        /* Set to zero to leave reset values */
+#define SPW_CLKDIV  0
+
+#define NODEADDR    0x20         /* hardware target */
+#define INITADDR    0x21         /* DMA channel 0 */
+#define SWTADDR     0x22         /* DMA channel 1 */
+#define DESTKEY     0xBF
+
+#define WINADDR     0x40000000   /* RMAP address of the software target window */
+#define BENCHSIZE   (1024*1024)
+#define MAXOUT      16
+#define TIMEOUT     100000
+
+static struct spwvars spw;
+static struct rmapi init;
+static struct rmapt targ;
+
+static inline char loadb(int addr)
+{
+  char tmp;
+  asm(" lduba [%1]1, %0 "
+      : "=r"(tmp)
+      : "r"(addr)
+    );
+  return tmp;
+}
+
+static void bench_fail(const char *msg, int err)
+{
+        printf("%s: %d\n", msg, err);
+        exit(1);
+}
+
+/*Compares the target memory, read past the data cache, with buf*/
+static void bench_check(const char *what, char *mem, char *buf)
+{
+        int i;
+        for (i = 0; i < BENCHSIZE; i++) {
+                if (loadb((int)&mem[i]) != buf[i]) {
+                        printf("%s compare error at %d: %x, expected %x\n", what, i,
+                               (unsigned)loadb((int)&mem[i]) & 0xFF, (unsigned)buf[i] & 0xFF);
+                        exit(1);
+                }
+        }
+}
+
+/*Reads or writes len bytes in chunks keeping MAXOUT commands in flight.
+  The software target is polled from the same loop when swtarg is set*/
+static int bench_run(int write, int addr, char *buf, int len, int chunk, int swtarg)
+{
+        int off;
+        int err;
+        int tmp;
+        struct rmapi_trans *t;
+
+        off = 0;
+        err = 0;
+        while (((off < len) && !err) || init.outstanding) {
+                while ((off < len) && !err) {
+                        if (write) {
+                                tmp = rmapi_write(&init, addr + off, chunk, &buf[off], NULL, NULL);
+                        } else {
+                                tmp = rmapi_read(&init, addr + off, chunk, &buf[off], NULL, NULL);
+                        }
+                        if (tmp) {
+                                if (tmp != 1) {
+                                        err = RMAPI_ETX;
+                                }
+                                break;
+                        }
+                        off += chunk;
+                }
+                if (swtarg) {
+                        rmapt_poll(&targ);
+                }
+                rmapi_poll(&init);
+                while ((t = rmapi_reap(&init)) != NULL) {
+                        if (t->result && !err) {
+                                err = t->result;
+                        }
+                        rmapi_release(&init, t);
+                }
+        }
+        return err;
+}
+
+static void bench(const char *name, int write, int addr, char *buf, int chunk, int swtarg)
+{
+        clock_t t1, t2;
+        double time;
+        int err;
+
+        t1 = clock();
+        if ((err = bench_run(write, addr, buf, BENCHSIZE, chunk, swtarg))) {
+                bench_fail("RMAP transfer failed", err);
+        }
+        t2 = clock();
+        time = (double)(t2 - t1)/CLOCKS_PER_SEC;
+        printf("%s %-5s %6d byte commands: %8.3f Mbit/s\n", name, write ? "write" : "read",
+               chunk, ((double)BENCHSIZE*8)/(time*1000000));
+}
+
+/*Writes a pattern which differs from the previous chunk size to the target
+  memory mem at RMAP address addr, and reads it back into a cleared buf*/
+static void bench_rw(const char *name, int addr, char *mem, char *buf, int chunk, int swtarg)
+{
+        int i;
+        for (i = 0; i < BENCHSIZE; i++) {
+                buf[i] = (char)(i + chunk / 64);
+        }
+        bench(name, 1, addr, buf, chunk, swtarg);
+        bench_check("Write", mem, buf);
+        memset(buf, 0, BENCHSIZE);
+        bench(name, 0, addr, buf, chunk, swtarg);
+        bench_check("Read", mem, buf);
+}
+
+int main(void)
+{
+        int i;
+        int err;
+        int chunk;
+        char *mem;
+        char *buf;
+        struct rmap_pkt pkt;
+
+        printf("RMAP target benchmark\n");
+        if (spw_setparam(NODEADDR, SPW_CLKDIV, DESTKEY, 0, 0, SPW_ADDR, AHBFREQ, &spw, 0, SPW_FREQ/10000-1)) {
+                bench_fail("Illegal parameters to spacewire", 1);
+        }
+        for (i = 0; i < 4; i++) {
+                spw_setparam_dma(i, INITADDR + i, 0, 1, 65536, &spw);
+        }
+        if ((err = spw_init(&spw))) {
+                bench_fail("Link initialization failed", err);
+        }
+        if (spw.dmachan < 2) {
+                printf("Software target needs two DMA channels, test skipped\n");
+                exit(0);
+        }
+        for (i = 0; i < 2; i++) {
+                spw_set_chanadr(i, &spw);
+                spw_setsepaddr(i, &spw);
+        }
+        if (wait_running(&spw)) {
+                bench_fail("Link did not reach run state", 1);
+        }
+        if (((mem = malloc(BENCHSIZE)) == NULL) || ((buf = malloc(BENCHSIZE)) == NULL)) {
+                bench_fail("Buffer allocation failed", 1);
+        }
+        memset(mem, 0, BENCHSIZE);
+
+        memset(&pkt, 0, sizeof(pkt));
+        pkt.verify = no;
+        pkt.ack = yes;
+        pkt.incr = yes;
+        pkt.destkey = DESTKEY;
+        pkt.srcaddr = INITADDR;
+
+        pkt.destaddr = NODEADDR;
+        if ((err = rmapi_init(&init, &spw, 0, MAXOUT, 4096, TIMEOUT, &pkt))) {
+                bench_fail("Initiator init failed", err);
+        }
+        if (spw.rmap) {
+                spw_rmapen(&spw);
+                for (chunk = 64; chunk <= 4096; chunk *= 4) {
+                        bench_rw("hardware", (int)mem, mem, buf, chunk, 0);
+                }
+                spw_rmapdis(&spw);
+        } else {
+                printf("No hardware RMAP target\n");
+        }
+
+        pkt.destaddr = SWTADDR;
+        if ((err = rmapi_target(&init, &pkt))) {
+                bench_fail("Initiator retarget failed", err);
+        }
+        if ((err = rmapt_init(&targ, &spw, 1, DESTKEY, MAXOUT, 4096 + 32))) {
+                bench_fail("Software target init failed", err);
+        }
+        rmapt_add_window(&targ, WINADDR, BENCHSIZE, mem, RMAPT_READ | RMAPT_WRITE);
+        for (chunk = 64; chunk <= 4096; chunk *= 4) {
+                bench_rw("software", WINADDR, mem, buf, chunk, 1);
+        }
+        printf("Commands: %d, errors: %d\n", targ.cmds, targ.errors);
+        printf("*********** Benchmark completed successfully ************\n");
+        exit(0);
+}
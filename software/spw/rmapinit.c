@@ -0,0 +1,392 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY */
+/*   Copyright (C) 2004 GAISLER RESEARCH */
+
+/*   This program is free software; you can redistribute it and/or modify */
+/*   it under the terms of the GNU General Public License as published by */
+/*   the Free Software Foundation; either version 2 of the License, or */
+/*   (at your option) any later version. */
+
+/*   See the file COPYING for the full details of the license. */
+/*****************************************************************************/
+
+#include <stdlib.h>
+#include "spwapi.h"
+#include "rmapapi.h"
+#include "rmapinit.h"
+
+/*read reply header is 12 bytes including crc, then data and data crc*/
+#define RMAPI_RDHDR 12
+#define RMAPI_WRHDR 8
+
+static inline char loadb(int addr)
+{
+  char tmp;
+  asm(" lduba [%1]1, %0 "
+      : "=r"(tmp)
+      : "r"(addr)
+    );
+  return tmp;
+}
+
+static inline int loadmem(int addr)
+{
+  int tmp;
+  asm(" lda [%1]1, %0 "
+      : "=r"(tmp)
+      : "r"(addr)
+    );
+  return tmp;
+}
+
+/*crc over a dma buffer, bypassing the data cache*/
+static unsigned char rmapi_crcb(char *buf, int len)
+{
+        int i;
+        unsigned char crc = 0;
+        char b;
+        for (i = 0; i < len; i++) {
+                b = loadb((int)&buf[i]);
+                crc = rmap_crc(crc, &b, 1);
+        }
+        return crc;
+}
+
+/*the GRSPW transmits at most 255 header bytes and skips at most 15 path
+  address bytes in the header crc*/
+static int rmapi_hdrok(struct rmapi *r, struct rmap_hdr_tmpl *t)
+{
+        return (t->crcoff <= 15) && ((r->hwcrc ? t->size : t->size + 1) <= 255);
+}
+
+static void rmapi_complete(struct rmapi *r, int slot, int result)
+{
+        struct rmapi_trans *t = &r->trans[slot];
+        t->result = result;
+        t->state = RMAPI_DONE;
+        r->outstanding--;
+        r->completed++;
+        if (t->done != NULL) {
+                t->done(t, t->arg);
+                rmapi_release(r, t);
+        } else {
+                r->doneq[r->donehead] = slot;
+                r->donehead = (r->donehead + 1) & (RMAPI_MAXOUT - 1);
+        }
+}
+
+int rmapi_init(struct rmapi *r, struct spwvars *spw, int dmachan, int maxout,
+               int maxlen, int timeout, struct rmap_pkt *pkt)
+{
+        int i;
+
+        if ((maxout <= 0) || (maxout > RMAPI_MAXOUT) || (maxout > spw->ntxdesc) ||
+            (maxout > spw->nrxdesc)) {
+                return 1;
+        }
+        if ((maxlen <= 0) || ((maxlen + RMAPI_RDHDR + 4) > spw->dma[dmachan].rxmaxlen)) {
+                return 2;
+        }
+        r->spw = spw;
+        r->dmachan = dmachan;
+        r->hwcrc = spw->rmapcrc | spw->rmap;
+        r->maxout = maxout;
+        r->maxlen = maxlen;
+        r->timeout = timeout;
+        r->ticks = 0;
+        r->gen = 0;
+        r->outstanding = 0;
+        r->completed = 0;
+        r->txhead = r->txtail = 0;
+        r->donehead = r->donetail = 0;
+        r->rxpnt = 0;
+
+        r->nfree = 0;
+        for (i = maxout - 1; i >= 0; i--) {
+                r->trans[i].state = RMAPI_FREE;
+                r->trans[i].txbusy = 0;
+                r->freelist[r->nfree++] = i;
+        }
+        if (rmapi_target(r, pkt)) {
+                return 3;
+        }
+        for (i = 0; i < maxout; i++) {
+                if ((r->rxbuf[i] = malloc(maxlen + RMAPI_RDHDR + 4)) == NULL) {
+                        return 4;
+                }
+                if (spw_rx(dmachan, r->rxbuf[i], spw)) {
+                        return 5;
+                }
+        }
+        return 0;
+}
+
+int rmapi_target(struct rmapi *r, struct rmap_pkt *pkt)
+{
+        int i;
+        struct rmap_pkt cmd;
+
+        if (r->outstanding) {
+                return 1;
+        }
+        cmd = *pkt;
+        cmd.tid = 0;
+        cmd.addr = 0;
+        cmd.len = 0;
+        cmd.type = readcmd;
+        cmd.verify = no;
+        cmd.ack = yes;
+        if (rmap_hdr_tmpl_init(&cmd, &r->rdtmpl) || !rmapi_hdrok(r, &r->rdtmpl)) {
+                return 3;
+        }
+        cmd.type = writecmd;
+        cmd.verify = pkt->verify;
+        cmd.ack = pkt->ack;
+        if (rmap_hdr_tmpl_init(&cmd, &r->wrtmpl) || !rmapi_hdrok(r, &r->wrtmpl)) {
+                return 3;
+        }
+        r->wrack = pkt->ack;
+        /*slots copy the new templates on their next command*/
+        for (i = 0; i < r->maxout; i++) {
+                r->trans[i].write = -1;
+        }
+        return 0;
+}
+
+static int rmapi_submit(struct rmapi *r, int write, int addr, int len, char *data,
+                        rmapi_cb done, void *arg)
+{
+        int slot;
+        int tid;
+        int tmp;
+        char *hdr;
+        struct rmapi_trans *t;
+
+        if (r->nfree == 0) {
+                return 1;
+        }
+        slot = r->freelist[r->nfree-1];
+        t = &r->trans[slot];
+        if (t->write != write) {
+                t->hdr = write ? r->wrtmpl : r->rdtmpl;
+                t->write = write;
+        }
+        tid = ((r->gen << RMAPI_TIDSHIFT) | slot) & 0xFFFF;
+        hdr = rmap_hdr_tmpl_fill(&t->hdr, tid, addr, len);
+        if ((tmp = spw_tx(r->dmachan, r->hwcrc, write, t->hdr.crcoff,
+                          r->hwcrc ? t->hdr.size : t->hdr.size + 1, hdr,
+                          write ? len : 0, write ? data : hdr, r->spw))) {
+                /*only a busy descriptor is worth a retry*/
+                return tmp == 1 ? 1 : 4;
+        }
+        r->nfree--;
+        r->gen++;
+        t->tid = tid;
+        t->addr = addr;
+        t->len = len;
+        t->data = data;
+        t->done = done;
+        t->arg = arg;
+        t->start = r->ticks;
+        t->txbusy = 1;
+        t->state = RMAPI_PENDING;
+        r->outstanding++;
+        r->txq[r->txhead] = slot;
+        r->txhead = (r->txhead + 1) & (RMAPI_MAXOUT - 1);
+        return 0;
+}
+
+int rmapi_read(struct rmapi *r, int addr, int len, char *data, rmapi_cb done, void *arg)
+{
+        if ((len <= 0) || (len > r->maxlen)) {
+                return 3;
+        }
+        return rmapi_submit(r, 0, addr, len, data, done, arg);
+}
+
+int rmapi_write(struct rmapi *r, int addr, int len, char *data, rmapi_cb done, void *arg)
+{
+        if (!r->hwcrc) {
+                return 2;
+        }
+        if ((len <= 0) || (len > 16777215)) {
+                return 3;
+        }
+        return rmapi_submit(r, 1, addr, len, data, done, arg);
+}
+
+static void rmapi_rxreply(struct rmapi *r, char *buf, int size, struct rxstatus *rxs)
+{
+        int i;
+        int tid;
+        int slot;
+        int status;
+        int dlen;
+        struct rmapi_trans *t;
+
+        if (size < RMAPI_WRHDR) {
+                return;
+        }
+        /*not an rmap reply*/
+        if ((loadb((int)&buf[1]) != 1) || ((loadb((int)&buf[2]) >> 6) & 1)) {
+                return;
+        }
+        tid = ((loadb((int)&buf[5]) & 0xFF) << 8) | (loadb((int)&buf[6]) & 0xFF);
+        slot = tid & (RMAPI_MAXOUT - 1);
+        t = &r->trans[slot];
+        /*stale reply to a transaction which has already timed out*/
+        if ((slot >= r->maxout) || (t->state != RMAPI_PENDING) || (t->tid != tid)) {
+                return;
+        }
+        if (rxs->truncated || rxs->eep || rxs->hcrcerr || rxs->dcrcerr) {
+                rmapi_complete(r, slot, RMAPI_ERX);
+                return;
+        }
+        status = loadb((int)&buf[3]) & 0xFF;
+        if (t->write) {
+                if (!r->hwcrc && (rmapi_crcb(buf, RMAPI_WRHDR) != 0)) {
+                        rmapi_complete(r, slot, RMAPI_ERX);
+                } else {
+                        rmapi_complete(r, slot, status);
+                }
+                return;
+        }
+        if (size < RMAPI_RDHDR) {
+                rmapi_complete(r, slot, RMAPI_ELEN);
+                return;
+        }
+        if (!r->hwcrc && (rmapi_crcb(buf, RMAPI_RDHDR) != 0)) {
+                rmapi_complete(r, slot, RMAPI_ERX);
+                return;
+        }
+        if (status) {
+                rmapi_complete(r, slot, status);
+                return;
+        }
+        dlen = ((loadb((int)&buf[8]) & 0xFF) << 16) | ((loadb((int)&buf[9]) & 0xFF) << 8) |
+                (loadb((int)&buf[10]) & 0xFF);
+        if ((dlen != t->len) || (size < (RMAPI_RDHDR + dlen + 1))) {
+                rmapi_complete(r, slot, RMAPI_ELEN);
+                return;
+        }
+        /*rx buffers are word aligned so the data at offset 12 is too*/
+        i = 0;
+        if (((int)t->data & 3) == 0) {
+                for (; i < (dlen & ~3); i += 4) {
+                        *(int *)&t->data[i] = loadmem((int)&buf[RMAPI_RDHDR+i]);
+                }
+        }
+        for (; i < dlen; i++) {
+                t->data[i] = loadb((int)&buf[RMAPI_RDHDR+i]);
+        }
+        if (!r->hwcrc && (rmap_crc(0, t->data, dlen) != (loadb((int)&buf[RMAPI_RDHDR+dlen]) & 0xFF))) {
+                rmapi_complete(r, slot, RMAPI_ERX);
+                return;
+        }
+        rmapi_complete(r, slot, RMAPI_OK);
+}
+
+int rmapi_poll(struct rmapi *r)
+{
+        int i;
+        int tmp;
+        int slot;
+        int size;
+        int start;
+        struct rxstatus rxs;
+        struct rmapi_trans *t;
+
+        r->ticks++;
+        start = r->completed;
+        /*transmit descriptors complete in the order they were queued*/
+        while (r->txtail != r->txhead) {
+                if (!(tmp = spw_checktx(r->dmachan, r->spw))) {
+                        break;
+                }
+                slot = r->txq[r->txtail];
+                r->txtail = (r->txtail + 1) & (RMAPI_MAXOUT - 1);
+                t = &r->trans[slot];
+                t->txbusy = 0;
+                if (t->state == RMAPI_FREE) {
+                        r->freelist[r->nfree++] = slot;
+                } else if (t->state == RMAPI_PENDING) {
+                        if (tmp == 2) {
+                                rmapi_complete(r, slot, RMAPI_ETX);
+                        } else if (t->write && !r->wrack) {
+                                rmapi_complete(r, slot, RMAPI_OK);
+                        }
+                }
+        }
+        while (spw_checkrx(r->dmachan, &size, &rxs, r->spw)) {
+                rmapi_rxreply(r, r->rxbuf[r->rxpnt], size, &rxs);
+                spw_rx(r->dmachan, r->rxbuf[r->rxpnt], r->spw);
+                r->rxpnt++;
+                if (r->rxpnt == r->maxout) {
+                        r->rxpnt = 0;
+                }
+        }
+        if (r->timeout) {
+                for (i = 0; i < r->maxout; i++) {
+                        if ((r->trans[i].state == RMAPI_PENDING) &&
+                            ((r->ticks - r->trans[i].start) > r->timeout)) {
+                                rmapi_complete(r, i, RMAPI_ETIMEOUT);
+                        }
+                }
+        }
+        return r->completed - start;
+}
+
+struct rmapi_trans *rmapi_reap(struct rmapi *r)
+{
+        int slot;
+        if (r->donetail == r->donehead) {
+                return NULL;
+        }
+        slot = r->doneq[r->donetail];
+        r->donetail = (r->donetail + 1) & (RMAPI_MAXOUT - 1);
+        return &r->trans[slot];
+}
+
+void rmapi_release(struct rmapi *r, struct rmapi_trans *t)
+{
+        t->state = RMAPI_FREE;
+        /*the header is still referenced by a tx descriptor*/
+        if (!t->txbusy) {
+                r->freelist[r->nfree++] = t - r->trans;
+        }
+}
+
+int rmapi_dump(struct rmapi *r, int addr, int len, char *data)
+{
+        int off;
+        int chunk;
+        int err;
+        int tmp;
+        struct rmapi_trans *t;
+
+        off = 0;
+        err = 0;
+        while (((off < len) && !err) || r->outstanding) {
+                while ((off < len) && !err) {
+                        chunk = len - off;
+                        if (chunk > r->maxlen) {
+                                chunk = r->maxlen;
+                        }
+                        if ((tmp = rmapi_read(r, addr + off, chunk, &data[off], NULL, NULL))) {
+                                if (tmp != 1) {
+                                        err = RMAPI_ETX;
+                                }
+                                break;
+                        }
+                        off += chunk;
+                }
+                rmapi_poll(r);
+                while ((t = rmapi_reap(r)) != NULL) {
+                        if (t->result && !err) {
+                                err = t->result;
+                        }
+                        rmapi_release(r, t);
+                }
+        }
+        return err;
+}
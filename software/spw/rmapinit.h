@@ -0,0 +1,132 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY */
+/*   Copyright (C) 2004 GAISLER RESEARCH */
+
+/*   This program is free software; you can redistribute it and/or modify */
+/*   it under the terms of the GNU General Public License as published by */
+/*   the Free Software Foundation; either version 2 of the License, or */
+/*   (at your option) any later version. */
+
+/*   See the file COPYING for the full details of the license. */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*RMAP initiator with several outstanding transactions on one GRSPW DMA      */
+/*channel. Commands are transmitted without waiting for the previous reply,  */
+/*replies are matched on transaction id and may arrive in any order.         */
+/*Requires spwapi.h and rmapapi.h to be included before this file.           */
+/*****************************************************************************/
+
+/*maximum number of outstanding transactions, must be a power of two*/
+#define RMAPI_MAXOUT   64
+#define RMAPI_TIDSHIFT 6
+
+/*transaction states*/
+#define RMAPI_FREE     0
+#define RMAPI_PENDING  1
+#define RMAPI_DONE     2
+
+/*transaction result codes, positive values are RMAP status codes
+  from the target*/
+#define RMAPI_OK        0
+#define RMAPI_ETIMEOUT -1
+#define RMAPI_ETX      -2
+#define RMAPI_ERX      -3
+#define RMAPI_ELEN     -4
+
+struct rmapi_trans;
+
+typedef void (*rmapi_cb)(struct rmapi_trans *t, void *arg);
+
+struct rmapi_trans
+{
+   int  state;
+   int  tid;
+   int  write;
+   int  addr;
+   int  len;
+   char *data;
+   int  result;
+   int  start;
+   int  txbusy;
+   rmapi_cb done;
+   void *arg;
+   struct rmap_hdr_tmpl hdr;
+};
+
+struct rmapi
+{
+   struct spwvars *spw;
+   int    dmachan;
+   int    hwcrc;
+   int    wrack;
+   int    maxout;
+   int    maxlen;
+   int    timeout;
+   int    ticks;
+   int    gen;
+   int    outstanding;
+   int    completed;
+   /*free transaction slots*/
+   int    nfree;
+   int    freelist[RMAPI_MAXOUT];
+   /*slots in order of their tx descriptors*/
+   int    txhead;
+   int    txtail;
+   int    txq[RMAPI_MAXOUT];
+   /*completed transactions without a callback*/
+   int    donehead;
+   int    donetail;
+   int    doneq[RMAPI_MAXOUT];
+   /*rx buffers in order of their rx descriptors*/
+   int    rxpnt;
+   char   *rxbuf[RMAPI_MAXOUT];
+   struct rmap_hdr_tmpl rdtmpl;
+   struct rmap_hdr_tmpl wrtmpl;
+   struct rmapi_trans trans[RMAPI_MAXOUT];
+};
+
+/*Initializes the initiator. pkt supplies the target addressing (destaddr,
+  destkey, srcaddr, path addresses, ack/verify/incr), type, tid, addr and len
+  are ignored. maxout is the number of transactions kept in flight, maxlen the
+  largest read length and timeout the number of rmapi_poll calls after which
+  a transaction without reply is completed with RMAPI_ETIMEOUT. The DMA
+  channel must already be initialized with spw_init. Returns 0 on success,
+  1 for a bad maxout, 2 for a bad maxlen, 3 if the command headers are
+  invalid or too long for the GRSPW (more than 15 path address bytes or 255
+  header bytes), 4 if out of memory and 5 if an rx descriptor is busy*/
+int rmapi_init(struct rmapi *r, struct spwvars *spw, int dmachan, int maxout,
+               int maxlen, int timeout, struct rmap_pkt *pkt);
+
+/*Changes the target addressing to that of pkt, as for rmapi_init. Returns 0
+  on success, 1 while transactions are outstanding and 3 if the command
+  headers are invalid or too long for the GRSPW*/
+int rmapi_target(struct rmapi *r, struct rmap_pkt *pkt);
+
+/*Queues a read of len bytes from addr into data. Returns 0 when the command
+  has been transmitted, 1 if no transaction slot or descriptor is free and
+  the call should be retried, 3 if len is 0 or larger than maxlen and 4 if
+  spw_tx rejected the descriptor. done is called from rmapi_poll on completion, if NULL the transaction is
+  queued for rmapi_reap instead*/
+int rmapi_read(struct rmapi *r, int addr, int len, char *data, rmapi_cb done, void *arg);
+
+/*Queues a write of len bytes from data to addr. data must not be changed
+  until the transaction has completed. Same return values as rmapi_read with
+  a len limit of 16777215 bytes, 2 is returned if the GRSPW lacks RMAP crc
+  support*/
+int rmapi_write(struct rmapi *r, int addr, int len, char *data, rmapi_cb done, void *arg);
+
+/*Reaps transmit descriptors, matches received replies and times out stale
+  transactions. Returns the number of transactions completed*/
+int rmapi_poll(struct rmapi *r);
+
+/*Returns the next completed transaction without callback or NULL. The
+  transaction must be handed back with rmapi_release*/
+struct rmapi_trans *rmapi_reap(struct rmapi *r);
+
+void rmapi_release(struct rmapi *r, struct rmapi_trans *t);
+
+/*Reads len bytes from addr into data in chunks of at most r->maxlen bytes
+  keeping r->maxout reads in flight. Returns 0 on success, the first failing
+  transaction result or RMAPI_ETX if a read could not be queued*/
+int rmapi_dump(struct rmapi *r, int addr, int len, char *data);
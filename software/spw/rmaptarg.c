@@ -0,0 +1,297 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY */
+/*   Copyright (C) 2004 GAISLER RESEARCH */
+
+/*   This program is free software; you can redistribute it and/or modify */
+/*   it under the terms of the GNU General Public License as published by */
+/*   the Free Software Foundation; either version 2 of the License, or */
+/*   (at your option) any later version. */
+
+/*   See the file COPYING for the full details of the license. */
+/*****************************************************************************/
+
+#include <stdlib.h>
+#include "spwapi.h"
+#include "rmapapi.h"
+#include "rmaptarg.h"
+
+static inline char loadb(int addr)
+{
+  char tmp;
+  asm(" lduba [%1]1, %0 "
+      : "=r"(tmp)
+      : "r"(addr)
+    );
+  return tmp;
+}
+
+static inline int loadmem(int addr)
+{
+  int tmp;
+  asm(" lda [%1]1, %0 "
+      : "=r"(tmp)
+      : "r"(addr)
+    );
+  return tmp;
+}
+
+int rmapt_init(struct rmapt *t, struct spwvars *spw, int dmachan, int destkey,
+               int nbuf, int bufsize)
+{
+        int i;
+
+        if (!(spw->rmapcrc | spw->rmap)) {
+                return 1;
+        }
+        if ((nbuf <= 0) || (nbuf > spw->nrxdesc) || (nbuf > spw->ntxdesc) ||
+            (bufsize < 32) || (bufsize > spw->dma[dmachan].rxmaxlen) ||
+            (destkey < 0) || (destkey > 255)) {
+                return 2;
+        }
+        t->spw = spw;
+        t->dmachan = dmachan;
+        t->destkey = destkey;
+        t->nwin = 0;
+        t->nbuf = nbuf;
+        t->rxpnt = 0;
+        t->txhead = t->txtail = t->txcnt = 0;
+        t->cmds = 0;
+        t->errors = 0;
+        if ((t->rxbuf = (char **)malloc(nbuf * sizeof(char *))) == NULL) {
+                return 3;
+        }
+        if ((t->tx = (struct rmapt_txslot *)malloc(nbuf * sizeof(struct rmapt_txslot))) == NULL) {
+                return 3;
+        }
+        for (i = 0; i < nbuf; i++) {
+                if ((t->rxbuf[i] = malloc(bufsize)) == NULL) {
+                        return 3;
+                }
+                if (spw_rx(dmachan, t->rxbuf[i], spw)) {
+                        return 2;
+                }
+        }
+        return 0;
+}
+
+int rmapt_add_window(struct rmapt *t, int base, int len, char *mem, int flags)
+{
+        if (t->nwin == RMAPT_MAXWIN) {
+                return 1;
+        }
+        t->win[t->nwin].base = base;
+        t->win[t->nwin].len = len;
+        t->win[t->nwin].mem = mem;
+        t->win[t->nwin].flags = flags;
+        t->nwin++;
+        return 0;
+}
+
+static char *rmapt_lookup(struct rmapt *t, int addr, int len, int flags)
+{
+        int i;
+        unsigned int off;
+        for (i = 0; i < t->nwin; i++) {
+                off = (unsigned int)addr - (unsigned int)t->win[i].base;
+                if ((off < (unsigned int)t->win[i].len) &&
+                    ((unsigned int)len <= ((unsigned int)t->win[i].len - off)) &&
+                    ((t->win[i].flags & flags) == flags)) {
+                        return &t->win[i].mem[off];
+                }
+        }
+        return NULL;
+}
+
+static void rmapt_reap(struct rmapt *t)
+{
+        while (t->txcnt && spw_checktx(t->dmachan, t->spw)) {
+                t->txcnt--;
+                t->txtail++;
+                if (t->txtail == t->nbuf) {
+                        t->txtail = 0;
+                }
+        }
+}
+
+static void rmapt_serve(struct rmapt *t, char *buf, int size, struct rxstatus *rxs)
+{
+        int i;
+        int n;
+        int hlen;
+        int instr;
+        int addr;
+        int len;
+        int dlen;
+        int status;
+        int hsize;
+        int spalen;
+        char spa[12];
+        char *mem;
+        char *dbuf;
+        struct rmap_pkt reply;
+        struct rmapt_txslot *slot;
+
+        /*commands without a complete header can not be replied to*/
+        if ((size < 16) || ((loadb((int)&buf[1]) & 0xFF) != 1)) {
+                return;
+        }
+        instr = loadb((int)&buf[2]) & 0xFF;
+        if (!((instr >> 6) & 1)) {
+                return;
+        }
+        n = instr & 3;
+        hlen = 16 + 4*n;
+        if ((size < hlen) || rxs->hcrcerr) {
+                t->errors++;
+                return;
+        }
+        t->cmds++;
+        addr = ((loadb((int)&buf[8+4*n]) & 0xFF) << 24) |
+                ((loadb((int)&buf[9+4*n]) & 0xFF) << 16) |
+                ((loadb((int)&buf[10+4*n]) & 0xFF) << 8) |
+                (loadb((int)&buf[11+4*n]) & 0xFF);
+        len = ((loadb((int)&buf[12+4*n]) & 0xFF) << 16) |
+                ((loadb((int)&buf[13+4*n]) & 0xFF) << 8) |
+                (loadb((int)&buf[14+4*n]) & 0xFF);
+        dlen = size - hlen - 1;
+
+        /*wait for a free reply slot*/
+        while (t->txcnt == t->nbuf) {
+                rmapt_reap(t);
+        }
+        slot = &t->tx[t->txhead];
+        mem = NULL;
+        dbuf = slot->hdr;
+        status = RMAPT_ST_OK;
+        if ((instr >> 7) & 1) {
+                status = RMAPT_ST_UNUSED;
+        } else if (!((instr >> 5) & 1) && ((instr & 0x18) != 0x08) && ((instr & 0x1C) != 0x1C)) {
+                /*only read (verify=0,ack=1) and rmw (verify=1,ack=1,incr=1)*/
+                status = RMAPT_ST_UNUSED;
+        } else if ((loadb((int)&buf[3]) & 0xFF) != t->destkey) {
+                status = RMAPT_ST_KEY;
+        } else if (rxs->eep) {
+                status = RMAPT_ST_EEP;
+        } else if (loadb((int)&buf[7+4*n]) || !((instr >> 2) & 1)) {
+                /*extended addresses and non-incrementing access are not served*/
+                status = RMAPT_ST_AUTH;
+        } else if ((instr >> 5) & 1) {
+                if (rxs->truncated || (dlen > len)) {
+                        status = RMAPT_ST_TOOMUCH;
+                } else if (dlen < len) {
+                        status = RMAPT_ST_EARLYEOP;
+                } else if (rxs->dcrcerr) {
+                        status = RMAPT_ST_DCRC;
+                } else if ((mem = rmapt_lookup(t, addr, len, RMAPT_WRITE)) == NULL) {
+                        status = RMAPT_ST_AUTH;
+                } else {
+                        /*receive buffers are word aligned and so is the data*/
+                        i = 0;
+                        if (((int)mem & 3) == 0) {
+                                for (; i < (len & ~3); i += 4) {
+                                        *(int *)&mem[i] = loadmem((int)&buf[hlen+i]);
+                                }
+                        }
+                        for (; i < len; i++) {
+                                mem[i] = loadb((int)&buf[hlen+i]);
+                        }
+                }
+        } else if ((instr & 0x10)) {
+                if ((len != 2) && (len != 4) && (len != 8)) {
+                        status = RMAPT_ST_RMWLEN;
+                } else if (rxs->truncated || (dlen > len)) {
+                        status = RMAPT_ST_TOOMUCH;
+                } else if (dlen < len) {
+                        status = RMAPT_ST_EARLYEOP;
+                } else if (rxs->dcrcerr) {
+                        status = RMAPT_ST_DCRC;
+                } else if ((mem = rmapt_lookup(t, addr, len/2, RMAPT_READ | RMAPT_WRITE)) == NULL) {
+                        status = RMAPT_ST_AUTH;
+                } else {
+                        for (i = 0; i < len/2; i++) {
+                                slot->data[i] = mem[i];
+                                mem[i] = (loadb((int)&buf[hlen+i]) & loadb((int)&buf[hlen+len/2+i])) |
+                                        (slot->data[i] & ~loadb((int)&buf[hlen+len/2+i]));
+                        }
+                        dbuf = slot->data;
+                }
+                len = len/2;
+        } else if ((mem = rmapt_lookup(t, addr, len, RMAPT_READ)) == NULL) {
+                status = RMAPT_ST_AUTH;
+        } else {
+                dbuf = mem;
+        }
+        if (status != RMAPT_ST_OK) {
+                t->errors++;
+                len = 0;
+                dbuf = slot->hdr;
+        }
+        if (!((instr >> 3) & 1)) {
+                return;
+        }
+
+        /*reply address with leading zeros removed*/
+        spalen = 0;
+        for (i = 0; i < 4*n; i++) {
+                spa[spalen] = loadb((int)&buf[4+i]);
+                if (spalen || spa[spalen]) {
+                        spalen++;
+                }
+        }
+        if ((instr >> 5) & 1) {
+                reply.type = writerep;
+        } else if ((instr >> 4) & 1) {
+                reply.type = rmwrep;
+        } else {
+                reply.type = readrep;
+        }
+        reply.verify = no;
+        reply.ack = no;
+        reply.incr = no;
+        reply.destaddr = loadb((int)&buf[0]) & 0xFF;
+        reply.destkey = 0;
+        reply.srcaddr = loadb((int)&buf[4+4*n]) & 0xFF;
+        reply.tid = ((loadb((int)&buf[5+4*n]) & 0xFF) << 8) | (loadb((int)&buf[6+4*n]) & 0xFF);
+        reply.addr = 0;
+        reply.len = len;
+        reply.status = status;
+        reply.dstspalen = 0;
+        reply.dstspa = NULL;
+        reply.srcspalen = spalen;
+        reply.srcspa = spa;
+        if (build_rmap_hdr(&reply, slot->hdr, &hsize)) {
+                return;
+        }
+        /*the reply echoes the command instruction field with the command bit cleared*/
+        slot->hdr[spalen+2] = (char)(instr & ~0x40);
+        if (spw_tx(t->dmachan, 1, reply.type != writerep, spalen, hsize, slot->hdr,
+                   len, dbuf, t->spw)) {
+                t->errors++;
+                return;
+        }
+        t->txcnt++;
+        t->txhead++;
+        if (t->txhead == t->nbuf) {
+                t->txhead = 0;
+        }
+}
+
+int rmapt_poll(struct rmapt *t)
+{
+        int n;
+        int size;
+        struct rxstatus rxs;
+
+        n = 0;
+        rmapt_reap(t);
+        while (spw_checkrx(t->dmachan, &size, &rxs, t->spw)) {
+                rmapt_serve(t, t->rxbuf[t->rxpnt], size, &rxs);
+                spw_rx(t->dmachan, t->rxbuf[t->rxpnt], t->spw);
+                t->rxpnt++;
+                if (t->rxpnt == t->nbuf) {
+                        t->rxpnt = 0;
+                }
+                n++;
+        }
+        return n;
+}
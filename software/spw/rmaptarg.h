@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/*   This file is a part of the GRLIB VHDL IP LIBRARY */
+/*   Copyright (C) 2004 GAISLER RESEARCH */
+
+/*   This program is free software; you can redistribute it and/or modify */
+/*   it under the terms of the GNU General Public License as published by */
+/*   the Free Software Foundation; either version 2 of the License, or */
+/*   (at your option) any later version. */
+
+/*   See the file COPYING for the full details of the license. */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*Software RMAP target on a GRSPW DMA channel. Commands are served from      */
+/*registered memory windows. Read replies are transmitted directly from the  */
+/*window memory and write data is stored directly from the receive buffer    */
+/*into the window. Requires spwapi.h and rmapapi.h to be included before     */
+/*this file.                                                                 */
+/*****************************************************************************/
+
+#define RMAPT_MAXWIN  8
+
+/*window access flags*/
+#define RMAPT_READ    1
+#define RMAPT_WRITE   2
+
+/*RMAP reply status codes*/
+#define RMAPT_ST_OK       0
+#define RMAPT_ST_GENERAL  1
+#define RMAPT_ST_UNUSED   2
+#define RMAPT_ST_KEY      3
+#define RMAPT_ST_DCRC     4
+#define RMAPT_ST_EARLYEOP 5
+#define RMAPT_ST_TOOMUCH  6
+#define RMAPT_ST_EEP      7
+#define RMAPT_ST_AUTH     10
+#define RMAPT_ST_RMWLEN   11
+
+struct rmapt_window
+{
+   int  base;
+   int  len;
+   char *mem;
+   int  flags;
+};
+
+/*reply header and rmw data, kept until the tx descriptor is done*/
+struct rmapt_txslot
+{
+   char hdr[RMAP_MAXHDR];
+   char data[8];
+};
+
+struct rmapt
+{
+   struct spwvars *spw;
+   int    dmachan;
+   int    destkey;
+   int    nwin;
+   struct rmapt_window win[RMAPT_MAXWIN];
+   int    nbuf;
+   int    rxpnt;
+   char   **rxbuf;
+   int    txhead;
+   int    txtail;
+   int    txcnt;
+   struct rmapt_txslot *tx;
+   int    cmds;
+   int    errors;
+};
+
+/*Initializes the target on an already initialized DMA channel. nbuf receive
+  buffers of bufsize bytes are allocated and armed, bufsize limits the
+  largest write command. Returns 1 if the GRSPW has no RMAP crc support,
+  2 on illegal parameters, 3 on allocation failure and 0 on success*/
+int rmapt_init(struct rmapt *t, struct spwvars *spw, int dmachan, int destkey,
+               int nbuf, int bufsize);
+
+/*Makes len bytes at mem accessible at RMAP address base. Returns 1 if all
+  windows are in use*/
+int rmapt_add_window(struct rmapt *t, int base, int len, char *mem, int flags);
+
+/*Serves all received commands. Returns the number of commands served*/
+int rmapt_poll(struct rmapt *t);
@@ -0,0 +1,86 @@
+/*
+ * AHB trace buffer (AHBTRACE) capture
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include "ahbtrace.h"
+
+#define AHBTRACE_FILT (AHBTRACE_FW | AHBTRACE_FR | AHBTRACE_AF | AHBTRACE_RF | AHBTRACE_LERR)
+
+static volatile unsigned int *ahbtrace_reg(struct ahbtrace *t, unsigned int off)
+{
+        return (unsigned int *)(t->addr + off);
+}
+
+int ahbtrace_init(struct ahbtrace *t, unsigned int addr, int cm)
+{
+        volatile unsigned int *ctrl;
+        unsigned int v;
+
+        t->addr = addr;
+        ctrl = ahbtrace_reg(t, AHBTRACE_CTRL);
+        /* The delay counter is as wide as the index */
+        *ctrl = 0xffff0000 | (cm ? AHBTRACE_CM : 0);
+        v = *ctrl;
+        *ctrl = 0;
+        t->lines = (v >> 16) + 1;
+        t->stride = 16 << (AHBTRACE_BW(v) ? 1 : 0);
+        t->ctrl = cm ? AHBTRACE_CM : 0;
+        if (cm && !(v & AHBTRACE_CM)) {
+                return -1;
+        }
+        return 0;
+}
+
+void ahbtrace_filter(struct ahbtrace *t, unsigned int filt, unsigned int mmask,
+                     unsigned int smask, unsigned int waddr, unsigned int wmask)
+{
+        t->ctrl = (t->ctrl & ~AHBTRACE_FILT) | (filt & AHBTRACE_FILT);
+        *ahbtrace_reg(t, AHBTRACE_MASK) = (smask << 16) | (mmask & 0xffff);
+        *ahbtrace_reg(t, AHBTRACE_BPT2) = waddr & ~3;
+        *ahbtrace_reg(t, AHBTRACE_MSK2) = wmask & ~3;
+}
+
+void ahbtrace_start(struct ahbtrace *t)
+{
+        *ahbtrace_reg(t, AHBTRACE_CTRL) = t->ctrl;
+        *ahbtrace_reg(t, AHBTRACE_INDEX) = 0;
+        *ahbtrace_reg(t, AHBTRACE_TIMER) = 0;
+        *ahbtrace_reg(t, AHBTRACE_CTRL) = t->ctrl | AHBTRACE_EN;
+}
+
+void ahbtrace_stop(struct ahbtrace *t)
+{
+        *ahbtrace_reg(t, AHBTRACE_CTRL) = t->ctrl;
+}
+
+void ahbtrace_dump(struct ahbtrace *t)
+{
+        volatile unsigned int *e;
+        unsigned int ctrl, index, n, first, i, l;
+
+        ctrl = *ahbtrace_reg(t, AHBTRACE_CTRL);
+        index = *ahbtrace_reg(t, AHBTRACE_INDEX);
+        l = (index >> 4) & (t->lines - 1);
+        if (ctrl & AHBTRACE_CM) {
+                /* Line l is in use when words were written to it */
+                if (index & 0xc) {
+                        l++;
+                }
+                n = ctrl & AHBTRACE_WRAP ? t->lines : l;
+        } else {
+                /* Fixed entries give no sign of a wrap */
+                n = l;
+        }
+        first = (l - n) & (t->lines - 1);
+        printf("ahbtrace ctrl %08x index %08x lines %u\n", ctrl, index, n);
+        for (i = 0; i < n; i++) {
+                l = (first + i) & (t->lines - 1);
+                e = ahbtrace_reg(t, AHBTRACE_BUF + l * t->stride);
+                printf("l %u %08x %08x %08x %08x\n", l, e[0], e[1], e[2], e[3]);
+        }
+        printf("ahbtrace end\n");
+}
@@ -0,0 +1,242 @@
+/*
+ * Streaming of the DSU3 instruction and AHB trace buffers to RAM
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include <bcc/bcc.h>
+#include "isrhelper.h"
+#include "dsu3.h"
+#include "dsu3_stream.h"
+
+#define DSU3_TE         0x1             /* DSU control, trace enable */
+#define DSU3_AHB_EN     0x1             /* AHB trace control bits */
+#define DSU3_AHB_TIMER  0x40
+#define DSU3_AHB_BW     3
+
+static struct dsu3_stream *dsu3_active;
+
+static volatile unsigned int *dsu3_reg(struct dsu3_stream *s, unsigned int off)
+{
+        return (unsigned int *)(s->dsu + s->cpu * DSU3SIZE + off);
+}
+
+static void dsu3_mark(volatile unsigned int *e)
+{
+        e[0] = ~0;
+        e[1] = ~0;
+        e[2] = ~0;
+        e[3] = ~0;
+}
+
+/*
+ * Copies the entries before idx, or the whole buffer from idx on when the
+ * marker in the last entry was overwritten, and marks the last entry again
+ */
+static void dsu3_copy(struct dsu3_ring *r, volatile unsigned int *buf, unsigned int stride,
+                      unsigned int idx)
+{
+        volatile unsigned int *e, *last = buf + (r->size - 1) * stride;
+        unsigned int *p, first, n, i;
+
+        if ((last[0] & last[1] & last[2] & last[3]) != ~0U) {
+                first = idx;
+                n = r->size;
+                if (idx != 0) {
+                        r->wraps++;
+                }
+        } else {
+                first = 0;
+                n = idx;
+        }
+        for (i = 0; i < n; i++) {
+                e = buf + ((first + i) & (r->size - 1)) * stride;
+                p = r->ent[r->head++ & (r->nent - 1)];
+                p[0] = e[0];
+                p[1] = e[1];
+                p[2] = e[2];
+                p[3] = e[3];
+        }
+        dsu3_mark(last);
+}
+
+static void dsu3_off(struct dsu3_stream *s)
+{
+        *dsu3_reg(s, 0) &= ~DSU3_TE;
+        if (s->ahb.nent) {
+                *(volatile unsigned int *)(s->dsu + DSU3_AHBCTRL) &= ~DSU3_AHB_EN;
+        }
+}
+
+static void dsu3_on(struct dsu3_stream *s)
+{
+        if (s->ahb.nent) {
+                *(volatile unsigned int *)(s->dsu + DSU3_AHBCTRL) |= DSU3_AHB_TIMER | DSU3_AHB_EN;
+        }
+        *dsu3_reg(s, 0) |= DSU3_TE;
+}
+
+/* Tracing must be off */
+static void dsu3_collect(struct dsu3_stream *s)
+{
+        volatile unsigned int *tbctrl = dsu3_reg(s, DSU3_TBCTRL);
+        volatile unsigned int *aindex = (unsigned int *)(s->dsu + DSU3_AHBINDEX);
+
+        dsu3_copy(&s->itrace, dsu3_reg(s, DSU3_TBUF), 4, *tbctrl & (s->itrace.size - 1));
+        *tbctrl = s->tfilt << 28;
+        if (s->ahb.nent) {
+                dsu3_copy(&s->ahb, (unsigned int *)(s->dsu + DSU3_AHBBUF), s->astride / 4,
+                          (*aindex >> 4) & (s->ahb.size - 1));
+                *aindex = 0;
+        }
+        s->drains++;
+}
+
+static void dsu3_ring_init(struct dsu3_ring *r, unsigned int (*ent)[4], unsigned int nent,
+                           unsigned int size)
+{
+        r->ent = ent;
+        r->nent = nent;
+        r->head = 0;
+        r->size = size;
+        r->wraps = 0;
+}
+
+int dsu3_stream_init(struct dsu3_stream *s, unsigned int dsu, int cpu, unsigned int tfilt,
+                     unsigned int (*it)[4], unsigned int nit,
+                     unsigned int (*ahb)[4], unsigned int nahb)
+{
+        volatile unsigned int *actrl = (unsigned int *)(dsu + DSU3_AHBCTRL);
+        volatile unsigned int *tbctrl;
+        unsigned int size;
+
+        s->dsu = dsu;
+        s->cpu = cpu;
+        s->tfilt = tfilt & 0xf;
+        s->drains = 0;
+        s->gpt = NULL;
+        *dsu3_reg(s, 0) &= ~DSU3_TE;
+
+        /* Unimplemented index bits read 0 */
+        tbctrl = dsu3_reg(s, DSU3_TBCTRL);
+        *tbctrl = 0xffff;
+        size = (*tbctrl & 0xffff) + 1;
+        *tbctrl = s->tfilt << 28;
+        if (size == 1) {
+                return -1;
+        }
+        dsu3_ring_init(&s->itrace, it, nit, size);
+
+        size = 0;
+        if (nahb) {
+                /* The delay counter is as wide as the AHB trace index */
+                *actrl = 0xffff0000;
+                size = (*actrl >> 16) + 1;
+                /* Entries of bus widths above 32 bits take 32 bytes */
+                s->astride = (*actrl >> 3) & DSU3_AHB_BW ? 32 : 16;
+                *actrl = 0;
+                if (size == 1) {
+                        return -1;
+                }
+        }
+        dsu3_ring_init(&s->ahb, ahb, nahb, size);
+        return 0;
+}
+
+void dsu3_stream_ahbfilt(struct dsu3_stream *s, unsigned int filt, unsigned int mmask)
+{
+        *(volatile unsigned int *)(s->dsu + DSU3_AHBFILT) = filt;
+        *(volatile unsigned int *)(s->dsu + DSU3_AHBMFILT) = mmask & 0xffff;
+}
+
+void dsu3_stream_enable(struct dsu3_stream *s)
+{
+        dsu3_off(s);
+        *dsu3_reg(s, DSU3_TBCTRL) = s->tfilt << 28;
+        dsu3_mark(dsu3_reg(s, DSU3_TBUF + (s->itrace.size - 1) * 16));
+        s->itrace.head = 0;
+        s->itrace.wraps = 0;
+        if (s->ahb.nent) {
+                *(volatile unsigned int *)(s->dsu + DSU3_AHBINDEX) = 0;
+                dsu3_mark((unsigned int *)(s->dsu + DSU3_AHBBUF + (s->ahb.size - 1) * s->astride));
+                s->ahb.head = 0;
+                s->ahb.wraps = 0;
+        }
+        s->drains = 0;
+        dsu3_on(s);
+}
+
+void dsu3_stream_drain(struct dsu3_stream *s)
+{
+        dsu3_off(s);
+        dsu3_collect(s);
+        dsu3_on(s);
+}
+
+static void dsu3_irqhandler(int irq)
+{
+        struct dsu3_stream *s = dsu3_active;
+
+        (void)irq;
+        if (s == NULL) {
+                return;
+        }
+        s->gpt->timer[s->tn].control = GPTIMER_IP | GPTIMER_IE | GPTIMER_RS | GPTIMER_EN;
+        dsu3_stream_drain(s);
+}
+
+void dsu3_stream_start(struct dsu3_stream *s, struct gptimer *gpt, int tn, int irq,
+                       unsigned int tick)
+{
+        struct timerreg *t = &gpt->timer[tn];
+
+        s->gpt = gpt;
+        s->tn = tn;
+        s->irq = irq;
+        dsu3_active = s;
+        catch_interrupt(dsu3_irqhandler, irq);
+        bcc_int_unmask(irq);
+        t->control = 0;
+        t->reload = tick - 1;
+        t->counter = tick - 1;
+        dsu3_stream_enable(s);
+        t->control = GPTIMER_IP | GPTIMER_IE | GPTIMER_LD | GPTIMER_RS | GPTIMER_EN;
+}
+
+void dsu3_stream_stop(struct dsu3_stream *s)
+{
+        if (s->gpt != NULL) {
+                bcc_int_mask(s->irq);
+                s->gpt->timer[s->tn].control = GPTIMER_IP;
+                dsu3_active = NULL;
+        }
+        dsu3_off(s);
+        dsu3_collect(s);
+}
+
+static void dsu3_ring_dump(struct dsu3_ring *r, char c)
+{
+        unsigned int n, first, *p;
+
+        n = r->head < r->nent ? r->head : r->nent;
+        for (first = r->head - n; first != r->head; first++) {
+                p = r->ent[first & (r->nent - 1)];
+                printf("%c %08x %08x %08x %08x\n", c, p[0], p[1], p[2], p[3]);
+        }
+}
+
+void dsu3_stream_dump(struct dsu3_stream *s)
+{
+        printf("dsu3_stream drains %u\n", s->drains);
+        printf("dsu3_stream itrace cpu %d head %u size %u wraps %u\n", s->cpu,
+               s->itrace.head, s->itrace.size, s->itrace.wraps);
+        dsu3_ring_dump(&s->itrace, 'i');
+        if (s->ahb.nent) {
+                printf("dsu3_stream ahb head %u size %u wraps %u\n", s->ahb.head,
+                       s->ahb.size, s->ahb.wraps);
+                dsu3_ring_dump(&s->ahb, 'a');
+        }
+        printf("dsu3_stream end\n");
+}
@@ -1,6 +1,7 @@
 #include <greth.h>
 #include "testmod.h"
 #include "greth_api.h"
+#include "edcl.h"
 #include <stdlib.h>
 
 #define SRC_MAC0  0xDE
@@ -12,47 +13,6 @@
 
 static int snoopen;
 
-#if defined(__riscv)
-static inline int load(uintptr_t addr)
-{
-    int tmp;
-    asm volatile ("lw %0, 0(%1)"
-    : "=r"(tmp)
-    : "r"(addr)
-    );
-    return tmp;
-}
-
-static inline char loadb(uintptr_t addr)
-{
-  char tmp;
-    asm volatile ("lbu %0, 0(%1)"
-      : "=r"(tmp)
-      : "r"(addr)
-  );
-  return tmp;
-}
-#else // Leon3
-static inline int load(uintptr_t addr)
-{
-    int tmp;
-    asm volatile(" lda [%1]1, %0 "
-    : "=r"(tmp)
-    : "r"(addr)
-    );
-    return tmp;
-}
-
-static inline char loadb(uintptr_t addr)
-{
-  char tmp;
-    asm volatile (" lduba [%1]1, %0 "
-      : "=r"(tmp)
-      : "r"(addr)
-  );
-  return tmp;
-}
-#endif // end ifdef NOELV_SYSTEST
 
 
 struct greth_info greth;
@@ -126,10 +86,8 @@ static void build_ip(
     unsigned char *buf,
     unsigned int *len)
 {
-    int i;
     int iplen;
     int udplen;
-    int edclctrl;
     unsigned int crc;
     iplen = 38+dlen;
     udplen = 18+dlen;
@@ -185,22 +143,7 @@ static void build_ip(
     buf[39] = udplen & 0xFF;
     buf[40] = 0;
     buf[41] = 0;
-    buf[42] = 0;
-    buf[43] = 0;
-    edclctrl = ((seq & 0x3FFF) << 18) | (rw << 17) | ((dlen & 0x3FF) << 7);
-    buf[44] = (edclctrl >> 24) & 0xFF;
-    buf[45] = (edclctrl >> 16) & 0xFF;
-    buf[46] = (edclctrl >> 8) & 0xFF;
-    buf[47] = edclctrl & 0xFF;
-    buf[48] = (addr >> 24) & 0xFF;
-    buf[49] = (addr >> 16) & 0xFF;
-    buf[50] = (addr >> 8) & 0xFF;
-    buf[51] = addr & 0xFF;
-    if (rw) {
-        for(i = 0; i < dlen; i++) {
-            buf[52+i] = data[i];
-        }
-    }
+    edcl_build(&buf[42], seq, rw, addr, dlen, data);
 }
 
 #define report_fail(x) fail(x); return x;
@@ -209,7 +152,6 @@ int greth_test(uintptr_t apbaddr)
 {
     int tmp, i;
     int *len;
-    unsigned char tmp2;
     unsigned char txbuf[256];
     unsigned char rxbuf[256];
     unsigned char wrarea[100];
@@ -277,40 +219,15 @@ int greth_test(uintptr_t apbaddr)
         /* packet of incorrect length received */
         report_fail(1);
     }
-#if defined(__riscv)
     for (i = 0; i < 256; i++) {
-        if (rxbuf[i] != txbuf[i]) {
+        if (dma_load8((uintptr_t)&rxbuf[i]) != txbuf[i]) {
             report_fail(2);
         }
     }
-#else // Leon3 (big endian check)
-    for (i = 0; i < 256; i++) {
-        if ((i % 4) == 0) {
-            tmp = load((uintptr_t)&rxbuf[i]);
-        }
-        switch(i % 4) {
-            case 0:
-                tmp2 = (unsigned char)((tmp >> 24) & 0xFF);
-                break;
-            case 1:
-                tmp2 = (unsigned char)((tmp >> 16) & 0xFF);
-                break;
-            case 2:
-                tmp2 = (unsigned char)((tmp >> 8) & 0xFF);
-                break;
-            case 3:
-                tmp2 = (unsigned char)(tmp & 0xFF);
-                break;
-        }
-        if (tmp2 != txbuf[i]) {
-            report_fail(2);
-        }
-    }
-#endif
     /* Test EDCL if present and enabled */
     if (greth.edcl && greth.edclen) {
         /* read ip address */
-        ipaddr = load((uintptr_t)&greth.regs->edclip);
+        ipaddr = mmio_load32((uintptr_t)&greth.regs->edclip);
 
         buf = malloc(256);
         /* send arp packet to acquire edcl mac address */
@@ -320,8 +237,8 @@ int greth_test(uintptr_t apbaddr)
         while(!greth_tx(*len, buf, &greth));
         while(!greth_checkrx(len, rxs, &greth));
 
-        emac_addr_msb = ((loadb((uintptr_t)&rxbuf[22]) & 0xFF) << 16) | ((loadb((uintptr_t)&rxbuf[23]) & 0xFF) << 8) | (loadb((uintptr_t)&rxbuf[24]) & 0xFF);
-        emac_addr_lsb = ((loadb((uintptr_t)&rxbuf[25]) & 0xFF) << 16) | ((loadb((uintptr_t)&rxbuf[26]) & 0xFF) << 8) | (loadb((uintptr_t)&rxbuf[27]) & 0xFF);
+        emac_addr_msb = ((dma_load8((uintptr_t)&rxbuf[22]) & 0xFF) << 16) | ((dma_load8((uintptr_t)&rxbuf[23]) & 0xFF) << 8) | (dma_load8((uintptr_t)&rxbuf[24]) & 0xFF);
+        emac_addr_lsb = ((dma_load8((uintptr_t)&rxbuf[25]) & 0xFF) << 16) | ((dma_load8((uintptr_t)&rxbuf[26]) & 0xFF) << 8) | (dma_load8((uintptr_t)&rxbuf[27]) & 0xFF);
 
         /* send zero length read to acquire sequence number */
         build_ip(emac_addr_msb, emac_addr_lsb, 0xDEADBE, 0xEF0020, ipaddr,
@@ -331,7 +248,7 @@ int greth_test(uintptr_t apbaddr)
         while(!greth_tx(*len, buf, &greth));
         while(!greth_checkrx(len, rxs, &greth));
 
-        tmp = ((loadb((uintptr_t)&rxbuf[44]) & 0xFF) << 24) | ((loadb((uintptr_t)&rxbuf[45]) & 0xFF) << 16) | ((loadb((uintptr_t)&rxbuf[46]) & 0xFF) << 8) | (loadb((uintptr_t)&rxbuf[47]) & 0xFF);
+        tmp = ((dma_load8((uintptr_t)&rxbuf[44]) & 0xFF) << 24) | ((dma_load8((uintptr_t)&rxbuf[45]) & 0xFF) << 16) | ((dma_load8((uintptr_t)&rxbuf[46]) & 0xFF) << 8) | (dma_load8((uintptr_t)&rxbuf[47]) & 0xFF);
 
         if ((tmp >> 17) & 1) {
             seq = (tmp >> 18) & 0x3FFF;
@@ -347,7 +264,7 @@ int greth_test(uintptr_t apbaddr)
         while(!greth_tx(*len, buf, &greth));
         while(!greth_checkrx(len, rxs, &greth));
 
-        if ((loadb((uintptr_t)&rxbuf[45]) >> 1) & 1) {
+        if ((dma_load8((uintptr_t)&rxbuf[45]) >> 1) & 1) {
             /* unexpected nak */
             report_fail(3);
         }
@@ -366,32 +283,11 @@ int greth_test(uintptr_t apbaddr)
             report_fail(4);
         }
 
-#if defined(__riscv)
         for (i = 0; i < 72; i++) {
-            if (rxbuf[52 + i] != txbuf[i]) {
-                report_fail(5);
-            }
-        }
-#else // Leon3 (big endian check)
-        for(i = 0; i < 72; i++) {
-            if ((i % 4) == 0) {
-                tmp = load((uintptr_t)&rxbuf[52+i]);
-            }
-            switch(i % 4) {
-                case 0: tmp2 = (unsigned char)((tmp >> 24) & 0xFF);
-                    break;
-                case 1: tmp2 = (unsigned char)((tmp >> 16) & 0xFF);
-                    break;
-                case 2: tmp2 = (unsigned char)((tmp >> 8) & 0xFF);
-                    break;
-                case 3: tmp2 = (unsigned char)(tmp & 0xFF);
-                    break;
-            }
-            if (tmp2 != txbuf[i]) {
+            if (dma_load8((uintptr_t)&rxbuf[52 + i]) != txbuf[i]) {
                 report_fail(5);
             }
         }
-#endif
         free(buf);
     }
 
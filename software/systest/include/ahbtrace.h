@@ -0,0 +1,64 @@
+#ifndef AHBTRACE_H_
+#define AHBTRACE_H_
+
+/*
+ * AHB trace buffer (AHBTRACE) capture
+ *
+ * With compressed records, bursts are stored as one record of one to three
+ * words and transfer data is not stored, see ahbtrace_mmb.vhd. The buffer
+ * then holds several times more transfers than with the fixed 128-bit
+ * entries. ahbtrace_dump() prints the buffer for tools/ahbtrace_decode.
+ */
+
+#define AHBTRACE_CTRL           0x00
+#define AHBTRACE_INDEX          0x04
+#define AHBTRACE_TIMER          0x08
+#define AHBTRACE_MASK           0x0C    /* Slave mask 31:16, master mask 15:0 */
+#define AHBTRACE_BPT1           0x10
+#define AHBTRACE_MSK1           0x14
+#define AHBTRACE_BPT2           0x18    /* Address window of AHBTRACE_AF */
+#define AHBTRACE_MSK2           0x1C
+#define AHBTRACE_BUF            0x10000
+
+/* Control register */
+#define AHBTRACE_EN             0x001
+#define AHBTRACE_DCNTEN         0x002
+#define AHBTRACE_FW             0x004   /* Filter out writes */
+#define AHBTRACE_FR             0x008   /* Filter out reads */
+#define AHBTRACE_AF             0x010   /* Filter out addresses outside window */
+#define AHBTRACE_RF             0x020   /* Filter out retry responses */
+#define AHBTRACE_LERR           0x200   /* Only trace error responses */
+#define AHBTRACE_CM             0x400   /* Compressed records */
+#define AHBTRACE_WRAP           0x800   /* Index wrapped, compressed records */
+#define AHBTRACE_BW(ctrl)       (((ctrl) >> 6) & 3)
+
+struct ahbtrace {
+        unsigned int addr;
+        unsigned int lines;             /* Buffer lines */
+        unsigned int stride;            /* Bytes per line */
+        unsigned int ctrl;              /* Filter and mode bits */
+};
+
+/*
+ * Finds the size of the buffer at addr. Returns 0, or -1 if compressed
+ * records are requested with cm but not implemented.
+ */
+int ahbtrace_init(struct ahbtrace *t, unsigned int addr, int cm);
+
+/*
+ * Sets the filter bits, the masks of masters and slaves not traced, and
+ * the address window used with AHBTRACE_AF. The filters need the ahbfilt
+ * generic.
+ */
+void ahbtrace_filter(struct ahbtrace *t, unsigned int filt, unsigned int mmask,
+                     unsigned int smask, unsigned int waddr, unsigned int wmask);
+
+/* Clears the index and starts tracing */
+void ahbtrace_start(struct ahbtrace *t);
+
+void ahbtrace_stop(struct ahbtrace *t);
+
+/* Prints the used lines of the buffer, oldest first */
+void ahbtrace_dump(struct ahbtrace *t);
+
+#endif
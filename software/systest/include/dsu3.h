@@ -5,12 +5,15 @@
 #define DSU3_MASK 	0x000024
 #define DSU3_AHBCTRL	0x000040
 #define DSU3_AHBINDEX	0x000044
+#define DSU3_AHBFILT	0x000048
+#define DSU3_AHBMFILT	0x00004C
 #define DSU3_AHBBPT1	0x000050
 #define DSU3_AHBMSK1	0x000054
 #define DSU3_AHBBPT2	0x000058
 #define DSU3_AHBMSK2	0x00005C
 #define DSU3_TBUF 	0x100000
 #define DSU3_TBCTRL 	0x110000
+#define DSU3_TBCTRL2 	0x110004
 #define DSU3_AHBBUF	0x200000
 #define DSU3_RFILE	0x300000
 #define DSU3_RFILEPAR   0x300800
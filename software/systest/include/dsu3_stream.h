@@ -0,0 +1,94 @@
+#ifndef DSU3_STREAM_H_
+#define DSU3_STREAM_H_
+
+/*
+ * Streaming of the DSU3 instruction and AHB trace buffers to RAM
+ *
+ * The trace buffers only hold the last few hundred entries. A stream
+ * drains them into larger rings in RAM, either from a GPTIMER tick or by
+ * calls to dsu3_stream_drain(), so that traces much longer than the
+ * buffers can be taken. dsu3_stream_dump() prints the rings for
+ * tools/dsu3_decode.
+ *
+ * A drain stops tracing, copies the entries written since the last drain,
+ * resets the buffer index and starts tracing again, so the drain itself
+ * is not traced. The last entry of each buffer is filled with a marker
+ * after a drain. When the marker is overwritten by the next drain, the
+ * buffer has wrapped: its entries are still copied oldest first, but
+ * older ones were lost and the wrap is counted. The drain period must be
+ * short enough for this not to happen.
+ *
+ * The DSU must be enabled for the instruction trace to be written.
+ */
+
+#include "gptimer.h"
+
+/* Instruction trace filter, TBCTRL bits 31:28 */
+#define DSU3_TFILT_ALL          0x0
+#define DSU3_TFILT_BICC         0x1     /* Bicc and sethi */
+#define DSU3_TFILT_CFC          0x2     /* Control-flow changes */
+#define DSU3_TFILT_CALL         0x4
+#define DSU3_TFILT_NORMAL       0x8
+#define DSU3_TFILT_LDST         0xC
+#define DSU3_TFILT_LDSTA        0xD     /* Alternate space loads/stores */
+#define DSU3_TFILT_LDSTA80      0xE     /* Same, ASI 0x80 and above */
+
+/* AHB trace filter register, entries matching a set bit are not traced */
+#define DSU3_AFILT_WRITE        0x1
+#define DSU3_AFILT_READ         0x2
+#define DSU3_AFILT_ADDR         0x4     /* Outside AHB breakpoint 2 range */
+
+struct dsu3_ring {
+        unsigned int (*ent)[4];         /* Entries of four words */
+        unsigned int nent;              /* Power of 2 */
+        unsigned int head;              /* Entries written */
+        unsigned int size;              /* Entries of the trace buffer */
+        unsigned int wraps;             /* Drains finding the buffer wrapped */
+};
+
+struct dsu3_stream {
+        unsigned int dsu;
+        int cpu;                        /* CPU of the instruction trace */
+        unsigned int tfilt;
+        unsigned int astride;           /* Bytes per AHB trace entry */
+        unsigned int drains;
+        struct dsu3_ring itrace;
+        struct dsu3_ring ahb;           /* nent 0 when not streamed */
+        struct gptimer *gpt;
+        int tn;
+        int irq;
+};
+
+/*
+ * Initializes a stream on the DSU3 at dsu, for the instruction trace of
+ * cpu filtered by tfilt into it[0..nit-1], and the AHB trace into
+ * ahb[0..nahb-1] when nahb is not 0. Ring sizes must be powers of 2.
+ * Returns 0, or -1 if a requested trace buffer is not implemented.
+ */
+int dsu3_stream_init(struct dsu3_stream *s, unsigned int dsu, int cpu, unsigned int tfilt,
+                     unsigned int (*it)[4], unsigned int nit,
+                     unsigned int (*ahb)[4], unsigned int nahb);
+
+/* Sets the AHB trace filter and the mask of AHB masters not traced */
+void dsu3_stream_ahbfilt(struct dsu3_stream *s, unsigned int filt, unsigned int mmask);
+
+/* Clears the buffers and starts tracing */
+void dsu3_stream_enable(struct dsu3_stream *s);
+
+/* Copies the new trace entries to the rings, callable from interrupts */
+void dsu3_stream_drain(struct dsu3_stream *s);
+
+/*
+ * Enables tracing and drains every tick timer units of timer tn of the
+ * GPTIMER gpt, which interrupts on irq.
+ */
+void dsu3_stream_start(struct dsu3_stream *s, struct gptimer *gpt, int tn, int irq,
+                       unsigned int tick);
+
+/* Stops the timer and tracing, and drains what is left */
+void dsu3_stream_stop(struct dsu3_stream *s);
+
+/* Prints the rings */
+void dsu3_stream_dump(struct dsu3_stream *s);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef LSTAT_PROF_H_
+#define LSTAT_PROF_H_
+
+/*
+ * Profiling sessions on the L3STAT/L4STAT counters
+ *
+ * A session counts a list of (CPU, event) slots. When there are more slots
+ * than physical counters, the slots are split in sets of ncnt which take
+ * turns on the counters, one set per GPTIMER tick. Each slot remembers how
+ * long it was counted, and results are scaled to the whole session.
+ *
+ * Slots are normally added by group. The derived metrics printed by
+ * lprof_report() use the events of the groups below.
+ */
+
+#include "gptimer.h"
+#include "lstat.h"
+
+#define LPROF_MAX_SLOT 64
+
+/* Events counted once for the whole system, on CPU field 0 */
+#define LPROF_GLOBAL(ev) ((ev) == LSTAT_ahbtutil)
+
+struct lprof_group {
+        const char *name;
+        int nev;
+        const unsigned char *ev;
+};
+
+/* Cache, AHB, branch and FPU groups */
+extern const struct lprof_group lprof_cache;
+extern const struct lprof_group lprof_ahb;
+extern const struct lprof_group lprof_branch;
+extern const struct lprof_group lprof_fpu;
+
+struct lprof_slot {
+        unsigned char cpu;
+        unsigned char ev;
+        unsigned long long count;       /* Raw count while active */
+        unsigned long long active;      /* Timer units the slot was counted */
+};
+
+struct lprof {
+        volatile unsigned int *val;
+        volatile unsigned int *ctrl;
+        struct gptimer *gpt;
+        int tn;                         /* GPTIMER timer driving the rotation */
+        int irq;
+        unsigned int tick;              /* Timer units per tick */
+        int ncnt;                       /* Physical counters */
+        int nslot;
+        int cur;                        /* First slot of the counting set */
+        unsigned long long total;       /* Timer units of the session */
+        unsigned int ticks;
+        struct lprof_slot slot[LPROF_MAX_SLOT];
+};
+
+/*
+ * Initializes a session on the L3STAT/L4STAT at addr, rotated by timer tn
+ * of the GPTIMER gpt which interrupts on irq. Returns 0.
+ */
+int lprof_init(struct lprof *p, unsigned int addr, struct gptimer *gpt, int tn, int irq);
+
+/* Adds one slot. Returns 0, or -1 when the session is full. */
+int lprof_add(struct lprof *p, int cpu, int event);
+
+/* Adds the events of g for each CPU in cpumask. Returns 0 or -1. */
+int lprof_add_group(struct lprof *p, unsigned int cpumask, const struct lprof_group *g);
+
+/*
+ * Starts counting, rotating sets every tick timer units (prescaler ticks
+ * of the GPTIMER). tick must be short enough for no counter to wrap.
+ */
+void lprof_start(struct lprof *p, unsigned int tick);
+
+/* Stops counting and collects the set counting at the moment */
+void lprof_stop(struct lprof *p);
+
+/*
+ * Scaled count of an event over the session, or -1 when it was not
+ * counted.
+ */
+double lprof_value(struct lprof *p, int cpu, int event);
+
+/* Prints the scaled events and derived metrics for each CPU */
+void lprof_report(struct lprof *p);
+
+#endif
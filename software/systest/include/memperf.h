@@ -0,0 +1,46 @@
+#ifndef MEMPERF_H_
+#define MEMPERF_H_
+
+/*
+ * Memory performance suite
+ *
+ * - STREAM copy, scale, add and triad on 32-bit words, in MB/s.
+ * - Load latency by chasing a random cyclic list with one element per
+ *   cache line, for working sets from a quarter of the L1 data cache to
+ *   four times the L2, which shows the L1, L2 and memory steps.
+ * - Loads with strides from one word to eight cache lines over a region
+ *   larger than the caches.
+ *
+ * The sizes come from the cache configuration registers (%asi 2, 0x8 and
+ * 0xC) and the L2C status register. The tests run in a RAM area given by
+ * the caller, which should be at least 12 times the largest cache. Times
+ * come from the time-stamp counter, see tsc_init(). On NOEL-V the L1
+ * sizes are MEMPERF_L1D and MEMPERF_LINE.
+ */
+
+#ifndef MEMPERF_L1D
+#define MEMPERF_L1D     (16 * 1024)
+#endif
+#ifndef MEMPERF_LINE
+#define MEMPERF_LINE    32
+#endif
+
+struct memperf_cfg {
+        unsigned int l1d;               /* L1 data cache bytes */
+        unsigned int line;              /* L1 data cache line bytes */
+        unsigned int l2;                /* L2 cache bytes, 0 without L2C */
+        int l2en;                       /* L2 cache enabled */
+};
+
+/* l2reg is the L2C register base, or 0 */
+void memperf_probe(volatile int *l2reg, struct memperf_cfg *c);
+
+/*
+ * Runs and prints all tests on size bytes at buf, at mhz MHz. Returns 0,
+ * or -1 if the area is smaller than the first test needs or a result was
+ * wrong.
+ */
+int memperf_run(volatile int *l2reg, unsigned int dsu_addr, unsigned int mhz,
+                unsigned int *buf, unsigned int size);
+
+#endif
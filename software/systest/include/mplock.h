@@ -0,0 +1,79 @@
+#ifndef MPLOCK_H_
+#define MPLOCK_H_
+
+/*
+ * Scalable MP locks and barrier
+ *
+ * The ldstub semaphore of mptest makes every waiting CPU retry an atomic
+ * on the same word, and its psync() barrier has every CPU read the flags
+ * of all CPUs. Here waiters spin in their cache on one word that is
+ * written once per hand-over, which needs snooping caches:
+ *
+ * - ticket lock: casa takes a ticket, waiters spin on the owner word.
+ *   FIFO, one invalidation of all waiters per release.
+ * - MCS lock: swap enqueues a per-CPU node, each waiter spins on its own
+ *   node. FIFO, the release only touches the next waiter's line.
+ * - barrier: casa counts arrivals, the last CPU flips the sense word that
+ *   the others spin on.
+ *
+ * Lock words and nodes are aligned to their own cache line. casa needs a
+ * LEON3 with CAS support, or LEON4/LEON5.
+ */
+
+#define MP_LINE         32
+#define MP_MAX_CPU      16
+
+struct mp_tas {
+        volatile unsigned char lock;
+} __attribute__ ((aligned (MP_LINE)));
+
+struct mp_ticket {
+        volatile unsigned int next __attribute__ ((aligned (MP_LINE)));
+        volatile unsigned int owner __attribute__ ((aligned (MP_LINE)));
+};
+
+struct mcs_node {
+        struct mcs_node *volatile next;
+        volatile unsigned int locked;
+} __attribute__ ((aligned (MP_LINE)));
+
+struct mp_mcs {
+        struct mcs_node *volatile tail;
+} __attribute__ ((aligned (MP_LINE)));
+
+struct mp_barrier {
+        volatile unsigned int count __attribute__ ((aligned (MP_LINE)));
+        volatile unsigned int sense __attribute__ ((aligned (MP_LINE)));
+        unsigned int n;
+};
+
+/* All locks are unlocked when zeroed */
+void mp_tas_lock(struct mp_tas *l);
+void mp_tas_unlock(struct mp_tas *l);
+
+void mp_ticket_lock(struct mp_ticket *l);
+void mp_ticket_unlock(struct mp_ticket *l);
+
+/* The node is owned by the caller until the unlock returns */
+void mp_mcs_lock(struct mp_mcs *l, struct mcs_node *n);
+void mp_mcs_unlock(struct mp_mcs *l, struct mcs_node *n);
+
+/* Must be done before any CPU waits on the barrier */
+void mp_barrier_init(struct mp_barrier *b, unsigned int n);
+
+/*
+ * Returns when n CPUs have called it. *sense is a per-CPU variable,
+ * initially 0, that the caller keeps between calls.
+ */
+void mp_barrier_wait(struct mp_barrier *b, unsigned int *sense);
+
+/*
+ * Contention benchmark, run by all CPUs. Each lock is taken a fixed number
+ * of times by 1 to ncpu CPUs at once, and CPU 0 prints the acquisitions
+ * per second at mhz. The DSU at dsu_addr gives the time-stamp counter,
+ * see tsc_init(). CPU 0 starts the other CPUs. Returns 0, or -1 if the
+ * shared count was wrong.
+ */
+int mp_lock_bench(volatile int *irqmp_ptr, unsigned int dsu_addr, unsigned int mhz);
+
+#endif
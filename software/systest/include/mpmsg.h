@@ -0,0 +1,65 @@
+#ifndef MPMSG_H_
+#define MPMSG_H_
+
+/*
+ * Inter-processor message queues with IRQMP doorbells
+ *
+ * Every ordered pair of CPUs has a single-producer single-consumer ring of
+ * 32-bit messages, so no atomics are needed. The producer index, the
+ * consumer index and the slots are on separate cache lines, and each side
+ * keeps a copy of the other side's index that it only refreshes when the
+ * ring looks full or empty. A batch is published with one index write.
+ *
+ * A CPU that calls mpmsg_irq_enable() is armed: a send to it rings the
+ * doorbell, forcing the mpmsg interrupt in its IRQMP force register. The
+ * interrupt handler disarms, drains all rings to the CPU in batches, and
+ * re-arms before checking the rings once more, so that no message is left
+ * without a doorbell. CPUs that are not armed poll with mpmsg_recv().
+ *
+ * Caches must snoop. Messages keep their order per CPU pair only.
+ */
+
+#ifndef MPMSG_MAX_CPU
+#define MPMSG_MAX_CPU   4
+#endif
+#ifndef MPMSG_RING
+#define MPMSG_RING      64      /* Messages per ring, power of 2 */
+#endif
+#define MPMSG_BATCH     16      /* Messages per handler batch */
+
+struct mpmsg_q {
+        volatile unsigned int head __attribute__ ((aligned (32)));
+        unsigned int tail_cache;        /* Producer's copy of tail */
+        volatile unsigned int tail __attribute__ ((aligned (32)));
+        unsigned int head_cache;        /* Consumer's copy of head */
+        volatile unsigned int slot[MPMSG_RING] __attribute__ ((aligned (32)));
+};
+
+/*
+ * Called by CPU 0 before any message is sent. The doorbell uses interrupt
+ * irq, which must not be used by a device. Returns the number of CPUs with
+ * rings, at most MPMSG_MAX_CPU. CPUs from MPMSG_MAX_CPU up are ignored and
+ * must not send, receive or arm.
+ */
+int mpmsg_init(volatile int *irqmp_ptr, int irq);
+
+/* Returns the number of messages queued, fewer if the ring is full */
+int mpmsg_send_batch(int to, const unsigned int *msg, int n);
+int mpmsg_send(int to, unsigned int msg);
+
+/* Returns the number of messages from CPU from, at most max */
+int mpmsg_recv(int from, unsigned int *msg, int max);
+
+/* Arms the calling CPU, handler is called from the interrupt handler */
+void mpmsg_irq_enable(void (*handler)(int from, unsigned int msg));
+void mpmsg_irq_disable(void);
+
+/*
+ * Round-trip latency between CPU 0 and CPU 1, polled and with doorbells,
+ * and throughput with batches of 1 and MPMSG_BATCH messages, timed with
+ * the time-stamp counter of the DSU at dsu_addr. Called by all CPUs, CPU 0
+ * starts the others. Returns 0, or -1 if a message was lost or wrong.
+ */
+int mpmsg_bench(volatile int *irqmp_ptr, int irq, unsigned int dsu_addr);
+
+#endif
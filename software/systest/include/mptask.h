@@ -0,0 +1,71 @@
+#ifndef MPTASK_H_
+#define MPTASK_H_
+
+/*
+ * Work-stealing task runtime for SMP systems
+ *
+ * Every CPU has a Chase-Lev deque of tasks. The owner pushes and pops at
+ * the bottom, idle CPUs steal from the top with a compare-and-swap (casa
+ * on LEON, LR/SC on NOEL-V). mpt_sync() runs the caller's own tasks and
+ * steals while it waits, so a task group always completes even when no
+ * other CPU helps.
+ *
+ * CPU 0 calls mpt_init() and the other CPUs enter mpt_worker(), which has
+ * the mpfunc[] signature, until mpt_exit(). A worker that finds no work
+ * sets its bit in the idle mask and powers down; mpt_spawn() wakes an
+ * idle CPU by forcing the IPI interrupt in its IRQMP force register. An
+ * IPI that arrives just before the power-down is lost until the next
+ * spawn, which only delays that CPU. On NOEL-V idle workers poll.
+ *
+ * Tasks and groups are owned by the caller and must stay valid until
+ * mpt_sync() returns. Caches must snoop.
+ */
+
+#define MPT_MAX_CPU     16
+#define MPT_DEQUE       256     /* Tasks per deque, power of 2 */
+
+struct mpt_group {
+        volatile unsigned int pending;
+};
+
+struct mpt_task {
+        void (*fn)(void *arg);
+        void *arg;
+        struct mpt_group *group;
+};
+
+/*
+ * Called by CPU 0 before the workers can find work. The IPI uses
+ * interrupt irq, which must not be used by a device. Returns the number
+ * of CPUs.
+ */
+int mpt_init(volatile int *irqmp_ptr, int irq);
+
+/* Entry of the other CPUs, returns after mpt_exit() */
+void mpt_worker(int cpu);
+
+/* Waits for all workers to return from mpt_worker() */
+void mpt_exit(void);
+
+/* Limits the CPUs that take work to 0 to n-1, the others stay parked */
+void mpt_set_active(int n);
+
+/* Runs fn(arg) as task t of group g, on this or another CPU */
+void mpt_spawn(struct mpt_group *g, struct mpt_task *t, void (*fn)(void *arg), void *arg);
+
+/* Returns when all tasks spawned in g are done */
+void mpt_sync(struct mpt_group *g);
+
+/* Calls fn on subranges of lo to hi-1 of at most grain indexes, in parallel */
+void mpt_parallel_for(int lo, int hi, int grain, void (*fn)(int lo, int hi, void *arg),
+                      void *arg);
+
+/*
+ * Times a memory-bound and a compute-bound parallel-for on 1 to 8 CPUs,
+ * with the time-stamp counter of the DSU at dsu_addr, and prints the
+ * speedup over one CPU. Run on CPU 0 with the workers in mpt_worker().
+ * Returns 0, or -1 if a result was wrong.
+ */
+int mpt_bench(unsigned int dsu_addr);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef PERF_REGION_H_
+#define PERF_REGION_H_
+
+/*
+ * Region markers on the L3STAT/L4STAT counters and the time-stamp counter
+ *
+ * perf_region_begin(id) and perf_region_end(id) append a record with the
+ * %asr22/%asr23 time-stamp counter and PERF_NCNT statistics counters of
+ * the calling CPU to that CPU's ring. Each CPU only writes its own ring,
+ * so no locking is needed. A marker must not be interrupted by an
+ * interrupt handler that uses markers itself. Markers on CPUs from
+ * PERF_MAX_CPU up are not recorded.
+ *
+ * perf_region_init() gives each CPU PERF_NCNT counters of its own.
+ * perf_region_dump() prints the rings for tools/perf_decode.
+ */
+
+#ifndef PERF_NCNT
+#define PERF_NCNT 3
+#endif
+#ifndef PERF_RING
+#define PERF_RING 256                   /* Records per CPU, power of 2 */
+#endif
+#ifndef PERF_MAX_CPU
+#define PERF_MAX_CPU 8
+#endif
+
+#define PERF_END 0x80000000
+
+struct perf_rec {
+        unsigned int tag;               /* Region id, PERF_END on end */
+        unsigned int tsc_hi;
+        unsigned int tsc_lo;
+        unsigned int cnt[PERF_NCNT];
+};
+
+struct perf_ring {
+        volatile unsigned int *val;     /* First counter of this CPU */
+        unsigned int head;              /* Records written */
+        struct perf_rec rec[PERF_RING];
+};
+
+extern struct perf_ring perf_rings[PERF_MAX_CPU];
+
+static inline void perf_tsc(unsigned int *hi, unsigned int *lo)
+{
+        unsigned int h;
+
+        /* Read again when %asr23 wrapped between the reads */
+        do {
+                asm volatile("mov %%asr22, %0" : "=r"(h));
+                asm volatile("mov %%asr23, %0" : "=r"(*lo));
+                asm volatile("mov %%asr22, %0" : "=r"(*hi));
+        } while (h != *hi);
+        *hi &= ~PERF_END;
+}
+
+static inline void perf_region_mark(unsigned int tag)
+{
+        struct perf_ring *r;
+        struct perf_rec *p;
+        unsigned int cpu;
+        int i;
+
+        asm volatile("mov %%asr17, %0" : "=r"(cpu));
+        cpu >>= 28;
+        if (cpu >= PERF_MAX_CPU) {
+                return;
+        }
+        r = &perf_rings[cpu];
+        p = &r->rec[r->head++ & (PERF_RING - 1)];
+        p->tag = tag;
+        for (i = 0; i < PERF_NCNT; i++) {
+                p->cnt[i] = r->val[i];
+        }
+        perf_tsc(&p->tsc_hi, &p->tsc_lo);
+}
+
+#define perf_region_begin(id) perf_region_mark(id)
+#define perf_region_end(id)   perf_region_mark((id) | PERF_END)
+
+/*
+ * Counts events[0..PERF_NCNT-1] on each of CPU 0 to ncpu-1, with the
+ * L3STAT/L4STAT at addr, and clears all rings. Returns 0, or -1 if there
+ * are not ncpu*PERF_NCNT counters.
+ */
+int perf_region_init(unsigned int addr, int ncpu, const unsigned char *events);
+
+/* Enables the time-stamp counter, called on each CPU using markers */
+void perf_region_cpu_init(void);
+
+/*
+ * Time-stamp cycles of a begin/end pair without code in between, measured
+ * on the calling CPU. Its ring must not be full. Returns 0 on CPUs from
+ * PERF_MAX_CPU up.
+ */
+unsigned int perf_region_overhead(void);
+
+/* Prints the rings of CPU 0 to ncpu-1, at most PERF_MAX_CPU */
+void perf_region_dump(int ncpu);
+
+#endif
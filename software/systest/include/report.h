@@ -14,6 +14,11 @@ int report_subtest(int subtest);
 
 void report_mem_test(void);
 
+/*
+ * Benchmark id with its minimum and median cycles per run.
+ */
+void report_bench(int id, const char *name, unsigned int min, unsigned int median);
+
 int fail(int id);
 
 
@@ -26,6 +31,7 @@ struct report_ops {
   int (*fail)(int dev);
   void (*chkp)(int n);
   void (*report_mem_test)(void);
+  void (*report_bench)(int id, const char *name, unsigned int min, unsigned int median);
 };
 
 extern const struct report_ops report_ops_grtestmod;
@@ -0,0 +1,48 @@
+#ifndef TSCBENCH_H_
+#define TSCBENCH_H_
+
+/*
+ * Micro-benchmarks timed with the time-stamp counter
+ *
+ * LEON reads the DSU time tag through %asr22/%asr23, NOEL-V the cycle CSR.
+ * Each kernel is run a number of warm-up times and then timed reps times.
+ * The minimum and median cycles per run, less the cost of reading the
+ * counter, go to the report backend.
+ */
+
+#define TSCB_MAX_REPS 64
+
+/* Kernel needs the FPU */
+#define TSCB_FPU 1
+
+struct tscb_kernel {
+        const char *name;
+        unsigned int (*run)(unsigned int arg);
+        unsigned int arg;
+        int flags;
+};
+
+struct tscb_result {
+        unsigned int min;
+        unsigned int median;
+};
+
+extern const struct tscb_kernel tscb_kernels[];
+extern const int tscb_nkernels;
+
+/*
+ * Enables the counter. With the DSU at dsu_addr, the width of its time tag
+ * is probed and narrower counters are extended to 64 bits in software,
+ * which needs a tsc_read() at least once per wrap of the time tag.
+ * dsu_addr 0 assumes a time tag of 32 bits or more.
+ */
+void tsc_init(unsigned int dsu_addr);
+unsigned long long tsc_read(void);
+
+/* Returns 0, or -1 if reps is out of range */
+int tscb_measure(const struct tscb_kernel *k, int warmup, int reps, struct tscb_result *r);
+
+/* Runs and reports all kernels */
+int tsc_bench(unsigned int dsu_addr);
+
+#endif
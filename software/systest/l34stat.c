@@ -6,37 +6,7 @@
  */
 
 #include "testmod.h"
-
-/* Register offsets */
-#define L4STAT_VAL_REG  0x00
-#define L4STAT_CTRL_REG_REV0 0x80
-#define L4STAT_CTRL_REG_REV1 0x100
-
-/* Counter control register fields */
-#define L4STAT_CTRL_NCPU_REV0     28
-#define L4STAT_CTRL_NCPU_MSK_REV0 0xf
-#define L4STAT_CTRL_NCNT_REV0     23
-#define L4STAT_CTRL_NCNT_MSK_REV0 0x1f
-#define L4STAT_CTRL_NCPU_REV1     29
-#define L4STAT_CTRL_NCPU_MSK_REV1 0x7
-#define L4STAT_CTRL_NCNT_REV1     23
-#define L4STAT_CTRL_NCNT_MSK_REV1 0x3f
-#define L4STAT_CTRL_MC       (1 << 22)
-#define L4STAT_CTRL_IA       (1 << 21)
-#define L4STAT_CTRL_DS       (1 << 20)
-#define L4STAT_CTRL_EE       (1 << 19)
-#define L4STAT_CTRL_R        (1 << 18)
-#define L4STAT_CTRL_EL       (1 << 17)
-#define L4STAT_CTRL_CD       (1 << 16)
-#define L4STAT_CTRL_SU       14
-#define L4STAT_CTRL_SU_MSK   0x3
-#define L4STAT_CTRL_CL       (1 << 13)
-#define L4STAT_CTRL_EN       (1 << 12)
-#define L4STAT_CTRL_ID       4
-#define L4STAT_CTRL_ID_MSK   0xff
-#define L4STAT_CTRL_CPU      0
-#define L4STAT_CTRL_CPU_MSK  0xf
-
+#include "lstat.h"
 
 void l34stat_test(unsigned int addr, unsigned char l3)
 {
@@ -0,0 +1,277 @@
+/*
+ * Profiling sessions on the L3STAT/L4STAT counters, multiplexed on a
+ * GPTIMER tick
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include <bcc/bcc.h>
+#include "isrhelper.h"
+#include "lstat_prof.h"
+
+static const unsigned char cache_ev[] = {
+        LSTAT_time, LSTAT_ainst, LSTAT_icmiss, LSTAT_ichold,
+        LSTAT_dcmiss, LSTAT_dchold, LSTAT_ldst
+};
+static const unsigned char ahb_ev[] = {
+        LSTAT_time, LSTAT_ahbutil, LSTAT_ahbtutil
+};
+static const unsigned char branch_ev[] = {
+        LSTAT_time, LSTAT_ainst, LSTAT_branch, LSTAT_bpmiss
+};
+static const unsigned char fpu_ev[] = {
+        LSTAT_time, LSTAT_ainst, LSTAT_finst
+};
+
+const struct lprof_group lprof_cache = { "cache", sizeof(cache_ev), cache_ev };
+const struct lprof_group lprof_ahb = { "AHB", sizeof(ahb_ev), ahb_ev };
+const struct lprof_group lprof_branch = { "branch", sizeof(branch_ev), branch_ev };
+const struct lprof_group lprof_fpu = { "FPU", sizeof(fpu_ev), fpu_ev };
+
+static const struct {
+        unsigned char ev;
+        const char *name;
+} lprof_names[] = {
+        { LSTAT_icmiss, "icmiss" }, { LSTAT_itmiss, "itmiss" },
+        { LSTAT_ichold, "ichold" }, { LSTAT_ithold, "ithold" },
+        { LSTAT_dcmiss, "dcmiss" }, { LSTAT_dtmiss, "dtmiss" },
+        { LSTAT_dchold, "dchold" }, { LSTAT_dthold, "dthold" },
+        { LSTAT_wbhold, "wbhold" }, { LSTAT_ainst, "ainst" },
+        { LSTAT_iinst, "iinst" }, { LSTAT_finst, "finst" },
+        { LSTAT_bpmiss, "bpmiss" }, { LSTAT_time, "time" },
+        { LSTAT_ahbutil, "ahbutil" }, { LSTAT_ahbtutil, "ahbtutil" },
+        { LSTAT_branch, "branch" }, { LSTAT_ldst, "ldst" },
+        { LSTAT_load, "load" }, { LSTAT_store, "store" },
+};
+
+/* Session rotated by the timer interrupt */
+static struct lprof *lprof_active;
+
+static const char *lprof_name(int ev)
+{
+        unsigned int i;
+
+        for (i = 0; i < sizeof(lprof_names) / sizeof(lprof_names[0]); i++) {
+                if (lprof_names[i].ev == ev) {
+                        return lprof_names[i].name;
+                }
+        }
+        return "event";
+}
+
+/* Slots of the set starting at cur */
+static int lprof_setsize(struct lprof *p)
+{
+        int n = p->nslot - p->cur;
+
+        return n < p->ncnt ? n : p->ncnt;
+}
+
+static void lprof_load(struct lprof *p)
+{
+        struct lprof_slot *s;
+        int i;
+
+        for (i = 0; i < lprof_setsize(p); i++) {
+                s = &p->slot[p->cur + i];
+                p->val[i] = 0;
+                p->ctrl[i] = L4STAT_CTRL_EN | (s->ev << L4STAT_CTRL_ID) |
+                             (s->cpu << L4STAT_CTRL_CPU);
+        }
+}
+
+/* Stops the counting set and credits it elapsed timer units */
+static void lprof_collect(struct lprof *p, unsigned int elapsed)
+{
+        struct lprof_slot *s;
+        int i, n = lprof_setsize(p);
+
+        /* Stop the whole set first so that its counts cover the same time */
+        for (i = 0; i < n; i++) {
+                p->ctrl[i] = 0;
+        }
+        for (i = 0; i < n; i++) {
+                s = &p->slot[p->cur + i];
+                s->count += p->val[i];
+                s->active += elapsed;
+        }
+        p->total += elapsed;
+}
+
+static void lprof_irqhandler(int irq)
+{
+        struct lprof *p = lprof_active;
+
+        (void)irq;
+        if (p == NULL) {
+                return;
+        }
+        p->gpt->timer[p->tn].control = GPTIMER_IP | GPTIMER_IE | GPTIMER_RS | GPTIMER_EN;
+        lprof_collect(p, p->tick);
+        p->cur += p->ncnt;
+        if (p->cur >= p->nslot) {
+                p->cur = 0;
+        }
+        lprof_load(p);
+        p->ticks++;
+}
+
+int lprof_init(struct lprof *p, unsigned int addr, struct gptimer *gpt, int tn, int irq)
+{
+        p->val = (unsigned int *)(addr + L4STAT_VAL_REG);
+        p->ctrl = (unsigned int *)(addr + L4STAT_CTRL_REG_REV1);
+        p->gpt = gpt;
+        p->tn = tn;
+        p->irq = irq;
+        p->nslot = 0;
+        lstat_init(addr);
+        p->ncnt = ((p->ctrl[0] >> L4STAT_CTRL_NCNT_REV1) & L4STAT_CTRL_NCNT_MSK_REV1) + 1;
+        return 0;
+}
+
+int lprof_add(struct lprof *p, int cpu, int event)
+{
+        int i;
+
+        if (LPROF_GLOBAL(event)) {
+                cpu = 0;
+        }
+        for (i = 0; i < p->nslot; i++) {
+                if (p->slot[i].cpu == cpu && p->slot[i].ev == event) {
+                        return 0;
+                }
+        }
+        if (p->nslot == LPROF_MAX_SLOT) {
+                return -1;
+        }
+        p->slot[p->nslot].cpu = cpu;
+        p->slot[p->nslot].ev = event;
+        p->nslot++;
+        return 0;
+}
+
+int lprof_add_group(struct lprof *p, unsigned int cpumask, const struct lprof_group *g)
+{
+        int cpu, i;
+
+        for (cpu = 0; cpu <= L4STAT_CTRL_CPU_MSK; cpu++) {
+                if (!(cpumask & (1 << cpu))) {
+                        continue;
+                }
+                for (i = 0; i < g->nev; i++) {
+                        if (lprof_add(p, cpu, g->ev[i]) != 0) {
+                                return -1;
+                        }
+                }
+        }
+        return 0;
+}
+
+void lprof_start(struct lprof *p, unsigned int tick)
+{
+        struct timerreg *t = &p->gpt->timer[p->tn];
+        int i;
+
+        for (i = 0; i < p->nslot; i++) {
+                p->slot[i].count = 0;
+                p->slot[i].active = 0;
+        }
+        p->tick = tick;
+        p->total = 0;
+        p->ticks = 0;
+        p->cur = 0;
+        lprof_active = p;
+        catch_interrupt(lprof_irqhandler, p->irq);
+        bcc_int_unmask(p->irq);
+        t->control = 0;
+        t->reload = tick - 1;
+        t->counter = tick - 1;
+        lprof_load(p);
+        t->control = GPTIMER_IP | GPTIMER_IE | GPTIMER_LD | GPTIMER_RS | GPTIMER_EN;
+}
+
+void lprof_stop(struct lprof *p)
+{
+        struct timerreg *t = &p->gpt->timer[p->tn];
+
+        bcc_int_mask(p->irq);
+        t->control = GPTIMER_IP;
+        /* Time since the last reload */
+        lprof_collect(p, p->tick - 1 - t->counter);
+        lprof_active = NULL;
+}
+
+double lprof_value(struct lprof *p, int cpu, int event)
+{
+        int i;
+
+        if (LPROF_GLOBAL(event)) {
+                cpu = 0;
+        }
+        for (i = 0; i < p->nslot; i++) {
+                if (p->slot[i].cpu == cpu && p->slot[i].ev == event) {
+                        if (p->slot[i].active == 0) {
+                                return -1;
+                        }
+                        return (double)p->slot[i].count * p->total / p->slot[i].active;
+                }
+        }
+        return -1;
+}
+
+/* Prints scale*a/b when both were counted */
+static void lprof_ratio(const char *name, double a, double b, double scale)
+{
+        if (a < 0 || b <= 0) {
+                return;
+        }
+        printf("  %-24s %10.3f\n", name, a * scale / b);
+}
+
+void lprof_report(struct lprof *p)
+{
+        double v, time;
+        int cpu, i;
+
+        printf("L3STAT/L4STAT profile: %u ticks, %d slots on %d counters\n",
+               p->ticks, p->nslot, p->ncnt);
+        for (cpu = 0; cpu <= L4STAT_CTRL_CPU_MSK; cpu++) {
+                for (i = 0; i < p->nslot; i++) {
+                        if (p->slot[i].cpu == cpu) {
+                                break;
+                        }
+                }
+                if (i == p->nslot) {
+                        continue;
+                }
+                printf("CPU %d\n", cpu);
+                for (i = 0; i < p->nslot; i++) {
+                        if (p->slot[i].cpu != cpu) {
+                                continue;
+                        }
+                        v = lprof_value(p, cpu, p->slot[i].ev);
+                        printf("  %-24s %14.0f  (%llu%% counted)\n", lprof_name(p->slot[i].ev),
+                               v < 0 ? 0 : v,
+                               p->total ? p->slot[i].active * 100 / p->total : 0ULL);
+                }
+                time = lprof_value(p, cpu, LSTAT_time);
+                lprof_ratio("IPC", lprof_value(p, cpu, LSTAT_ainst), time, 1);
+                lprof_ratio("I-cache miss/instr %", lprof_value(p, cpu, LSTAT_icmiss),
+                            lprof_value(p, cpu, LSTAT_ainst), 100);
+                lprof_ratio("D-cache miss rate %", lprof_value(p, cpu, LSTAT_dcmiss),
+                            lprof_value(p, cpu, LSTAT_ldst), 100);
+                lprof_ratio("I-cache hold %", lprof_value(p, cpu, LSTAT_ichold), time, 100);
+                lprof_ratio("D-cache hold %", lprof_value(p, cpu, LSTAT_dchold), time, 100);
+                lprof_ratio("branch mispredict %", lprof_value(p, cpu, LSTAT_bpmiss),
+                            lprof_value(p, cpu, LSTAT_branch), 100);
+                lprof_ratio("FPU instr %", lprof_value(p, cpu, LSTAT_finst),
+                            lprof_value(p, cpu, LSTAT_ainst), 100);
+                lprof_ratio("AHB util %", lprof_value(p, cpu, LSTAT_ahbutil), time, 100);
+                if (cpu == 0) {
+                        lprof_ratio("AHB total util %", lprof_value(p, 0, LSTAT_ahbtutil),
+                                    time, 100);
+                }
+        }
+}
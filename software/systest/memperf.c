@@ -0,0 +1,230 @@
+/*
+ * Memory performance suite
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include "tscbench.h"
+#include "memperf.h"
+
+#define MEMPERF_REPS    4       /* STREAM runs, the first is not counted */
+#define MEMPERF_LOADS   16384   /* Timed loads per latency point */
+
+#if !defined(__riscv)
+extern int rsysreg(int addr);
+#endif
+
+static unsigned int memperf_mhz;
+static volatile unsigned int memperf_sink;
+
+static const char *memperf_name[4] = { "copy", "scale", "add", "triad" };
+
+void memperf_probe(volatile int *l2reg, struct memperf_cfg *c)
+{
+#if !defined(__riscv)
+        unsigned int dc = rsysreg(12);
+
+        c->l1d = (1 << (((dc >> 20) & 15) + 10)) * (((dc >> 24) & 3) + 1);
+        c->line = 1 << (((dc >> 16) & 7) + 2);
+#else
+        c->l1d = MEMPERF_L1D;
+        c->line = MEMPERF_LINE;
+#endif
+        c->l2 = 0;
+        c->l2en = 0;
+        if (l2reg) {
+                /* Ways, and way size in KiB */
+                c->l2 = ((l2reg[1] & 3) + 1) * ((l2reg[1] >> 2) & 0x7ff) * 1024;
+                c->l2en = (l2reg[0] >> 31) & 1;
+        }
+}
+
+static unsigned int memperf_mbs(unsigned long long bytes, unsigned int cyc)
+{
+        return cyc ? bytes * memperf_mhz / cyc : 0;
+}
+
+static unsigned int memperf_kernel(int k, unsigned int *a, unsigned int *b, unsigned int *c,
+                                   int n)
+{
+        unsigned long long t0;
+        int i;
+
+        t0 = tsc_read();
+        switch (k) {
+        case 0:
+                for (i = 0; i < n; i++) {
+                        c[i] = a[i];
+                }
+                break;
+        case 1:
+                for (i = 0; i < n; i++) {
+                        b[i] = 3 * c[i];
+                }
+                break;
+        case 2:
+                for (i = 0; i < n; i++) {
+                        c[i] = a[i] + b[i];
+                }
+                break;
+        default:
+                for (i = 0; i < n; i++) {
+                        a[i] = b[i] + 3 * c[i];
+                }
+                break;
+        }
+        return tsc_read() - t0;
+}
+
+/* STREAM on three arrays of n words, the best of the timed runs */
+static int memperf_stream(unsigned int *buf, int n)
+{
+        static const int words[4] = { 2, 2, 3, 3 };
+        unsigned int *a = buf, *b = buf + n, *c = buf + 2 * n;
+        unsigned int best[4], cyc, ea = 1, eb = 2, ec = 0;
+        int i, k, r;
+
+        for (i = 0; i < n; i++) {
+                a[i] = 1;
+                b[i] = 2;
+                c[i] = 0;
+        }
+        for (k = 0; k < 4; k++) {
+                best[k] = ~0;
+        }
+        for (r = 0; r < MEMPERF_REPS; r++) {
+                for (k = 0; k < 4; k++) {
+                        cyc = memperf_kernel(k, a, b, c, n);
+                        if (r > 0 && cyc < best[k]) {
+                                best[k] = cyc;
+                        }
+                }
+                ec = ea;
+                eb = 3 * ec;
+                ec = ea + eb;
+                ea = eb + 3 * ec;
+        }
+        for (k = 0; k < 4; k++) {
+                printf("memperf stream %-5s %8u KiB %8u MB/s\n", memperf_name[k], n * 4 / 1024,
+                       memperf_mbs((unsigned long long)words[k] * 4 * n, best[k]));
+        }
+        for (i = 0; i < n; i++) {
+                if (a[i] != ea || b[i] != eb || c[i] != ec) {
+                        return -1;
+                }
+        }
+        return 0;
+}
+
+/*
+ * Links the lines of ws bytes into one random cycle (Sattolo's algorithm),
+ * walks it once to check and warm it, and gives the cycles per load x100
+ */
+static int memperf_chase(unsigned int *buf, unsigned int ws, unsigned int line,
+                         unsigned int *lat)
+{
+        unsigned int m = ws / line, step = line / 4, i, j, t, x, seed = 12345;
+        unsigned long long t0;
+
+        for (i = 0; i < m; i++) {
+                buf[i * step] = i;
+        }
+        for (i = m - 1; i > 0; i--) {
+                seed = seed * 1103515245 + 12345;
+                j = (seed >> 8) % i;
+                t = buf[i * step];
+                buf[i * step] = buf[j * step];
+                buf[j * step] = t;
+        }
+        /* Elements hold the word index of the next element */
+        for (i = 0; i < m; i++) {
+                buf[i * step] *= step;
+        }
+        x = 0;
+        for (i = 1; (x = buf[x]) != 0; i++) {
+                if (i > m) {
+                        return -1;
+                }
+        }
+        if (i != m) {
+                return -1;
+        }
+        t0 = tsc_read();
+        for (i = 0; i < MEMPERF_LOADS; i += 8) {
+                x = buf[x];
+                x = buf[x];
+                x = buf[x];
+                x = buf[x];
+                x = buf[x];
+                x = buf[x];
+                x = buf[x];
+                x = buf[x];
+        }
+        t = tsc_read() - t0;
+        memperf_sink = x;
+        *lat = (unsigned long long)t * 100 / MEMPERF_LOADS;
+        return 0;
+}
+
+/* Loads every stride bytes of region bytes, the second pass is timed */
+static unsigned int memperf_stride(unsigned int *buf, unsigned int region, unsigned int stride,
+                                   unsigned int *cyc)
+{
+        unsigned int n = region / stride, step = stride / 4, sum = 0, i, r;
+        unsigned long long t0 = 0;
+
+        for (r = 0; r < 2; r++) {
+                t0 = tsc_read();
+                for (i = 0; i < n; i++) {
+                        sum += buf[i * step];
+                }
+        }
+        *cyc = tsc_read() - t0;
+        memperf_sink = sum;
+        return n;
+}
+
+int memperf_run(volatile int *l2reg, unsigned int dsu_addr, unsigned int mhz,
+                unsigned int *buf, unsigned int size)
+{
+        struct memperf_cfg c;
+        unsigned int big, n, ws, lat, s, cnt, cyc;
+        int err = 0;
+
+        memperf_probe(l2reg, &c);
+        tsc_init(dsu_addr);
+        memperf_mhz = mhz;
+        printf("memperf l1d %u KiB line %u l2 %u KiB %s\n", c.l1d / 1024, c.line, c.l2 / 1024,
+               c.l2 == 0 ? "none" : c.l2en ? "on" : "off");
+
+        /* Four times the largest cache, or what fits */
+        big = 4 * (c.l2 > c.l1d ? c.l2 : c.l1d);
+        n = big / 4;
+        if (3 * big > size) {
+                n = size / 12;
+        }
+        if (n * 4 < c.l1d) {
+                return -1;
+        }
+        err |= memperf_stream(buf, n);
+
+        for (ws = c.l1d / 4; ws <= big && ws <= size; ws *= 2) {
+                if (memperf_chase(buf, ws, c.line, &lat) < 0) {
+                        err = -1;
+                        break;
+                }
+                printf("memperf latency %8u KiB %4u.%02u cycles\n", ws / 1024, lat / 100,
+                       lat % 100);
+        }
+
+        ws = big < size ? big : size;
+        for (s = 4; s <= 8 * c.line; s *= 2) {
+                cnt = memperf_stride(buf, ws, s, &cyc);
+                lat = (unsigned long long)cyc * 100 / cnt;
+                printf("memperf stride %4u B %4u.%02u cycles %8u MB/s\n", s, lat / 100,
+                       lat % 100, memperf_mbs((unsigned long long)cnt * 4, cyc));
+        }
+        return err ? -1 : 0;
+}
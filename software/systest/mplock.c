@@ -0,0 +1,206 @@
+/*
+ * Scalable MP locks and barrier
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include "tscbench.h"
+#include "mplock.h"
+
+#define MPB_ACQ         1000    /* Acquisitions per CPU and run */
+
+static unsigned int mp_casa(volatile unsigned int *p, unsigned int cmp, unsigned int swp)
+{
+        asm volatile ("casa [%1] 0xA, %2, %0\n" : "+r"(swp) : "r"(p), "r"(cmp) : "memory");
+        return swp;
+}
+
+static unsigned int mp_fetch_add(volatile unsigned int *p, unsigned int v)
+{
+        unsigned int old;
+
+        do {
+                old = *p;
+        } while (mp_casa(p, old, old + v) != old);
+        return old;
+}
+
+void mp_tas_lock(struct mp_tas *l)
+{
+        unsigned int old;
+
+        for (;;) {
+                asm volatile ("ldstub [%1], %0\n" : "=r"(old) : "r"(&l->lock) : "memory");
+                if (old == 0) {
+                        return;
+                }
+                while (l->lock != 0) {
+                }
+        }
+}
+
+void mp_tas_unlock(struct mp_tas *l)
+{
+        asm volatile ("" ::: "memory");
+        l->lock = 0;
+}
+
+void mp_ticket_lock(struct mp_ticket *l)
+{
+        unsigned int t = mp_fetch_add(&l->next, 1);
+
+        while (l->owner != t) {
+        }
+        asm volatile ("" ::: "memory");
+}
+
+void mp_ticket_unlock(struct mp_ticket *l)
+{
+        asm volatile ("" ::: "memory");
+        /* Only the owner writes the owner word */
+        l->owner = l->owner + 1;
+}
+
+void mp_mcs_lock(struct mp_mcs *l, struct mcs_node *n)
+{
+        struct mcs_node *pred = n;
+
+        n->next = NULL;
+        n->locked = 1;
+        asm volatile ("swap [%1], %0\n" : "+r"(pred) : "r"(&l->tail) : "memory");
+        if (pred != NULL) {
+                pred->next = n;
+                while (n->locked) {
+                }
+        }
+        asm volatile ("" ::: "memory");
+}
+
+void mp_mcs_unlock(struct mp_mcs *l, struct mcs_node *n)
+{
+        asm volatile ("" ::: "memory");
+        if (n->next == NULL) {
+                /* No waiter, unless one swapped the tail but has not linked yet */
+                if (mp_casa((volatile unsigned int *)&l->tail, (unsigned int)n, 0) ==
+                    (unsigned int)n) {
+                        return;
+                }
+                while (n->next == NULL) {
+                }
+        }
+        n->next->locked = 0;
+}
+
+void mp_barrier_init(struct mp_barrier *b, unsigned int n)
+{
+        b->n = n;
+        b->count = n;
+        b->sense = 0;
+}
+
+void mp_barrier_wait(struct mp_barrier *b, unsigned int *sense)
+{
+        unsigned int s = !*sense;
+
+        *sense = s;
+        if (mp_fetch_add(&b->count, -1) == 1) {
+                /* Last to arrive, the count is reset before the release */
+                b->count = b->n;
+                b->sense = s;
+        } else {
+                while (b->sense != s) {
+                }
+        }
+        asm volatile ("" ::: "memory");
+}
+
+static struct mp_barrier mpb_bar;
+static struct mp_tas mpb_tas;
+static struct mp_ticket mpb_ticket;
+static struct mp_mcs mpb_mcs;
+static struct mcs_node mpb_node[MP_MAX_CPU];
+static volatile unsigned int mpb_go;
+static volatile unsigned int mpb_count __attribute__ ((aligned (MP_LINE)));
+
+static const char *mpb_name[3] = { "tas", "ticket", "mcs" };
+
+/* The critical section increments the shared count */
+static void mpb_run(int kind, int cpu)
+{
+        int i;
+
+        for (i = 0; i < MPB_ACQ; i++) {
+                switch (kind) {
+                case 0:
+                        mp_tas_lock(&mpb_tas);
+                        mpb_count++;
+                        mp_tas_unlock(&mpb_tas);
+                        break;
+                case 1:
+                        mp_ticket_lock(&mpb_ticket);
+                        mpb_count++;
+                        mp_ticket_unlock(&mpb_ticket);
+                        break;
+                default:
+                        mp_mcs_lock(&mpb_mcs, &mpb_node[cpu]);
+                        mpb_count++;
+                        mp_mcs_unlock(&mpb_mcs, &mpb_node[cpu]);
+                        break;
+                }
+        }
+}
+
+int mp_lock_bench(volatile int *irqmp_ptr, unsigned int dsu_addr, unsigned int mhz)
+{
+        unsigned long long t0 = 0, t1;
+        unsigned int sense = 0, cpu, acq, cyc;
+        int ncpu, kind, n, err = 0;
+
+        ncpu = (((*(irqmp_ptr + 0x10/4)) >> 28) & 0x0f) + 1;
+        asm volatile("mov %%asr17, %0" : "=r"(cpu));
+        cpu >>= 28;
+
+        if (cpu == 0) {
+                tsc_init(dsu_addr);
+                mp_barrier_init(&mpb_bar, ncpu);
+                mpb_go = 1;
+                *(irqmp_ptr + 0x10/4) = ((1 << ncpu) - 1) & ~1;
+        } else {
+                while (!mpb_go) {
+                }
+        }
+
+        for (kind = 0; kind < 3; kind++) {
+                for (n = 1; n <= ncpu; n++) {
+                        if (cpu == 0) {
+                                mpb_count = 0;
+                        }
+                        mp_barrier_wait(&mpb_bar, &sense);
+                        if (cpu == 0) {
+                                t0 = tsc_read();
+                        }
+                        if ((int)cpu < n) {
+                                mpb_run(kind, cpu);
+                        }
+                        mp_barrier_wait(&mpb_bar, &sense);
+                        if (cpu != 0) {
+                                continue;
+                        }
+                        t1 = tsc_read();
+                        acq = n * MPB_ACQ;
+                        if (mpb_count != acq) {
+                                err = -1;
+                        }
+                        cyc = t1 - t0;
+                        printf("mplock %-6s cpus %2d acq %6u cycles/acq %6u acq/s %10u\n",
+                               mpb_name[kind], n, acq, cyc / acq,
+                               (unsigned int)((unsigned long long)acq * mhz * 1000000 / cyc));
+                }
+        }
+        if (cpu == 0) {
+                mpb_go = 0;
+        }
+        return err;
+}
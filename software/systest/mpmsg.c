@@ -0,0 +1,347 @@
+/*
+ * Inter-processor message queues with IRQMP doorbells
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include <bcc/bcc.h>
+#include "isrhelper.h"
+#include "tscbench.h"
+#include "mpmsg.h"
+
+#define MPMSG_IRQFORCE  0x80    /* IRQMP force register of CPU 0 */
+
+#define MPMSG_RTT       256     /* Round trips per measurement */
+#define MPMSG_STREAM    4096    /* Messages per throughput measurement */
+
+/* Bench commands from CPU 0 to CPU 1, above the message numbers */
+#define MPMSG_CMD_IRQ   0xfffffff0      /* Echo from the interrupt handler */
+#define MPMSG_CMD_SINK  0xfffffff1      /* Count messages instead */
+#define MPMSG_CMD_STOP  0xfffffff2
+
+struct mpmsg_cpu {
+        volatile unsigned int armed;
+        void (*handler)(int from, unsigned int msg);
+} __attribute__ ((aligned (32)));
+
+static struct mpmsg_q mpmsg_q[MPMSG_MAX_CPU][MPMSG_MAX_CPU];
+static struct mpmsg_cpu mpmsg_cpus[MPMSG_MAX_CPU];
+static volatile int *mpmsg_irqmp;
+static int mpmsg_irq;
+static int mpmsg_ncpu;
+
+#define mpmsg_barrier() asm volatile ("" ::: "memory")
+
+/* Orders earlier stores before later loads, an atomic drains the store buffer */
+static void mpmsg_fence(void)
+{
+        unsigned int v = 0, w;
+
+        asm volatile ("swap [%1], %0\n" : "+r"(v) : "r"(&w) : "memory");
+}
+
+static int mpmsg_cpu(void)
+{
+        unsigned int id;
+
+        asm volatile ("mov %%asr17, %0" : "=r"(id));
+        return id >> 28;
+}
+
+int mpmsg_send_batch(int to, const unsigned int *msg, int n)
+{
+        struct mpmsg_q *q = &mpmsg_q[mpmsg_cpu()][to];
+        unsigned int h = q->head;
+        int i;
+
+        if ((int)(MPMSG_RING - (h - q->tail_cache)) < n) {
+                q->tail_cache = q->tail;
+                if ((int)(MPMSG_RING - (h - q->tail_cache)) < n) {
+                        n = MPMSG_RING - (h - q->tail_cache);
+                }
+        }
+        if (n <= 0) {
+                return 0;
+        }
+        for (i = 0; i < n; i++) {
+                q->slot[(h + i) & (MPMSG_RING - 1)] = msg[i];
+        }
+        /* TSO keeps the slot writes before the head write */
+        mpmsg_barrier();
+        q->head = h + n;
+        mpmsg_fence();
+        if (mpmsg_cpus[to].armed) {
+                mpmsg_irqmp[MPMSG_IRQFORCE / 4 + to] = 1 << mpmsg_irq;
+        }
+        return n;
+}
+
+int mpmsg_send(int to, unsigned int msg)
+{
+        return mpmsg_send_batch(to, &msg, 1);
+}
+
+int mpmsg_recv(int from, unsigned int *msg, int max)
+{
+        struct mpmsg_q *q = &mpmsg_q[from][mpmsg_cpu()];
+        unsigned int t = q->tail;
+        int i, n;
+
+        if (q->head_cache == t) {
+                q->head_cache = q->head;
+        }
+        n = q->head_cache - t;
+        if (n > max) {
+                n = max;
+        }
+        for (i = 0; i < n; i++) {
+                msg[i] = q->slot[(t + i) & (MPMSG_RING - 1)];
+        }
+        mpmsg_barrier();
+        q->tail = t + n;
+        return n;
+}
+
+static int mpmsg_pending(int cpu)
+{
+        int from;
+
+        for (from = 0; from < mpmsg_ncpu; from++) {
+                if (mpmsg_q[from][cpu].head != mpmsg_q[from][cpu].tail) {
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+static void mpmsg_irqhandler(int irq)
+{
+        struct mpmsg_cpu *c;
+        unsigned int buf[MPMSG_BATCH];
+        int cpu = mpmsg_cpu(), from, n, i;
+
+        (void)irq;
+        c = &mpmsg_cpus[cpu];
+        do {
+                c->armed = 0;
+                for (from = 0; from < mpmsg_ncpu; from++) {
+                        while ((n = mpmsg_recv(from, buf, MPMSG_BATCH)) > 0) {
+                                for (i = 0; i < n; i++) {
+                                        c->handler(from, buf[i]);
+                                }
+                        }
+                }
+                /* A send that missed the armed flag is seen by the check */
+                c->armed = 1;
+                mpmsg_fence();
+        } while (mpmsg_pending(cpu));
+}
+
+int mpmsg_init(volatile int *irqmp_ptr, int irq)
+{
+        int i, j;
+
+        mpmsg_ncpu = (((*(irqmp_ptr + 0x10/4)) >> 28) & 0x0f) + 1;
+        /* Further CPUs get no rings */
+        if (mpmsg_ncpu > MPMSG_MAX_CPU) {
+                mpmsg_ncpu = MPMSG_MAX_CPU;
+        }
+        mpmsg_irqmp = irqmp_ptr;
+        mpmsg_irq = irq;
+        for (i = 0; i < mpmsg_ncpu; i++) {
+                for (j = 0; j < mpmsg_ncpu; j++) {
+                        mpmsg_q[i][j].head = 0;
+                        mpmsg_q[i][j].tail = 0;
+                        mpmsg_q[i][j].tail_cache = 0;
+                        mpmsg_q[i][j].head_cache = 0;
+                }
+                mpmsg_cpus[i].armed = 0;
+        }
+        catch_interrupt(mpmsg_irqhandler, irq);
+        return mpmsg_ncpu;
+}
+
+void mpmsg_irq_enable(void (*handler)(int from, unsigned int msg))
+{
+        struct mpmsg_cpu *c = &mpmsg_cpus[mpmsg_cpu()];
+
+        c->handler = handler;
+        bcc_int_unmask(mpmsg_irq);
+        c->armed = 1;
+        mpmsg_fence();
+        /* Messages sent before arming get no doorbell */
+        if (mpmsg_pending(mpmsg_cpu())) {
+                mpmsg_irqmp[MPMSG_IRQFORCE / 4 + mpmsg_cpu()] = 1 << mpmsg_irq;
+        }
+}
+
+void mpmsg_irq_disable(void)
+{
+        mpmsg_cpus[mpmsg_cpu()].armed = 0;
+        bcc_int_mask(mpmsg_irq);
+}
+
+static volatile unsigned int mpmsg_go;
+static volatile unsigned int mpmsg_stop;
+static volatile unsigned int mpmsg_done;
+static volatile unsigned int mpmsg_sunk;
+static volatile unsigned int mpmsg_sum;
+
+/*
+ * CPU 1 side of the bench. The handler is read again for each message, so
+ * the messages after MPMSG_CMD_SINK go to mpmsg_sink().
+ */
+static void mpmsg_sink(int from, unsigned int msg)
+{
+        (void)from;
+        if (msg == MPMSG_CMD_STOP) {
+                mpmsg_stop = 1;
+                return;
+        }
+        mpmsg_sum += msg;
+        mpmsg_sunk++;
+}
+
+static void mpmsg_echo(int from, unsigned int msg)
+{
+        if (msg == MPMSG_CMD_SINK) {
+                mpmsg_cpus[1].handler = mpmsg_sink;
+        } else if (msg == MPMSG_CMD_STOP) {
+                mpmsg_stop = 1;
+        } else {
+                while (mpmsg_send(from, msg) == 0) {
+                }
+        }
+}
+
+static void mpmsg_responder(void)
+{
+        unsigned int m;
+
+        /* Polled echo until switched to the doorbell */
+        for (;;) {
+                if (mpmsg_recv(0, &m, 1) == 0) {
+                        continue;
+                }
+                while (mpmsg_send(0, m) == 0) {
+                }
+                if (m == MPMSG_CMD_IRQ) {
+                        break;
+                }
+        }
+        mpmsg_irq_enable(mpmsg_echo);
+        while (!mpmsg_stop) {
+                asm volatile ("wr %g0, %g0, %asr19");   /* power-down */
+        }
+        mpmsg_irq_disable();
+        mpmsg_done = 1;
+}
+
+static void mpmsg_send_all(int to, const unsigned int *msg, int n)
+{
+        int k;
+
+        while (n > 0) {
+                k = mpmsg_send_batch(to, msg, n);
+                msg += k;
+                n -= k;
+        }
+}
+
+/* Returns the minimum round trip, or 0 if an echo was wrong */
+static unsigned int mpmsg_rtt(unsigned int *avg)
+{
+        unsigned long long t0, t1, total = 0;
+        unsigned int i, m, best = ~0;
+
+        for (i = 0; i < MPMSG_RTT; i++) {
+                t0 = tsc_read();
+                mpmsg_send_all(1, &i, 1);
+                while (mpmsg_recv(1, &m, 1) == 0) {
+                }
+                t1 = tsc_read();
+                if (m != i) {
+                        return 0;
+                }
+                total += t1 - t0;
+                if (t1 - t0 < best) {
+                        best = t1 - t0;
+                }
+        }
+        *avg = total / MPMSG_RTT;
+        return best;
+}
+
+int mpmsg_bench(volatile int *irqmp_ptr, int irq, unsigned int dsu_addr)
+{
+        static unsigned int buf[MPMSG_BATCH];
+        unsigned long long t0;
+        unsigned int cmd, m, min, avg, cyc, sum;
+        int cpu, batch, i, k, err = 0;
+
+        cpu = mpmsg_cpu();
+        if (cpu == 1) {
+                while (!mpmsg_go) {
+                }
+                mpmsg_responder();
+                return 0;
+        }
+        if (cpu != 0) {
+                return 0;
+        }
+        if (mpmsg_init(irqmp_ptr, irq) < 2) {
+                return -1;
+        }
+        tsc_init(dsu_addr);
+        mpmsg_stop = 0;
+        mpmsg_done = 0;
+        mpmsg_sunk = 0;
+        mpmsg_go = 1;
+        *(irqmp_ptr + 0x10/4) = 1 << 1;
+
+        min = mpmsg_rtt(&avg);
+        printf("mpmsg rtt poll   min %6u avg %6u cycles\n", min, avg);
+        err |= min == 0;
+
+        cmd = MPMSG_CMD_IRQ;
+        mpmsg_send_all(1, &cmd, 1);
+        while (mpmsg_recv(1, &m, 1) == 0) {
+        }
+        min = mpmsg_rtt(&avg);
+        printf("mpmsg rtt irq    min %6u avg %6u cycles\n", min, avg);
+        err |= min == 0;
+
+        /* Switch the handler to counting, and stream */
+        cmd = MPMSG_CMD_SINK;
+        mpmsg_send_all(1, &cmd, 1);
+        for (batch = 1; batch <= MPMSG_BATCH; batch *= MPMSG_BATCH) {
+                mpmsg_sunk = 0;
+                mpmsg_sum = 0;
+                sum = 0;
+                t0 = tsc_read();
+                for (i = 0; i < MPMSG_STREAM; i += batch) {
+                        for (k = 0; k < batch; k++) {
+                                buf[k] = i + k;
+                                sum += i + k;
+                        }
+                        mpmsg_send_all(1, buf, batch);
+                }
+                while (mpmsg_sunk != MPMSG_STREAM) {
+                }
+                cyc = (tsc_read() - t0) * 100 / MPMSG_STREAM;
+                printf("mpmsg stream batch %2d %4u.%02u cycles/msg\n", batch, cyc / 100,
+                       cyc % 100);
+                err |= mpmsg_sum != sum;
+        }
+
+        cmd = MPMSG_CMD_STOP;
+        mpmsg_send_all(1, &cmd, 1);
+        /* The doorbell may come just before CPU 1 powers down */
+        while (!mpmsg_done) {
+                irqmp_ptr[MPMSG_IRQFORCE / 4 + 1] = 1 << irq;
+        }
+        mpmsg_go = 0;
+        return err ? -1 : 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * Work-stealing task runtime for SMP systems
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#if !defined(__riscv)
+#include <bcc/bcc.h>
+#include "isrhelper.h"
+#endif
+#include "tscbench.h"
+#include "mptask.h"
+
+#define MPT_SPINS       64      /* Failed steal rounds before parking */
+#define MPT_IRQFORCE    0x80    /* IRQMP force register of CPU 0 */
+
+#ifndef MPT_BENCH_N
+#define MPT_BENCH_N     (16 * 1024)
+#endif
+#define MPT_BENCH_CPUS  8
+
+/* Orders stores, and loads, among themselves; implied by TSO on LEON */
+#if defined(__riscv)
+#define MPT_WMB() asm volatile ("fence w, w" ::: "memory")
+#define MPT_RMB() asm volatile ("fence r, r" ::: "memory")
+#else
+#define MPT_WMB() asm volatile ("" ::: "memory")
+#define MPT_RMB() asm volatile ("" ::: "memory")
+#endif
+
+struct mpt_deque {
+        volatile unsigned int top __attribute__ ((aligned (32)));
+        volatile unsigned int bottom __attribute__ ((aligned (32)));
+        struct mpt_task *volatile buf[MPT_DEQUE];
+};
+
+static struct mpt_deque mpt_dq[MPT_MAX_CPU];
+static volatile int *mpt_irqmp;
+static int mpt_irq;
+static int mpt_ncpu;
+static volatile int mpt_up;
+static volatile int mpt_active;
+static volatile unsigned int mpt_idle;
+static volatile unsigned int mpt_nworkers;
+
+static unsigned int mpt_cas(volatile unsigned int *p, unsigned int cmp, unsigned int swp)
+{
+#if defined(__riscv)
+        unsigned int old, fail;
+
+        asm volatile ("1: lr.w.aqrl %0, (%2)\n"
+                      "   bne %0, %3, 2f\n"
+                      "   sc.w.aqrl %1, %4, (%2)\n"
+                      "   bnez %1, 1b\n"
+                      "2:\n" : "=&r"(old), "=&r"(fail) : "r"(p), "r"(cmp), "r"(swp) : "memory");
+        return old;
+#else
+        asm volatile ("casa [%1] 0xA, %2, %0\n" : "+r"(swp) : "r"(p), "r"(cmp) : "memory");
+        return swp;
+#endif
+}
+
+static unsigned int mpt_fetch_add(volatile unsigned int *p, unsigned int v)
+{
+        unsigned int old;
+
+        do {
+                old = *p;
+        } while (mpt_cas(p, old, old + v) != old);
+        return old;
+}
+
+static void mpt_idle_mark(unsigned int bit, int idle)
+{
+        unsigned int old;
+
+        do {
+                old = mpt_idle;
+        } while (mpt_cas(&mpt_idle, old, idle ? old | bit : old & ~bit) != old);
+}
+
+/* Orders earlier stores before later loads */
+static void mpt_fence(void)
+{
+#if defined(__riscv)
+        asm volatile ("fence rw, rw" ::: "memory");
+#else
+        /* An atomic drains the store buffer */
+        unsigned int v = 0, w;
+
+        asm volatile ("swap [%1], %0\n" : "+r"(v) : "r"(&w) : "memory");
+#endif
+}
+
+static int mpt_cpu(void)
+{
+        unsigned int id;
+
+#if defined(__riscv)
+        asm volatile ("csrr %0, mhartid" : "=r"(id));
+        return id;
+#else
+        asm volatile ("mov %%asr17, %0" : "=r"(id));
+        return id >> 28;
+#endif
+}
+
+/* Owner only */
+static int mpt_push(struct mpt_deque *d, struct mpt_task *t)
+{
+        unsigned int b = d->bottom;
+
+        if ((int)(b - d->top) >= MPT_DEQUE) {
+                return -1;
+        }
+        d->buf[b & (MPT_DEQUE - 1)] = t;
+        MPT_WMB();
+        d->bottom = b + 1;
+        return 0;
+}
+
+/* Owner only */
+static struct mpt_task *mpt_pop(struct mpt_deque *d)
+{
+        unsigned int b = d->bottom - 1, t;
+        struct mpt_task *task;
+
+        d->bottom = b;
+        mpt_fence();
+        t = d->top;
+        if ((int)(b - t) < 0) {
+                d->bottom = b + 1;
+                return NULL;
+        }
+        task = d->buf[b & (MPT_DEQUE - 1)];
+        if (b == t) {
+                /* Last task, the thieves may race for it */
+                if (mpt_cas(&d->top, t, t + 1) != t) {
+                        task = NULL;
+                }
+                d->bottom = b + 1;
+        }
+        return task;
+}
+
+static struct mpt_task *mpt_steal(struct mpt_deque *d)
+{
+        unsigned int t = d->top, b;
+        struct mpt_task *task;
+
+        MPT_RMB();
+        b = d->bottom;
+        if ((int)(b - t) <= 0) {
+                return NULL;
+        }
+        task = d->buf[t & (MPT_DEQUE - 1)];
+        if (mpt_cas(&d->top, t, t + 1) != t) {
+                return NULL;
+        }
+        return task;
+}
+
+/* Own tasks newest first, then the oldest task of the next CPUs */
+static struct mpt_task *mpt_find(int cpu)
+{
+        struct mpt_task *t;
+        int i;
+
+        if ((t = mpt_pop(&mpt_dq[cpu])) != NULL) {
+                return t;
+        }
+        for (i = 1; i < mpt_ncpu; i++) {
+                if ((t = mpt_steal(&mpt_dq[(cpu + i) % mpt_ncpu])) != NULL) {
+                        return t;
+                }
+        }
+        return NULL;
+}
+
+static void mpt_run(struct mpt_task *t)
+{
+        struct mpt_group *g = t->group;
+
+        /* t may be gone once the group is done */
+        t->fn(t->arg);
+        mpt_fetch_add(&g->pending, -1);
+}
+
+static void mpt_wake(void)
+{
+        unsigned int idle = mpt_idle & ((1U << mpt_active) - 1);
+        int cpu;
+
+        if (idle == 0) {
+                return;
+        }
+        for (cpu = 0; !(idle & (1U << cpu)); cpu++) {
+        }
+#if !defined(__riscv)
+        mpt_irqmp[MPT_IRQFORCE / 4 + cpu] = 1 << mpt_irq;
+#endif
+}
+
+static void mpt_park(int cpu)
+{
+        int i, work = 0;
+
+        /* The atomic update orders the idle bit before the deque reads */
+        mpt_idle_mark(1U << cpu, 1);
+        for (i = 0; i < mpt_ncpu; i++) {
+                if ((int)(mpt_dq[i].bottom - mpt_dq[i].top) > 0) {
+                        work = 1;
+                }
+        }
+        if (mpt_up && (cpu >= mpt_active || !work)) {
+#if !defined(__riscv)
+                asm volatile ("wr %g0, %g0, %asr19");   /* power-down */
+#endif
+        }
+        mpt_idle_mark(1U << cpu, 0);
+}
+
+#if !defined(__riscv)
+static void mpt_ipi(int irq)
+{
+        (void)irq;
+}
+#endif
+
+int mpt_init(volatile int *irqmp_ptr, int irq)
+{
+        int i;
+
+        mpt_irqmp = irqmp_ptr;
+        mpt_irq = irq;
+        mpt_ncpu = (((*(irqmp_ptr + 0x10/4)) >> 28) & 0x0f) + 1;
+        for (i = 0; i < mpt_ncpu; i++) {
+                mpt_dq[i].top = 0;
+                mpt_dq[i].bottom = 0;
+        }
+        mpt_idle = 0;
+        mpt_nworkers = 0;
+        mpt_active = mpt_ncpu;
+#if !defined(__riscv)
+        catch_interrupt(mpt_ipi, irq);
+#endif
+        mpt_up = 1;
+        return mpt_ncpu;
+}
+
+void mpt_worker(int cpu)
+{
+        struct mpt_task *t;
+        int spins = 0;
+
+        while (!mpt_up) {
+        }
+        mpt_fetch_add(&mpt_nworkers, 1);
+#if !defined(__riscv)
+        bcc_int_unmask(mpt_irq);
+#endif
+        while (mpt_up) {
+                if (cpu < mpt_active && (t = mpt_find(cpu)) != NULL) {
+                        mpt_run(t);
+                        spins = 0;
+                } else if (++spins == MPT_SPINS) {
+                        spins = 0;
+                        mpt_park(cpu);
+                }
+        }
+#if !defined(__riscv)
+        bcc_int_mask(mpt_irq);
+#endif
+        mpt_fetch_add(&mpt_nworkers, -1);
+}
+
+void mpt_exit(void)
+{
+        int cpu;
+
+        mpt_up = 0;
+        while (mpt_nworkers != 0) {
+                for (cpu = 1; cpu < mpt_ncpu; cpu++) {
+#if !defined(__riscv)
+                        if (mpt_idle & (1U << cpu)) {
+                                mpt_irqmp[MPT_IRQFORCE / 4 + cpu] = 1 << mpt_irq;
+                        }
+#endif
+                }
+        }
+}
+
+void mpt_set_active(int n)
+{
+        mpt_active = n < 1 ? 1 : n > mpt_ncpu ? mpt_ncpu : n;
+}
+
+void mpt_spawn(struct mpt_group *g, struct mpt_task *t, void (*fn)(void *arg), void *arg)
+{
+        t->fn = fn;
+        t->arg = arg;
+        t->group = g;
+        mpt_fetch_add(&g->pending, 1);
+        if (mpt_push(&mpt_dq[mpt_cpu()], t) < 0) {
+                /* Deque full, run it here */
+                mpt_run(t);
+                return;
+        }
+        /* Orders the push before the idle mask read, see mpt_park() */
+        mpt_fence();
+        if (mpt_idle) {
+                mpt_wake();
+        }
+}
+
+void mpt_sync(struct mpt_group *g)
+{
+        struct mpt_task *t;
+        int cpu = mpt_cpu();
+
+        while (g->pending != 0) {
+                if ((t = mpt_find(cpu)) != NULL) {
+                        mpt_run(t);
+                }
+        }
+}
+
+struct mpt_range {
+        void (*fn)(int lo, int hi, void *arg);
+        void *arg;
+        int lo;
+        int hi;
+        int grain;
+};
+
+/* Splits in halves, spawning the upper half, down to the grain */
+static void mpt_for_range(void *p)
+{
+        struct mpt_range *r = p, left, right;
+        struct mpt_group g;
+        struct mpt_task t;
+
+        if (r->hi - r->lo <= r->grain) {
+                r->fn(r->lo, r->hi, r->arg);
+                return;
+        }
+        left = *r;
+        right = *r;
+        left.hi = right.lo = r->lo + (r->hi - r->lo) / 2;
+        g.pending = 0;
+        mpt_spawn(&g, &t, mpt_for_range, &right);
+        mpt_for_range(&left);
+        mpt_sync(&g);
+}
+
+void mpt_parallel_for(int lo, int hi, int grain, void (*fn)(int lo, int hi, void *arg),
+                      void *arg)
+{
+        struct mpt_range r;
+
+        r.fn = fn;
+        r.arg = arg;
+        r.lo = lo;
+        r.hi = hi;
+        r.grain = grain < 1 ? 1 : grain;
+        if (hi > lo) {
+                mpt_for_range(&r);
+        }
+}
+
+static unsigned int mpt_a[MPT_BENCH_N], mpt_b[MPT_BENCH_N], mpt_c[MPT_BENCH_N];
+
+static void mpt_triad(int lo, int hi, void *arg)
+{
+        int i;
+
+        (void)arg;
+        for (i = lo; i < hi; i++) {
+                mpt_a[i] = mpt_b[i] + 3 * mpt_c[i];
+        }
+}
+
+static unsigned int mpt_hash1(unsigned int x)
+{
+        int k;
+
+        for (k = 0; k < 64; k++) {
+                x = x * 1103515245 + 12345;
+                x ^= x >> 13;
+        }
+        return x;
+}
+
+static void mpt_hash(int lo, int hi, void *arg)
+{
+        int i;
+
+        (void)arg;
+        for (i = lo; i < hi; i++) {
+                mpt_a[i] = mpt_hash1(i);
+        }
+}
+
+int mpt_bench(unsigned int dsu_addr)
+{
+        static const char *name[2] = { "triad", "hash" };
+        static void (*const fn[2])(int lo, int hi, void *arg) = { mpt_triad, mpt_hash };
+        static const int len[2] = { MPT_BENCH_N, MPT_BENCH_N / 4 };
+        unsigned int base = 0, cyc, sp;
+        unsigned long long t0;
+        int k, n, i, err = 0;
+
+        tsc_init(dsu_addr);
+        for (i = 0; i < MPT_BENCH_N; i++) {
+                mpt_b[i] = i;
+                mpt_c[i] = i ^ 0x5a5a;
+        }
+        for (k = 0; k < 2; k++) {
+                for (n = 1; n <= MPT_BENCH_CPUS && n <= mpt_ncpu; n++) {
+                        mpt_set_active(n);
+                        for (i = 0; i < len[k]; i++) {
+                                mpt_a[i] = 0;
+                        }
+                        t0 = tsc_read();
+                        mpt_parallel_for(0, len[k], len[k] / 64, fn[k], NULL);
+                        cyc = tsc_read() - t0;
+                        for (i = 0; i < len[k]; i++) {
+                                if (mpt_a[i] != (k ? mpt_hash1(i) : mpt_b[i] + 3 * mpt_c[i])) {
+                                        err = -1;
+                                        break;
+                                }
+                        }
+                        if (n == 1) {
+                                base = cyc;
+                        }
+                        sp = (unsigned long long)base * 100 / cyc;
+                        printf("mptask %-5s cpus %d cycles %10u speedup %u.%02u\n", name[k], n,
+                               cyc, sp / 100, sp % 100);
+                }
+        }
+        mpt_set_active(mpt_ncpu);
+        return err;
+}
@@ -0,0 +1,109 @@
+/*
+ * Region markers on the L3STAT/L4STAT counters and the time-stamp counter
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <stdio.h>
+#include "lstat.h"
+#include "perf_region.h"
+
+#define PERF_OVERHEAD_RUNS 16
+
+struct perf_ring perf_rings[PERF_MAX_CPU];
+
+static const unsigned char *perf_events;
+static unsigned int perf_overhead;
+
+int perf_region_init(unsigned int addr, int ncpu, const unsigned char *events)
+{
+        volatile unsigned int *ctrl = (unsigned int *)(addr + L4STAT_CTRL_REG_REV1);
+        int cpu, i, ncnt;
+
+        lstat_init(addr);
+        ncnt = ((*ctrl >> L4STAT_CTRL_NCNT_REV1) & L4STAT_CTRL_NCNT_MSK_REV1) + 1;
+        if (ncpu > PERF_MAX_CPU || ncpu * PERF_NCNT > ncnt) {
+                return -1;
+        }
+        for (cpu = 0; cpu < ncpu; cpu++) {
+                for (i = 0; i < PERF_NCNT; i++) {
+                        lstat_set(addr, cpu * PERF_NCNT + i, cpu, events[i]);
+                }
+                perf_rings[cpu].val = (unsigned int *)(addr + L4STAT_VAL_REG) + cpu * PERF_NCNT;
+                perf_rings[cpu].head = 0;
+        }
+        perf_events = events;
+        perf_region_cpu_init();
+        perf_overhead = perf_region_overhead();
+        return 0;
+}
+
+void perf_region_cpu_init(void)
+{
+        unsigned int tmp = ~PERF_END;
+
+        asm volatile("mov %0, %%asr22; nop; nop; nop " : : "r"(tmp));
+}
+
+unsigned int perf_region_overhead(void)
+{
+        struct perf_ring *r;
+        unsigned int cpu, head, hi, lo, best, i;
+        struct perf_rec *b, *e;
+
+        asm volatile("mov %%asr17, %0" : "=r"(cpu));
+        cpu >>= 28;
+        if (cpu >= PERF_MAX_CPU) {
+                return 0;
+        }
+        r = &perf_rings[cpu];
+        head = r->head;
+        best = ~0;
+        for (i = 0; i < PERF_OVERHEAD_RUNS; i++) {
+                perf_region_begin(0);
+                perf_region_end(0);
+                b = &r->rec[(r->head - 2) & (PERF_RING - 1)];
+                e = &r->rec[(r->head - 1) & (PERF_RING - 1)];
+                hi = e->tsc_hi - b->tsc_hi;
+                lo = e->tsc_lo - b->tsc_lo;
+                if (!hi && lo < best) {
+                        best = lo;
+                }
+        }
+        /* The measurement records are not kept */
+        r->head = head;
+        return best;
+}
+
+void perf_region_dump(int ncpu)
+{
+        struct perf_ring *r;
+        struct perf_rec *p;
+        unsigned int n, first;
+        int cpu, i;
+
+        printf("perf_region overhead %u\n", perf_overhead);
+        if (ncpu > PERF_MAX_CPU) {
+                ncpu = PERF_MAX_CPU;
+        }
+        for (cpu = 0; cpu < ncpu; cpu++) {
+                r = &perf_rings[cpu];
+                n = r->head < PERF_RING ? r->head : PERF_RING;
+                first = r->head - n;
+                printf("perf_region cpu %d head %u ncnt %d events", cpu, r->head, PERF_NCNT);
+                for (i = 0; i < PERF_NCNT; i++) {
+                        printf(" %02x", perf_events ? perf_events[i] : 0);
+                }
+                printf("\n");
+                for (; first != r->head; first++) {
+                        p = &r->rec[first & (PERF_RING - 1)];
+                        printf("r %08x %08x %08x", p->tag, p->tsc_hi, p->tsc_lo);
+                        for (i = 0; i < PERF_NCNT; i++) {
+                                printf(" %08x", p->cnt[i]);
+                        }
+                        printf("\n");
+                }
+        }
+        printf("perf_region end\n");
+}
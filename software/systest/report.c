@@ -71,3 +71,6 @@ void report_mem_test(void) {
   the_ops->report_mem_test();
 }
 
+void report_bench(int id, const char *name, unsigned int min, unsigned int median) {
+  the_ops->report_bench(id, name, min, median);
+}
@@ -75,6 +75,15 @@ static void ahbrep_report_mem_test(void)
 	grtestmod_write(7,1);
 }
 
+static void ahbrep_report_bench(int id, const char *name, unsigned int min,
+				unsigned int median)
+{
+	(void)name;
+	grtestmod_write(8, id);
+	grtestmod_write(9, min);
+	grtestmod_write(10, median);
+}
+
 const struct report_ops report_ops_grtestmod = {
   .report_start     = ahbrep_report_start,
   .report_end       = ahbrep_report_end,
@@ -83,5 +92,6 @@ const struct report_ops report_ops_grtestmod = {
   .fail             = ahbrep_fail,
   .chkp             = ahbrep_chkp,
   .report_mem_test  = ahbrep_report_mem_test,
+  .report_bench     = ahbrep_report_bench,
 };
 
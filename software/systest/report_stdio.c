@@ -64,6 +64,12 @@ static int stdio_fail(int id)
         return(0);
 }
 
+static void stdio_report_bench(int id, const char *name, unsigned int min,
+                               unsigned int median)
+{
+        printf("  bench %2d %-20s min %10u median %10u cycles\n", id, name, min, median);
+}
+
 static void stdio_chkp(int n)
 {
         printf("Checkpoint %u\n", (unsigned) n & 0xffff);
@@ -215,5 +221,6 @@ const struct report_ops report_ops_stdio = {
   .fail             = stdio_fail,
   .chkp             = stdio_chkp,
   .report_mem_test  = stdio_report_mem_test,
+  .report_bench     = stdio_report_bench,
 };
 
@@ -0,0 +1,254 @@
+/*
+ * Host decoder for ahbtrace_dump() output
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ * Reads a console log containing an AHBTRACE dump, with fixed entries or
+ * compressed records, and prints per AHB master the transfers, bytes and
+ * bandwidth, and for compressed records the wait states per burst as a
+ * measure of latency. With -v every burst is printed as well.
+ *
+ * usage: ahbtrace_decode [-v] [-f MHz] [log]
+ *   -v      print each record
+ *   -f MHz  trace clock, to print bandwidth in MB/s
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINES (1 << 20)
+
+#define AHBTRACE_CM   0x400
+#define AHBTRACE_WRAP 0x800
+
+struct mst {
+        unsigned long bursts;
+        unsigned long beats;
+        unsigned long reads;            /* Beats */
+        unsigned long writes;
+        unsigned long errors;
+        unsigned long long bytes;
+        unsigned long long waits;
+        unsigned int maxwaits;
+};
+
+static struct mst msts[16];
+static unsigned int line[MAX_LINES][4];
+static unsigned int index_[MAX_LINES];
+static int nline;
+static int verbose;
+static unsigned long long tfirst = ~0ULL, tlast;
+static int waits_valid;
+
+static const char *hresp[4] = { "okay", "error", "retry", "split" };
+
+static void record(unsigned long long t, int m, int wr, unsigned int addr, int size,
+                   int beats, int waits, int resp)
+{
+        struct mst *s = &msts[m];
+
+        if (t < tfirst) {
+                tfirst = t;
+        }
+        if (t > tlast) {
+                tlast = t;
+        }
+        s->bursts++;
+        s->beats += beats;
+        if (wr) {
+                s->writes += beats;
+        } else {
+                s->reads += beats;
+        }
+        if (resp == 1) {
+                s->errors++;
+        }
+        s->bytes += (unsigned long long)beats << size;
+        if (waits >= 0) {
+                s->waits += waits;
+                if ((unsigned int)waits > s->maxwaits) {
+                        s->maxwaits = waits;
+                }
+        }
+        if (verbose) {
+                printf("%12llu  mst %2d %s %08x size %3d beats %2d", t, m, wr ? "write" : "read ",
+                       addr, 1 << size, beats);
+                if (waits >= 0) {
+                        printf(" waits %2d", waits);
+                }
+                printf(" %s\n", hresp[resp]);
+        }
+}
+
+/* One transfer per line: time, flags, data, address */
+static void decode_fixed(void)
+{
+        unsigned long long t = 0;
+        unsigned int *w, last = 0;
+        int i, trans;
+
+        for (i = 0; i < nline; i++) {
+                w = line[i];
+                /* The time tag is 32 bits, extend it */
+                t += w[0] - last;
+                last = w[0];
+                trans = (w[1] >> 13) & 3;
+                if (trans < 2) {
+                        continue;
+                }
+                record(t, (w[1] >> 3) & 15, (w[1] >> 15) & 1, w[3], (w[1] >> 10) & 7, 1, -1,
+                       w[1] & 3);
+        }
+}
+
+static void decode_compressed(int wrapped)
+{
+        unsigned long long t = 0;
+        unsigned int laddr[16], w, addr;
+        int have_time = 0, i, k, m, wr, size, beats, waits, resp, da;
+
+        memset(laddr, 0, sizeof(laddr));
+        for (i = 0; i < nline; i++) {
+                /* After a wrap, decoding starts at a line opened with a time record */
+                if (!have_time && (index_[i] & 15) != 0) {
+                        continue;
+                }
+                for (k = 0; k < 4; k++) {
+                        w = line[i][k];
+                        m = (w >> 26) & 15;
+                        wr = (w >> 25) & 1;
+                        switch (w >> 30) {
+                        case 0:
+                                /* Rest of the line unused */
+                                k = 4;
+                                continue;
+                        case 1:
+                                if (!have_time) {
+                                        break;
+                                }
+                                size = (w >> 23) & 3;
+                                beats = ((w >> 20) & 7) + 1;
+                                waits = (w >> 16) & 15;
+                                da = ((int)(w << 22)) >> 22;
+                                t += (w >> 10) & 63;
+                                addr = laddr[m] + da;
+                                record(t, m, wr, addr, size, beats, waits, 0);
+                                laddr[m] = addr;
+                                break;
+                        default:
+                                if (k + 1 + (w >> 30 == 3) > 3) {
+                                        fprintf(stderr, "line %u: record crosses the line\n",
+                                                index_[i]);
+                                        k = 4;
+                                        continue;
+                                }
+                                size = (w >> 22) & 7;
+                                resp = (w >> 20) & 3;
+                                beats = ((w >> 15) & 15) + 1;
+                                waits = (w >> 10) & 31;
+                                addr = line[i][++k];
+                                if (w >> 30 == 3) {
+                                        /* Time record, extend the 32-bit time */
+                                        w = line[i][++k];
+                                        t = have_time ? t + (unsigned int)(w - (unsigned int)t) : w;
+                                        have_time = 1;
+                                } else if (have_time) {
+                                        t += w & 1023;
+                                } else {
+                                        break;
+                                }
+                                record(t, m, wr, addr, size, beats, waits, resp);
+                                laddr[m] = addr;
+                                break;
+                        }
+                }
+        }
+        if (wrapped && !have_time) {
+                fprintf(stderr, "no time record found\n");
+        }
+        waits_valid = 1;
+}
+
+static void report(double mhz, unsigned int lines)
+{
+        unsigned long long span = tlast - tfirst + 1;
+        unsigned long beats = 0;
+        struct mst *s;
+        int m;
+
+        printf("%3s %8s %8s %8s %8s %12s %10s", "mst", "bursts", "reads", "writes", "errors",
+               "bytes", mhz > 0 ? "MB/s" : "B/cycle");
+        if (waits_valid) {
+                printf(" %10s %10s %8s", "waits/brst", "waits/beat", "maxwaits");
+        }
+        printf("\n");
+        for (m = 0; m < 16; m++) {
+                s = &msts[m];
+                if (s->bursts == 0) {
+                        continue;
+                }
+                beats += s->beats;
+                printf("%3d %8lu %8lu %8lu %8lu %12llu %10.3f", m, s->bursts, s->reads, s->writes,
+                       s->errors, s->bytes, (double)s->bytes / span * (mhz > 0 ? mhz : 1));
+                if (waits_valid) {
+                        printf(" %10.2f %10.2f %8u", (double)s->waits / s->bursts,
+                               (double)s->waits / s->beats, s->maxwaits);
+                }
+                printf("\n");
+        }
+        printf("%llu cycles, %lu beats in %u lines, %.2f beats per line\n", span, beats, lines,
+               lines ? (double)beats / lines : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+        unsigned int ctrl = 0, index, lines = 0, l, w[4];
+        double mhz = 0;
+        char buf[256];
+        FILE *f = stdin;
+        int i, found = 0;
+
+        for (i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "-v") == 0) {
+                        verbose = 1;
+                } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+                        mhz = atof(argv[++i]);
+                } else if ((f = fopen(argv[i], "r")) == NULL) {
+                        perror(argv[i]);
+                        return 1;
+                }
+        }
+
+        while (fgets(buf, sizeof(buf), f) != NULL) {
+                if (sscanf(buf, "ahbtrace ctrl %x index %x lines %u", &ctrl, &index, &lines) == 3) {
+                        found = 1;
+                        nline = 0;
+                        continue;
+                }
+                if (!found || sscanf(buf, "l %u %x %x %x %x", &l, &w[0], &w[1], &w[2], &w[3]) != 5) {
+                        continue;
+                }
+                if (nline == MAX_LINES) {
+                        fprintf(stderr, "too many lines\n");
+                        return 1;
+                }
+                index_[nline] = l;
+                memcpy(line[nline++], w, sizeof(w));
+        }
+        if (nline == 0) {
+                fprintf(stderr, "no trace lines found\n");
+                return 1;
+        }
+        if (ctrl & AHBTRACE_CM) {
+                decode_compressed(ctrl & AHBTRACE_WRAP);
+        } else {
+                decode_fixed();
+        }
+        if (tfirst > tlast) {
+                fprintf(stderr, "no transfers found\n");
+                return 1;
+        }
+        report(mhz, nline);
+        return 0;
+}
@@ -0,0 +1,485 @@
+/*
+ * Host decoder for dsu3_stream_dump() output
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ * Reads a console log containing a dsu3_stream dump and prints the
+ * instruction and AHB trace entries as one timeline, ordered by the DSU
+ * time tag. The 30-bit time tags are extended assuming less than 2^30
+ * cycles between entries. Instructions are disassembled as by
+ * lib/grlib/sparc/sparc_disas.vhd.
+ *
+ * usage: dsu3_decode [-i] [-a] [log]
+ *   -i  instruction trace only
+ *   -a  AHB trace only
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG_MASK 0x3fffffffu
+
+struct ent {
+        long long t;
+        int ahb;
+        size_t seq;
+        unsigned int w[4];
+};
+
+static struct ent *ents;
+static size_t nent, maxent;
+
+static const char *cond[16] = {
+        "n", "e", "le", "l", "leu", "cs", "neg", "vs",
+        "a", "ne", "g", "ge", "gu", "cc", "pos", "vc"
+};
+
+static const char *fcond[16] = {
+        "n", "ne", "lg", "ul", "l", "ug", "g", "u",
+        "a", "e", "ue", "ge", "uge", "le", "ule", "o"
+};
+
+/* op 2, NULL for the formats decoded separately */
+static const char *alu[64] = {
+        "add", "and", "or", "xor", "sub", "andn", "orn", "xnor",
+        "addx", NULL, "umul", "smul", "subx", NULL, "udiv", "sdiv",
+        "addcc", "andcc", "orcc", "xorcc", "subcc", "andncc", "orncc", "xnorcc",
+        "addxcc", NULL, "umulcc", "smulcc", "subxcc", NULL, "udivcc", "sdivcc",
+        "taddcc", "tsubcc", "taddcctv", "tsubcctv", "mulscc", "sll", "srl", "sra",
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL, "save", "restore", "umac", "smac"
+};
+
+/* op 3, reg is the class of rd: r, f, c, a for alternate space, or special */
+static const struct {
+        const char *name;
+        char reg;
+        char store;
+} mem[64] = {
+        [0x00] = { "ld", 'r', 0 },   [0x01] = { "ldub", 'r', 0 },   [0x02] = { "lduh", 'r', 0 },
+        [0x03] = { "ldd", 'r', 0 },  [0x04] = { "st", 'r', 1 },     [0x05] = { "stb", 'r', 1 },
+        [0x06] = { "sth", 'r', 1 },  [0x07] = { "std", 'r', 1 },    [0x09] = { "ldsb", 'r', 0 },
+        [0x0a] = { "ldsh", 'r', 0 }, [0x0d] = { "ldstub", 'r', 0 }, [0x0f] = { "swap", 'r', 0 },
+        [0x10] = { "lda", 'a', 0 },  [0x11] = { "lduba", 'a', 0 },  [0x12] = { "lduha", 'a', 0 },
+        [0x13] = { "ldda", 'a', 0 }, [0x14] = { "sta", 'a', 1 },    [0x15] = { "stba", 'a', 1 },
+        [0x16] = { "stha", 'a', 1 }, [0x17] = { "stda", 'a', 1 },   [0x19] = { "ldsba", 'a', 0 },
+        [0x1a] = { "ldsha", 'a', 0 }, [0x1d] = { "ldstuba", 'a', 0 }, [0x1f] = { "swapa", 'a', 0 },
+        [0x20] = { "ld", 'f', 0 },   [0x21] = { "ld", 's', 0 },     [0x23] = { "ldd", 'f', 0 },
+        [0x24] = { "st", 'f', 1 },   [0x25] = { "st", 's', 1 },     [0x26] = { "std", 'q', 1 },
+        [0x27] = { "std", 'f', 1 },  [0x30] = { "ld", 'c', 0 },     [0x31] = { "ld", 'S', 0 },
+        [0x33] = { "ldd", 'c', 0 },  [0x34] = { "st", 'c', 1 },     [0x35] = { "st", 'S', 1 },
+        [0x36] = { "std", 'Q', 1 },  [0x37] = { "std", 'c', 1 },    [0x3c] = { "casa", 'x', 0 },
+};
+
+static const struct {
+        unsigned int opf;
+        const char *name;
+        int nsrc;
+} fpop[] = {
+        { 0x001, "fmovs", 1 }, { 0x005, "fnegs", 1 }, { 0x009, "fabss", 1 },
+        { 0x029, "fsqrts", 1 }, { 0x02a, "fsqrtd", 1 }, { 0x041, "fadds", 2 },
+        { 0x042, "faddd", 2 }, { 0x045, "fsubs", 2 }, { 0x046, "fsubd", 2 },
+        { 0x049, "fmuls", 2 }, { 0x04a, "fmuld", 2 }, { 0x04d, "fdivs", 2 },
+        { 0x04e, "fdivd", 2 }, { 0x069, "fsmuld", 2 }, { 0x0c4, "fitos", 1 },
+        { 0x0c6, "fdtos", 1 }, { 0x0c8, "fitod", 1 }, { 0x0c9, "fstod", 1 },
+        { 0x0d1, "fstoi", 1 }, { 0x0d2, "fdtoi", 1 },
+        { 0x151, "fcmps", 0 }, { 0x152, "fcmpd", 0 }, { 0x155, "fcmpes", 0 },
+        { 0x156, "fcmped", 0 },
+};
+
+static const char *htrans[4] = { "idle", "busy", "nseq", "seq" };
+static const char *hresp[4] = { "okay", "error", "retry", "split" };
+
+static const char *reg(unsigned int r)
+{
+        static char buf[4][8];
+        static int n;
+        char *p = buf[n++ & 3];
+
+        snprintf(p, 8, "%%%c%u", "goli"[(r >> 3) & 3], r & 7);
+        return p;
+}
+
+/* rs2 or simm13, as "rs2" or a number */
+static void op2(char *buf, size_t len, unsigned int insn, int hex)
+{
+        int simm = ((int)(insn << 19)) >> 19;
+
+        if (!(insn & 0x2000)) {
+                snprintf(buf, len, "%s", reg(insn & 31));
+        } else if (hex) {
+                snprintf(buf, len, "0x%x", simm & 0x1fff);
+        } else {
+                snprintf(buf, len, "%d", simm);
+        }
+}
+
+/* Memory address, [rs1 + rs2] or [rs1 + simm13] */
+static void addr(char *buf, size_t len, unsigned int insn)
+{
+        unsigned int rs1 = (insn >> 14) & 31;
+        int simm = ((int)(insn << 19)) >> 19;
+
+        if (!(insn & 0x2000)) {
+                if ((insn & 31) == 0) {
+                        snprintf(buf, len, "[%s]", reg(rs1));
+                } else {
+                        snprintf(buf, len, "[%s + %s]", reg(rs1), reg(insn & 31));
+                }
+        } else if (rs1 == 0) {
+                snprintf(buf, len, "[%d]", simm);
+        } else if (simm == 0) {
+                snprintf(buf, len, "[%s]", reg(rs1));
+        } else if (simm < 0) {
+                snprintf(buf, len, "[%s - %d]", reg(rs1), -simm);
+        } else {
+                snprintf(buf, len, "[%s + %d]", reg(rs1), simm);
+        }
+}
+
+static void disas_mem(char *buf, size_t len, unsigned int insn)
+{
+        unsigned int op3 = (insn >> 19) & 63, rd = (insn >> 25) & 31;
+        char a[48], r[16];
+
+        if (mem[op3].name == NULL) {
+                snprintf(buf, len, "unknown opcode: %08x", insn);
+                return;
+        }
+        addr(a, sizeof(a), insn);
+        switch (mem[op3].reg) {
+        case 'a':
+                snprintf(a + strlen(a), sizeof(a) - strlen(a), " 0x%x", (insn >> 5) & 0xff);
+                /* fall through */
+        case 'r':
+                snprintf(r, sizeof(r), "%s", reg(rd));
+                break;
+        case 'f':
+                snprintf(r, sizeof(r), "%%f%u", rd);
+                break;
+        case 'c':
+                snprintf(r, sizeof(r), "%%c%u", rd);
+                break;
+        case 's':
+                snprintf(r, sizeof(r), "%%fsr");
+                break;
+        case 'S':
+                snprintf(r, sizeof(r), "%%csr");
+                break;
+        case 'q':
+                snprintf(r, sizeof(r), "%%fq");
+                break;
+        case 'Q':
+                snprintf(r, sizeof(r), "%%cq");
+                break;
+        case 'x':
+                snprintf(buf, len, "casa [%s] 0x%x, %s, %s", reg((insn >> 14) & 31),
+                         (insn >> 5) & 0xff, reg(insn & 31), reg(rd));
+                return;
+        }
+        if (mem[op3].store && rd == 0 && mem[op3].reg == 'r' && op3 != 0x07) {
+                snprintf(buf, len, "clr%s %s", mem[op3].name + 2, a);
+        } else if (mem[op3].store) {
+                snprintf(buf, len, "%s %s, %s", mem[op3].name, r, a);
+        } else {
+                snprintf(buf, len, "%s %s, %s", mem[op3].name, a, r);
+        }
+}
+
+static void disas_fpop(char *buf, size_t len, unsigned int insn)
+{
+        unsigned int opf = (insn >> 5) & 0x1ff, rd = (insn >> 25) & 31;
+        unsigned int rs1 = (insn >> 14) & 31, rs2 = insn & 31, i;
+
+        if (((insn >> 19) & 63) == 0x35) {
+                opf |= 0x100;
+        }
+        for (i = 0; i < sizeof(fpop) / sizeof(fpop[0]); i++) {
+                if (fpop[i].opf != opf) {
+                        continue;
+                }
+                if (fpop[i].nsrc == 0) {
+                        snprintf(buf, len, "%s %%f%u, %%f%u", fpop[i].name, rs1, rs2);
+                } else if (fpop[i].nsrc == 1) {
+                        snprintf(buf, len, "%s %%f%u, %%f%u", fpop[i].name, rs2, rd);
+                } else {
+                        snprintf(buf, len, "%s %%f%u, %%f%u, %%f%u", fpop[i].name, rs1, rs2, rd);
+                }
+                return;
+        }
+        snprintf(buf, len, "unknown FPop: %08x", insn);
+}
+
+static void disas_alu(char *buf, size_t len, unsigned int insn)
+{
+        unsigned int op3 = (insn >> 19) & 63, rd = (insn >> 25) & 31, rs1 = (insn >> 14) & 31;
+        int hex = op3 == 0x01 || op3 == 0x02 || op3 == 0x03 || op3 == 0x05 || op3 == 0x06 ||
+                  op3 == 0x07 || (op3 >= 0x11 && op3 <= 0x17);
+        char o[32];
+
+        op2(o, sizeof(o), insn, hex);
+        switch (op3) {
+        case 0x02:
+                if (rs1 == 0 && (insn & 0x2000) == 0 && (insn & 31) == 0) {
+                        snprintf(buf, len, "clr %s", reg(rd));
+                } else if (rs1 == 0) {
+                        snprintf(buf, len, "mov %s, %s", o, reg(rd));
+                } else {
+                        snprintf(buf, len, "or %s, %s, %s", reg(rs1), o, reg(rd));
+                }
+                return;
+        case 0x28:
+                if (rs1) {
+                        snprintf(buf, len, "mov %%asr%u, %s", rs1, reg(rd));
+                } else {
+                        snprintf(buf, len, "mov %%y, %s", reg(rd));
+                }
+                return;
+        case 0x29:
+        case 0x2a:
+        case 0x2b:
+                snprintf(buf, len, "mov %%%s, %s",
+                         op3 == 0x29 ? "psr" : op3 == 0x2a ? "wim" : "tbr", reg(rd));
+                return;
+        case 0x30:
+        case 0x31:
+        case 0x32:
+        case 0x33: {
+                char d[8];
+
+                if (op3 == 0x30 && rd) {
+                        snprintf(d, sizeof(d), "%%asr%u", rd);
+                } else {
+                        snprintf(d, sizeof(d), "%%%s", op3 == 0x30 ? "y" : op3 == 0x31 ? "psr" :
+                                 op3 == 0x32 ? "wim" : "tbr");
+                }
+                if (rs1 == 0) {
+                        snprintf(buf, len, "mov %s, %s", o, d);
+                } else {
+                        snprintf(buf, len, "wr %s, %s, %s", reg(rs1), o, d);
+                }
+                return;
+        }
+        case 0x34:
+        case 0x35:
+                disas_fpop(buf, len, insn);
+                return;
+        case 0x36:
+        case 0x37:
+                snprintf(buf, len, "cpop%d 0x%x, %%c%u, %%c%u, %%c%u", op3 - 0x35,
+                         (insn >> 5) & 0x1ff, rs1, insn & 31, rd);
+                return;
+        case 0x38: {
+                char a[48];
+
+                if (rd == 0 && (insn & 0x3fff) == 0x2008 && rs1 == 31) {
+                        snprintf(buf, len, "ret");
+                } else if (rd == 0 && (insn & 0x3fff) == 0x2008 && rs1 == 15) {
+                        snprintf(buf, len, "retl");
+                } else {
+                        addr(a, sizeof(a), insn);
+                        a[strlen(a) - 1] = 0;
+                        if (rd == 0) {
+                                snprintf(buf, len, "jmp %s", a + 1);
+                        } else {
+                                snprintf(buf, len, "jmpl %s, %s", a + 1, reg(rd));
+                        }
+                }
+                return;
+        }
+        case 0x39:
+                addr(o, sizeof(o), insn);
+                o[strlen(o) - 1] = 0;
+                snprintf(buf, len, "rett %s", o + 1);
+                return;
+        case 0x3a:
+                op2(o, sizeof(o), insn, 1);
+                snprintf(buf, len, "t%s %s + %s", cond[rd & 15], reg(rs1), o);
+                return;
+        case 0x3b:
+                addr(o, sizeof(o), insn);
+                o[strlen(o) - 1] = 0;
+                snprintf(buf, len, "flush %s", o + 1);
+                return;
+        case 0x3c:
+        case 0x3d:
+                if (rd == 0 && rs1 == 0 && (insn & 0x2000) == 0 && (insn & 31) == 0) {
+                        snprintf(buf, len, "%s", alu[op3]);
+                        return;
+                }
+                break;
+        }
+        if (alu[op3] == NULL) {
+                snprintf(buf, len, "unknown opcode: %08x", insn);
+        } else {
+                snprintf(buf, len, "%s %s, %s, %s", alu[op3], reg(rs1), o, reg(rd));
+        }
+}
+
+static void disas(char *buf, size_t len, unsigned int pc, unsigned int insn)
+{
+        unsigned int op2, a = (insn >> 29) & 1, c = (insn >> 25) & 15;
+        int disp;
+
+        switch (insn >> 30) {
+        case 1:
+                snprintf(buf, len, "call 0x%08x", pc + (insn << 2));
+                break;
+        case 0:
+                op2 = (insn >> 22) & 7;
+                disp = ((int)(insn << 10)) >> 8;
+                if (op2 == 4 && (insn & 0x3fffff) == 0 && ((insn >> 25) & 31) == 0) {
+                        snprintf(buf, len, "nop");
+                } else if (op2 == 4) {
+                        snprintf(buf, len, "sethi %%hi(0x%08x), %s", insn << 10,
+                                 reg((insn >> 25) & 31));
+                } else if (op2 == 2) {
+                        snprintf(buf, len, "b%s%s 0x%08x", cond[c], a ? ",a" : "", pc + disp);
+                } else if (op2 == 6) {
+                        snprintf(buf, len, "fb%s%s 0x%08x", fcond[c], a ? ",a" : "", pc + disp);
+                } else if (op2 == 7) {
+                        snprintf(buf, len, "cb%u%s 0x%08x", c, a ? ",a" : "", pc + disp);
+                } else {
+                        snprintf(buf, len, "unimp 0x%x", insn & 0x3fffff);
+                }
+                break;
+        case 2:
+                disas_alu(buf, len, insn);
+                break;
+        default:
+                disas_mem(buf, len, insn);
+                break;
+        }
+}
+
+static int cmp(const void *a, const void *b)
+{
+        const struct ent *x = a, *y = b;
+
+        if (x->t != y->t) {
+                return x->t < y->t ? -1 : 1;
+        }
+        if (x->ahb != y->ahb) {
+                return x->ahb - y->ahb;
+        }
+        return x->seq < y->seq ? -1 : 1;
+}
+
+static void print_ent(struct ent *e)
+{
+        unsigned int *w = e->w, m;
+        char buf[96];
+
+        if (e->ahb) {
+                m = (w[1] >> 3) & 15;
+                printf("%12lld  ahb  mst %2u %s %08x %08x size %u %s %s%s%s\n", e->t, m,
+                       (w[1] >> 15) & 1 ? "write" : "read ", w[3], w[2], 8 << ((w[1] >> 10) & 7),
+                       htrans[(w[1] >> 13) & 3], hresp[w[1] & 3],
+                       (w[1] >> 2) & 1 ? " locked" : "", w[0] >> 31 ? " (breakpoint)" : "");
+                return;
+        }
+        if ((w[0] >> 30) & 1) {
+                /* Further cycle of a multi-cycle instruction */
+                printf("%12lld  %08x  %-40s [%08x]\n", e->t, w[2] & ~3, "", w[1]);
+                return;
+        }
+        disas(buf, sizeof(buf), w[2] & ~3, w[3]);
+        printf("%12lld  %08x  %-40s [%08x]%s%s\n", e->t, w[2] & ~3, buf, w[1],
+               w[2] & 2 ? "  (trapped)" : "", w[2] & 1 ? "  (error mode)" : "");
+}
+
+int main(int argc, char **argv)
+{
+        long long t[2] = { 0, 0 };
+        unsigned int origin = 0, last[2] = { 0, 0 }, head, size, wraps, drains = 0, d;
+        unsigned long count[2] = { 0, 0 }, mst[16][2];
+        int show[2] = { 1, 1 }, first[2] = { 1, 1 }, any = 0, cpu, i, k;
+        char line[256], c;
+        FILE *f = stdin;
+        struct ent e;
+
+        for (i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "-i") == 0) {
+                        show[1] = 0;
+                } else if (strcmp(argv[i], "-a") == 0) {
+                        show[0] = 0;
+                } else if ((f = fopen(argv[i], "r")) == NULL) {
+                        perror(argv[i]);
+                        return 1;
+                }
+        }
+
+        memset(mst, 0, sizeof(mst));
+        while (fgets(line, sizeof(line), f) != NULL) {
+                if (sscanf(line, "dsu3_stream drains %u", &drains) == 1) {
+                        continue;
+                }
+                if (sscanf(line, "dsu3_stream itrace cpu %d head %u size %u wraps %u", &cpu, &head,
+                           &size, &wraps) == 4) {
+                        printf("cpu %d: %u instruction entries, buffer %u, %u wraps\n", cpu, head,
+                               size, wraps);
+                        continue;
+                }
+                if (sscanf(line, "dsu3_stream ahb head %u size %u wraps %u", &head, &size,
+                           &wraps) == 3) {
+                        printf("ahb: %u entries, buffer %u, %u wraps\n", head, size, wraps);
+                        continue;
+                }
+                if (sscanf(line, "%c %x %x %x %x", &c, &e.w[0], &e.w[1], &e.w[2], &e.w[3]) != 5 ||
+                    (c != 'i' && c != 'a')) {
+                        continue;
+                }
+                k = e.ahb = c == 'a';
+                count[k]++;
+                if (k) {
+                        mst[(e.w[1] >> 3) & 15][(e.w[1] >> 15) & 1]++;
+                }
+                /* Time tags of a stream increase, extend them. The streams
+                 * are dumped one after the other, so the first tag of each
+                 * is placed within 2^29 cycles of the first tag seen. */
+                if (!any) {
+                        origin = e.w[0] & TAG_MASK;
+                        any = 1;
+                }
+                if (first[k]) {
+                        d = ((e.w[0] & TAG_MASK) - origin) & TAG_MASK;
+                        t[k] = d & 0x20000000 ? (long long)d - 0x40000000 : d;
+                        first[k] = 0;
+                } else {
+                        t[k] += ((e.w[0] & TAG_MASK) - last[k]) & TAG_MASK;
+                }
+                last[k] = e.w[0] & TAG_MASK;
+                e.t = t[k];
+                e.seq = nent;
+                if (!show[k]) {
+                        continue;
+                }
+                if (nent == maxent) {
+                        maxent = maxent ? 2 * maxent : 4096;
+                        ents = realloc(ents, maxent * sizeof(ents[0]));
+                        if (ents == NULL) {
+                                fprintf(stderr, "out of memory\n");
+                                return 1;
+                        }
+                }
+                ents[nent++] = e;
+        }
+        if (count[0] + count[1] == 0) {
+                fprintf(stderr, "no trace entries found\n");
+                return 1;
+        }
+        printf("%u drains\n", drains);
+        qsort(ents, nent, sizeof(ents[0]), cmp);
+        for (i = 0; i < (int)nent; i++) {
+                print_ent(&ents[i]);
+        }
+        printf("%lu instructions, %lu AHB transfers\n", count[0], count[1]);
+        for (i = 0; i < 16; i++) {
+                if (mst[i][0] || mst[i][1]) {
+                        printf("ahb master %2d: %lu reads, %lu writes\n", i, mst[i][0], mst[i][1]);
+                }
+        }
+        return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Host decoder for perf_region_dump() output
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ * Reads a console log containing a perf_region dump and prints, per CPU
+ * and region id, the number of calls and the time-stamp cycles and
+ * counter events between perf_region_begin() and perf_region_end().
+ * Nested regions are matched with a stack per CPU, so the figures of an
+ * outer region include its inner regions.
+ *
+ * usage: perf_decode [-s] [log]
+ *   -s  subtract the marker overhead from the cycles of each call
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NCNT   16
+#define MAX_DEPTH  64
+#define MAX_REGION 1024
+
+#define PERF_END 0x80000000u
+
+struct rec {
+        unsigned int tag;
+        unsigned long long tsc;
+        unsigned int cnt[MAX_NCNT];
+};
+
+struct region {
+        int cpu;
+        unsigned int id;
+        unsigned long calls;
+        unsigned long long cycles;
+        unsigned long long min;
+        unsigned long long max;
+        unsigned long long cnt[MAX_NCNT];
+};
+
+static const struct {
+        unsigned int ev;
+        const char *name;
+} names[] = {
+        { 0x00, "icmiss" }, { 0x01, "itmiss" }, { 0x02, "ichold" }, { 0x03, "ithold" },
+        { 0x08, "dcmiss" }, { 0x09, "dtmiss" }, { 0x0A, "dchold" }, { 0x0B, "dthold" },
+        { 0x10, "wbhold" }, { 0x11, "ainst" }, { 0x12, "iinst" }, { 0x13, "finst" },
+        { 0x14, "bpmiss" }, { 0x15, "time" }, { 0x17, "ahbutil" }, { 0x18, "ahbtutil" },
+        { 0x22, "branch" }, { 0x38, "ldst" }, { 0x39, "load" }, { 0x3A, "store" },
+};
+
+static struct region regions[MAX_REGION];
+static int nregion;
+static unsigned int events[MAX_NCNT];
+static int ncnt;
+static struct rec stack[MAX_DEPTH];
+static int depth;
+static unsigned long unmatched;
+static unsigned long lost;
+
+static const char *evname(unsigned int ev)
+{
+        static char buf[8];
+        unsigned int i;
+
+        for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+                if (names[i].ev == ev) {
+                        return names[i].name;
+                }
+        }
+        snprintf(buf, sizeof(buf), "ev%02x", ev);
+        return buf;
+}
+
+static struct region *lookup(int cpu, unsigned int id)
+{
+        struct region *r;
+        int i;
+
+        for (i = 0; i < nregion; i++) {
+                if (regions[i].cpu == cpu && regions[i].id == id) {
+                        return &regions[i];
+                }
+        }
+        if (nregion == MAX_REGION) {
+                fprintf(stderr, "too many regions\n");
+                exit(1);
+        }
+        r = &regions[nregion++];
+        memset(r, 0, sizeof(*r));
+        r->cpu = cpu;
+        r->id = id;
+        r->min = ~0ULL;
+        return r;
+}
+
+static void end(int cpu, struct rec *e, unsigned int overhead)
+{
+        unsigned int id = e->tag & ~PERF_END;
+        unsigned long long cycles;
+        struct region *r;
+        struct rec *b;
+        int i;
+
+        for (i = depth - 1; i >= 0 && stack[i].tag != id; i--);
+        if (i < 0) {
+                /* Begin lost with the start of the ring */
+                unmatched++;
+                return;
+        }
+        unmatched += depth - 1 - i;
+        depth = i;
+        b = &stack[i];
+        cycles = e->tsc - b->tsc;
+        cycles = cycles > overhead ? cycles - overhead : 0;
+        r = lookup(cpu, id);
+        r->calls++;
+        r->cycles += cycles;
+        if (cycles < r->min) {
+                r->min = cycles;
+        }
+        if (cycles > r->max) {
+                r->max = cycles;
+        }
+        for (i = 0; i < ncnt; i++) {
+                /* Counters are 32 bits and may wrap once within a region */
+                r->cnt[i] += (unsigned int)(e->cnt[i] - b->cnt[i]);
+        }
+}
+
+static int cmp(const void *a, const void *b)
+{
+        const struct region *x = a, *y = b;
+
+        if (x->cpu != y->cpu) {
+                return x->cpu - y->cpu;
+        }
+        return x->cycles < y->cycles ? 1 : x->cycles > y->cycles ? -1 : 0;
+}
+
+static void report(void)
+{
+        struct region *r;
+        int i, j, ainst = -1;
+
+        qsort(regions, nregion, sizeof(regions[0]), cmp);
+        for (i = 0; i < ncnt; i++) {
+                if (events[i] == 0x11) {
+                        ainst = i;
+                }
+        }
+        printf("%3s %8s %8s %14s %10s %10s %10s", "cpu", "region", "calls", "cycles",
+               "avg", "min", "max");
+        for (i = 0; i < ncnt; i++) {
+                printf(" %12s", evname(events[i]));
+        }
+        printf(ainst >= 0 ? " %6s\n" : "\n", "IPC");
+        for (j = 0; j < nregion; j++) {
+                r = &regions[j];
+                printf("%3d %8x %8lu %14llu %10llu %10llu %10llu", r->cpu, r->id, r->calls,
+                       r->cycles, r->cycles / r->calls, r->min, r->max);
+                for (i = 0; i < ncnt; i++) {
+                        printf(" %12llu", r->cnt[i]);
+                }
+                if (ainst >= 0) {
+                        printf(" %6.3f", r->cycles ? (double)r->cnt[ainst] / r->cycles : 0.0);
+                }
+                printf("\n");
+        }
+        if (unmatched) {
+                printf("%lu markers without a matching begin or end\n", unmatched);
+        }
+        if (lost) {
+                printf("%lu records overwritten in the rings\n", lost);
+        }
+}
+
+int main(int argc, char **argv)
+{
+        unsigned int overhead = 0, head, n, v[3 + MAX_NCNT];
+        int subtract = 0, cpu = -1, i, pos, len;
+        char line[512], *p;
+        FILE *f = stdin;
+        struct rec r;
+
+        for (i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "-s") == 0) {
+                        subtract = 1;
+                } else if ((f = fopen(argv[i], "r")) == NULL) {
+                        perror(argv[i]);
+                        return 1;
+                }
+        }
+
+        while (fgets(line, sizeof(line), f) != NULL) {
+                if (sscanf(line, "perf_region overhead %u", &overhead) == 1) {
+                        continue;
+                }
+                if (sscanf(line, "perf_region cpu %d head %u ncnt %d events%n", &cpu, &head, &ncnt,
+                           &pos) == 3) {
+                        if (ncnt > MAX_NCNT) {
+                                fprintf(stderr, "too many counters\n");
+                                return 1;
+                        }
+                        /* The ring holds the last of head records, lost is
+                         * decremented for each record read */
+                        lost += head;
+                        p = line + pos;
+                        for (i = 0; i < ncnt && sscanf(p, "%x%n", &events[i], &len) == 1; i++) {
+                                p += len;
+                        }
+                        depth = 0;
+                        continue;
+                }
+                if (cpu < 0 || line[0] != 'r' || line[1] != ' ') {
+                        continue;
+                }
+                /* tag, time-stamp high and low, counters */
+                p = line + 1;
+                for (n = 0; n < 3 + (unsigned int)ncnt; n++) {
+                        if (sscanf(p, "%x%n", &v[n], &len) != 1) {
+                                break;
+                        }
+                        p += len;
+                }
+                if (n != 3 + (unsigned int)ncnt) {
+                        continue;
+                }
+                lost--;
+                r.tag = v[0];
+                r.tsc = ((unsigned long long)v[1] << 32) | v[2];
+                memcpy(r.cnt, &v[3], ncnt * sizeof(r.cnt[0]));
+                if (r.tag & PERF_END) {
+                        end(cpu, &r, subtract ? overhead : 0);
+                } else if (depth < MAX_DEPTH) {
+                        stack[depth++] = r;
+                } else {
+                        unmatched++;
+                }
+        }
+        if (nregion == 0) {
+                fprintf(stderr, "no regions found\n");
+                return 1;
+        }
+        printf("marker overhead %u cycles%s\n", overhead, subtract ? " (subtracted)" : "");
+        report();
+        return 0;
+}
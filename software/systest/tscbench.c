@@ -0,0 +1,282 @@
+/*
+ * Micro-benchmarks timed with the time-stamp counter
+ *
+ * Copyright (c) 2026 Cobham Gaisler AB
+ *
+ */
+
+#include <string.h>
+#include "report.h"
+#include "tscbench.h"
+
+#define TSCB_BUF   (128*1024)
+#define TSCB_LOADS 4096
+#define TSCB_WARMUP 2
+#define TSCB_REPS  15
+
+/* Operands the compiler cannot fold */
+static volatile unsigned int tscb_mulc = 2654435761u;
+static volatile unsigned int tscb_divc = 7;
+static const double tscb_fop[2] = { 1.5, 0.999999 };
+static volatile unsigned int tscb_sink;
+
+static unsigned char tscb_buf[TSCB_BUF] __attribute__ ((aligned (64)));
+
+/* Time tag bits below 32, and the software extension above them */
+static unsigned int tsc_mask = ~0;
+static unsigned int tsc_last;
+static unsigned int tsc_wraps;
+static unsigned int tsc_overhead;
+
+#if !defined(__riscv)
+extern int xgetpsr(void);
+extern void setpsr(int psr);
+
+#define PSR_EF (1 << 12)
+
+/* C code built with -msoft-float never holds the FPU registers */
+#ifdef _SOFT_FLOAT
+#define TSCB_FCLOBBER "memory"
+#else
+#define TSCB_FCLOBBER "f0", "f1", "f2", "f3", "memory"
+#endif
+#endif
+
+void tsc_init(unsigned int dsu_addr)
+{
+        unsigned long long t0, t1;
+        int i;
+
+#if !defined(__riscv)
+        volatile unsigned int *dsu = (unsigned int *)dsu_addr;
+        unsigned int tmp = ~(1U << 31);
+
+        asm volatile("mov %0, %%asr22; nop; nop; nop " : : "r"(tmp));
+        if (dsu_addr) {
+                /* dsu[2] = DSU time tag counter, unimplemented bits read
+                 * 0. The low half keeps the counter from wrapping before it
+                 * is read back. */
+                dsu[2] = 0xffff0000;
+                tsc_mask = dsu[2] | 0xffff;
+                dsu[2] = 0;
+        }
+#else
+        (void)dsu_addr;
+#endif
+        tsc_last = 0;
+        tsc_wraps = 0;
+        tsc_overhead = ~0;
+        for (i = 0; i < 16; i++) {
+                t0 = tsc_read();
+                t1 = tsc_read();
+                if (t1 - t0 < tsc_overhead) {
+                        tsc_overhead = t1 - t0;
+                }
+        }
+}
+
+unsigned long long tsc_read(void)
+{
+#if defined(__riscv) && __riscv_xlen == 64
+        unsigned long long t;
+
+        asm volatile("rdcycle %0" : "=r"(t));
+        return t;
+#else
+        unsigned int h, hi, lo;
+
+        do {
+#if defined(__riscv)
+                asm volatile("rdcycleh %0" : "=r"(h));
+                asm volatile("rdcycle %0" : "=r"(lo));
+                asm volatile("rdcycleh %0" : "=r"(hi));
+#else
+                asm volatile("mov %%asr22, %0" : "=r"(h));
+                asm volatile("mov %%asr23, %0" : "=r"(lo));
+                asm volatile("mov %%asr22, %0" : "=r"(hi));
+#endif
+        } while (h != hi);
+        if (tsc_mask != ~0U) {
+                /* The time tag is narrower than 32 bits */
+                lo &= tsc_mask;
+                if (lo < tsc_last) {
+                        tsc_wraps++;
+                }
+                tsc_last = lo;
+                return (unsigned long long)tsc_wraps * ((unsigned long long)tsc_mask + 1) + lo;
+        }
+#if !defined(__riscv)
+        hi &= ~(1U << 31);
+#endif
+        return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static unsigned int k_memcpy(unsigned int len)
+{
+        memcpy(tscb_buf + TSCB_BUF / 2, tscb_buf, len);
+        return tscb_buf[TSCB_BUF / 2 + len - 1];
+}
+
+static unsigned int k_mul(unsigned int n)
+{
+        unsigned int x = 3, m = tscb_mulc, i;
+
+        for (i = 0; i < n; i++) {
+#if defined(__riscv)
+                x = x * m;
+#else
+                asm volatile("umul %1, %2, %0" : "=r"(x) : "r"(x), "r"(m));
+#endif
+        }
+        return x;
+}
+
+static unsigned int k_div(unsigned int n)
+{
+        unsigned int x = ~0, d = tscb_divc, i;
+
+#if !defined(__riscv)
+        asm volatile("wr %%g0, %%y; nop; nop; nop" : : : "memory");
+#endif
+        for (i = 0; i < n; i++) {
+#if defined(__riscv)
+                x = x / d;
+#else
+                asm volatile("udiv %1, %2, %0" : "=r"(x) : "r"(x), "r"(d));
+#endif
+                x ^= 0xdeadbeef;
+        }
+        return x;
+}
+
+/* Dependent chains of one FPU operation, as exercised by grfpu_test */
+#if !defined(__riscv)
+#define TSCB_FOP(fn, op)                                                \
+static unsigned int fn(unsigned int n)                                  \
+{                                                                       \
+        asm volatile("ldd [%1], %%f0\n\t"                               \
+                     "ldd [%1+8], %%f2\n"                               \
+                     "1:\n\t"                                           \
+                     op "\n\t"                                          \
+                     "subcc %0, 1, %0\n\t"                              \
+                     "bne 1b\n\t"                                       \
+                     " nop"                                             \
+                     : "+r"(n) : "r"(tscb_fop) : TSCB_FCLOBBER, "cc");  \
+        return n;                                                       \
+}
+TSCB_FOP(k_faddd, "faddd %%f0, %%f2, %%f0")
+TSCB_FOP(k_fmuld, "fmuld %%f0, %%f2, %%f0")
+TSCB_FOP(k_fdivd, "fdivd %%f0, %%f2, %%f0")
+TSCB_FOP(k_fsqrtd, "fsqrtd %%f0, %%f0")
+#define TSCB_HAS_FPU
+#elif defined(__riscv_flen) && __riscv_flen >= 64
+#define TSCB_FOP(fn, op)                                                \
+static unsigned int fn(unsigned int n)                                  \
+{                                                                       \
+        asm volatile("fld ft0, 0(%1)\n\t"                               \
+                     "fld ft1, 8(%1)\n"                                 \
+                     "1:\n\t"                                           \
+                     op "\n\t"                                          \
+                     "addi %0, %0, -1\n\t"                              \
+                     "bnez %0, 1b"                                      \
+                     : "+r"(n) : "r"(tscb_fop) : "ft0", "ft1", "memory"); \
+        return n;                                                       \
+}
+TSCB_FOP(k_faddd, "fadd.d ft0, ft0, ft1")
+TSCB_FOP(k_fmuld, "fmul.d ft0, ft0, ft1")
+TSCB_FOP(k_fdivd, "fdiv.d ft0, ft0, ft1")
+TSCB_FOP(k_fsqrtd, "fsqrt.d ft0, ft0")
+#define TSCB_HAS_FPU
+#endif
+
+/* TSCB_LOADS loads, stride bytes apart, wrapping within the buffer */
+static unsigned int k_stride(unsigned int stride)
+{
+        unsigned int i, off = 0, sum = 0;
+
+        for (i = 0; i < TSCB_LOADS; i++) {
+                sum += *(volatile unsigned int *)(tscb_buf + off);
+                off = (off + stride) & (TSCB_BUF - 1);
+        }
+        return sum;
+}
+
+const struct tscb_kernel tscb_kernels[] = {
+        { "memcpy 64",        k_memcpy, 64, 0 },
+        { "memcpy 1k",        k_memcpy, 1024, 0 },
+        { "memcpy 16k",       k_memcpy, 16*1024, 0 },
+        { "memcpy 64k",       k_memcpy, 64*1024, 0 },
+        { "umul x256",        k_mul, 256, 0 },
+        { "udiv x256",        k_div, 256, 0 },
+#ifdef TSCB_HAS_FPU
+        { "faddd x256",       k_faddd, 256, TSCB_FPU },
+        { "fmuld x256",       k_fmuld, 256, TSCB_FPU },
+        { "fdivd x256",       k_fdivd, 256, TSCB_FPU },
+        { "fsqrtd x256",      k_fsqrtd, 256, TSCB_FPU },
+#endif
+        { "load x4k stride 4",  k_stride, 4, 0 },
+        { "load x4k stride 16", k_stride, 16, 0 },
+        { "load x4k stride 32", k_stride, 32, 0 },
+        { "load x4k stride 64", k_stride, 64, 0 },
+};
+
+const int tscb_nkernels = sizeof(tscb_kernels) / sizeof(tscb_kernels[0]);
+
+int tscb_measure(const struct tscb_kernel *k, int warmup, int reps, struct tscb_result *r)
+{
+        unsigned int s[TSCB_MAX_REPS], t;
+        unsigned long long t0;
+        int i, j;
+
+        if (reps < 1 || reps > TSCB_MAX_REPS) {
+                return -1;
+        }
+        for (i = 0; i < warmup; i++) {
+                tscb_sink = k->run(k->arg);
+        }
+        for (i = 0; i < reps; i++) {
+                t0 = tsc_read();
+                tscb_sink = k->run(k->arg);
+                t = tsc_read() - t0;
+                t = t > tsc_overhead ? t - tsc_overhead : 0;
+                /* Insertion into the sorted samples */
+                for (j = i; j > 0 && s[j - 1] > t; j--) {
+                        s[j] = s[j - 1];
+                }
+                s[j] = t;
+        }
+        r->min = s[0];
+        r->median = s[reps / 2];
+        return 0;
+}
+
+static int tscb_fpu(void)
+{
+#if !defined(__riscv)
+        setpsr(xgetpsr() | PSR_EF);
+        return (xgetpsr() & PSR_EF) != 0;
+#else
+        return 1;
+#endif
+}
+
+int tsc_bench(unsigned int dsu_addr)
+{
+        struct tscb_result r;
+        int i, fpu;
+
+        tsc_init(dsu_addr);
+        fpu = tscb_fpu();
+        for (i = 0; i < TSCB_BUF; i++) {
+                tscb_buf[i] = i;
+        }
+        for (i = 0; i < tscb_nkernels; i++) {
+                if ((tscb_kernels[i].flags & TSCB_FPU) && !fpu) {
+                        continue;
+                }
+                tscb_measure(&tscb_kernels[i], TSCB_WARMUP, TSCB_REPS, &r);
+                report_bench(i, tscb_kernels[i].name, r.min, r.median);
+        }
+        return 0;
+}